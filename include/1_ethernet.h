@@ -1,13 +1,43 @@
 #ifndef ETHERNET
 #define ETHERNET
 
+#include "../include/2_arp.h"
+#include "../include/2_ip.h"
+#include "../include/2_ipv6.h"
 #include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/tunnel.h"
+
+// Network protocols decoded or labelled, slot 0 is the unknown one
+#define ETHER_UNKNOWN 0
+#define ETHER_IP 1
+#define ETHER_IPV6 2
+#define ETHER_ARP 3
+#define ETHER_REVARP 4
+#define ETHER_PUP 5
+#define ETHER_SPRITE 6
+#define ETHER_AT 7
+#define ETHER_AARP 8
+#define ETHER_VLAN 9
+#define ETHER_IPX 10
+#define ETHER_LOOPBACK 11
+#define ETHER_QINQ 12
+#define ETHER_MPLS 13
+#define ETHER_PPP 14
+#define ETHER_MAX 15
 
 char *addr_mac_print(const struct ether_addr *addr, char *buf);
 
-void add_mac_print_lvl1(struct ether_header *eth_header);
+void add_mac_print_lvl1(const packet_t *pkt);
+
+void ethernet_decode(packet_t *pkt, const u_char *packet);
+
+void ethernet_print(const packet_t *pkt, int verbose);
+
+void ethernet_analyzer(packet_t *pkt, const u_char *packet,
+                       int verbose);
 
-struct ether_header *ethernet_analyzer(const u_char *packet,
-                                       int verbose);
+void get_protocol_ethernet(packet_t *pkt, const u_char *packet,
+                           int length, int verbose);
 
-#endif
\ No newline at end of file
+#endif
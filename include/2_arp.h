@@ -3,7 +3,11 @@
 
 #include "../include/1_ethernet.h"
 #include "../include/include.h"
+#include "../include/packet.h"
 
 void arp_analyzer(const u_char *packet, int verbose);
 
+void arp_dissect(packet_t *pkt, const u_char *packet, int length,
+                 int verbose);
+
 #endif
\ No newline at end of file
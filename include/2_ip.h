@@ -6,11 +6,23 @@
 #include "../include/3_sctp.h"
 #include "../include/3_tcp.h"
 #include "../include/3_udp.h"
+#include "../include/frag.h"
 #include "../include/include.h"
+#include "../include/packet.h"
 
-struct iphdr *ip_analyzer(const u_char *packet, int verbose);
+void ip_decode(packet_t *pkt, const u_char *packet);
 
-void get_protocol_ip(const u_char *packet, struct iphdr *ip_header,
-                     int length, int verbose);
+void ip_print(const packet_t *pkt, int verbose);
+
+void ip_analyzer(packet_t *pkt, const u_char *packet, int verbose);
+
+const u_char *ip_payload(packet_t *pkt, const u_char *packet,
+                         int *length);
+
+void get_protocol_ip(packet_t *pkt, const u_char *packet, int length,
+                     int verbose);
+
+void ip_dissect(packet_t *pkt, const u_char *packet, int length,
+                int verbose);
 
 #endif
\ No newline at end of file
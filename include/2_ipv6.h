@@ -4,12 +4,28 @@
 #include "../include/3_sctp.h"
 #include "../include/3_tcp.h"
 #include "../include/3_udp.h"
+#include "../include/frag.h"
 #include "../include/include.h"
+#include "../include/packet.h"
 
-struct ip6_hdr *ipv6_analyzer(const u_char *packet, int verbose);
+// Extension headers walked before the upper-layer protocol
+#define IPV6_MAX_HEADERS 8
 
-void get_protocol_ipv6(const u_char *packet,
-                       struct ip6_hdr *ipv6_header, int length,
-                       int verbose);
+void ipv6_decode(packet_t *pkt, const u_char *packet);
+
+void ipv6_print(const packet_t *pkt, int verbose);
+
+void ipv6_analyzer(packet_t *pkt, const u_char *packet, int verbose);
+
+int ipv6_walk(packet_t *pkt, const u_char *packet, int length);
+
+const u_char *ipv6_payload(packet_t *pkt, const u_char *packet,
+                           int *length, int verbose);
+
+void get_protocol_ipv6(packet_t *pkt, const u_char *packet,
+                       int length, int verbose);
+
+void ipv6_dissect(packet_t *pkt, const u_char *packet, int length,
+                  int verbose);
 
 #endif
\ No newline at end of file
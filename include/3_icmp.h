@@ -2,6 +2,7 @@
 #define ICMP
 
 #include "../include/2_ip.h"
+#include "../include/context.h"
 #include "../include/include.h"
 
 // ICMP types
@@ -65,6 +66,7 @@ struct icmp_packet {
     uint8_t data[ICMP_MAX_DATA_SIZE];
 };
 
-void icmp_analyzer(const u_char *packet, int length, int verbose);
+void icmp_analyzer(packet_t *pkt, const u_char *packet, int length,
+                   int verbose);
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define SCTP
 
 #include "../include/include.h"
+#include "../include/packet.h"
 
 // Chunk type
 #define DATA 0
@@ -60,4 +61,7 @@ void sctp_analyzer(const u_char *packet, int length, int verbose);
 void sctp_chunk_analyzer(const u_char *packet, int nb_chunks,
                          int length, int verbose);
 
+void sctp_dissect(packet_t *pkt, const u_char *packet, int length,
+                  int verbose);
+
 #endif
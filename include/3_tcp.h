@@ -9,13 +9,29 @@
 #include "../include/4_pop3.h"
 #include "../include/4_smtp.h"
 #include "../include/4_telnet.h"
+#include "../include/context.h"
+#include "../include/flow.h"
 #include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/registry.h"
+#include "../include/stream.h"
 
-struct tcphdr *tcp_analyzer(const u_char *packet, int length,
-                            int verbose);
+void tcp_decode(packet_t *pkt, const u_char *packet);
 
-void get_protocol_tcp(const u_char *packet, struct tcphdr *tcp_header,
-                      int length, int verbose);
+void tcp_print(const packet_t *pkt, int verbose);
+
+void tcp_analyzer(packet_t *pkt, const u_char *packet, int length,
+                  int verbose);
+
+uint8_t tcp_app(const packet_t *pkt);
+
+void tcp_classify(packet_t *pkt, const u_char *packet, int length);
+
+void get_protocol_tcp(packet_t *pkt, const u_char *packet, int length,
+                      int verbose);
+
+void tcp_dissect(packet_t *pkt, const u_char *packet, int length,
+                 int verbose);
 
 void tcp_flags(uint8_t flags, int verbose);
 
@@ -9,12 +9,26 @@
 #include "../include/4_pop3.h"
 #include "../include/4_smtp.h"
 #include "../include/4_telnet.h"
+#include "../include/context.h"
+#include "../include/flow.h"
 #include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/registry.h"
+#include "../include/resolver.h"
 
-struct udphdr *udp_analyzer(const u_char *packet, int length,
-                            int verbose);
+void udp_decode(packet_t *pkt, const u_char *packet);
 
-void get_protocol_udp(const u_char *packet, struct udphdr *udp_header,
-                      int length, int verbose);
+void udp_print(const packet_t *pkt, int verbose);
+
+void udp_analyzer(packet_t *pkt, const u_char *packet, int length,
+                  int verbose);
+
+uint8_t udp_app(const packet_t *pkt);
+
+void get_protocol_udp(packet_t *pkt, const u_char *packet, int length,
+                      int verbose);
+
+void udp_dissect(packet_t *pkt, const u_char *packet, int length,
+                 int verbose);
 
 #endif
\ No newline at end of file
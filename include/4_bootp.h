@@ -3,16 +3,72 @@
 
 #include "../include/include.h"
 
+// Options by tag in the table
+#define DHCP_TAGS 256
+
+// How the value of an option is decoded and printed
+#define DHCP_HEX 0
+#define DHCP_ADDR 1
+#define DHCP_NAME 2
+#define DHCP_U8 3
+#define DHCP_U16 4
+#define DHCP_U32 5
+#define DHCP_S32 6
+#define DHCP_MESSAGE 7
+#define DHCP_REQUEST 8
+#define DHCP_AGENT 9
+#define DHCP_AUTH 10
+#define DHCP_SIP 11
+#define DHCP_CLIENT 12
+// shorter than its type, not decoded
+#define DHCP_SHORT 13
+
+// Sub-options of the relay agent information
+#define DHCP_AGENT_CIRCUIT 1
+#define DHCP_AGENT_REMOTE 2
+
+/*
+ * Option known: its name, how its value is decoded and the length
+ * the value has at least
+ */
+typedef struct dhcp_desc_t {
+    const char *name;
+    uint8_t type;
+    uint8_t min;
+} dhcp_desc_t;
+
+/*
+ * Option decoded, its value is read in the message and the integers
+ * are in value
+ */
+typedef struct dhcp_option_t {
+    uint8_t tag;
+    uint8_t type;
+    uint8_t len;
+    uint32_t value;
+    const u_char *data;
+} dhcp_option_t;
+
 void bootp_analyzer(const u_char *packet, int length, int verbose);
 
-void print_dhcp_option_addr(const u_char *bp_vend, int i, int length);
-void print_dhcp_option_name(const u_char *bp_vend, int i, int length);
-void print_dhcp_option_int(const u_char *bp_vend, int i, int length);
+int dhcp_cookie(const u_char *bp_vend, int length);
+
+int dhcp_option_next(const u_char *options, int length, int *offset,
+                     dhcp_option_t *option);
+
+void print_dhcp_option_addr(const u_char *data, int len);
+void print_dhcp_option_name(const u_char *data, int len);
+void print_dhcp_option_hex(const u_char *data, int len);
+
+void dhcp_option_print(const dhcp_option_t *option, int verbose);
 
 void bootp_vendor_specific(const u_char *bp_vend, int length,
                            int verbose);
 
-void parameter_request_list_print(const u_char *bp_vend, int start,
-                                  int verbose);
+void parameter_request_list_print(const u_char *data, int len);
+
+void dhcp_agent_print(const u_char *data, int len);
+
+void dhcp_auth_print(const u_char *data);
 
-#endif
\ No newline at end of file
+#endif
@@ -2,11 +2,29 @@
 #define DNS
 
 #include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/resolver.h"
+#include "../include/stream.h"
 #include <string.h>
 
 #define DNS_TCP 0
 #define DNS_UDP 1
 
+// Flags of the header
+#define DNS_RESPONSE 0x8000
+#define DNS_OPCODE 0x7800
+#define DNS_RCODE 0x000f
+
+// Longest name, dots included, and its labels
+#define DNS_NAME_MAX 255
+#define DNS_LABELS 128
+// Compression pointer, the 14 other bits are an offset in the message
+#define DNS_POINTER 0xc0
+// Names decoded by message before the arena starts over
+#define DNS_ARENA 8192
+// Offsets of the names remembered, a power of 2
+#define DNS_MEMO 256
+
 struct dns_hdr {
     u_int16_t id;
     u_int16_t flags;
@@ -16,20 +34,54 @@ struct dns_hdr {
     u_int16_t arcount;
 };
 
-void dns_analyzer(const u_char *packet, int transport, int lenght,
-                  int verbose);
+// Name decoded from an offset of the message, in the arena
+typedef struct dns_memo_t {
+    uint16_t offset;
+    uint16_t name;
+    uint16_t length;
+} dns_memo_t;
+
+/*
+ * Names of a message. Every offset a name is decoded from is
+ * remembered with the suffix of the name starting there, a pointer
+ * to it is then copied from the arena instead of being followed
+ * again.
+ */
+typedef struct dns_names_t {
+    const u_char *packet;
+    int length;
+    int used;
+    dns_memo_t memo[DNS_MEMO];
+    char arena[DNS_ARENA];
+} dns_names_t;
+
+void dns_analyzer(const u_char *packet, int length, int verbose);
 
-int query_parsing(const u_char *packet, int offset, int length,
-                  int verbose);
-int response_parsing(const u_char *packet, int offset, int length,
+void dns_stream(packet_t *pkt, const u_char *packet, int length,
+                int verbose);
+
+int dns_frame(packet_t *pkt, streams_t *streams, stream_t *stream,
+              const u_char *packet, int length, int verbose);
+
+void dns_tcp_message(packet_t *pkt, const u_char *packet, int length,
                      int verbose);
-void data_reader(uint16_t type, const u_char *packet, int offset,
-                 uint16_t rdlength, int length, int verbose);
 
-int domain_name_print(const u_char *packet, int i, int length,
-                      int verbose);
-int name_print(const u_char *packet, int i, int length, int verbose);
+void dns_message(const u_char *packet, int transport, int length,
+                 int verbose);
+
+int query_parsing(dns_names_t *names, int offset, int verbose);
+int response_parsing(dns_names_t *names, int offset, int verbose);
+void data_reader(dns_names_t *names, uint16_t type, int offset,
+                 int end, int verbose);
+
+void dns_names_init(dns_names_t *names, const u_char *packet,
+                    int length);
+const dns_memo_t *dns_memo_find(const dns_names_t *names,
+                                int offset);
+int dns_name_skip(const dns_names_t *names, int offset);
+int dns_name(dns_names_t *names, int offset, const char **name);
+int domain_name_print(dns_names_t *names, int offset, int verbose);
 void type_print(u_int16_t type, int verbose);
 void class_print(u_int16_t class, int verbose);
 
-#endif
\ No newline at end of file
+#endif
@@ -5,4 +5,6 @@
 
 int ftp_analyzer(const u_char *packet, int length, int verbose);
 
+int ftp_data_port(const u_char *packet, int length);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef BATCH
+#define BATCH
+
+#include "../include/flow.h"
+#include "../include/include.h"
+#include "../include/reader.h"
+
+// Frames collected before they are decoded
+#define BATCH_SIZE 32
+// Frames ahead of the one decoded at each stage: its headers are
+// loaded, then its flow hashed and the tags of the slot loaded, then
+// the flows whose tag matches
+#define BATCH_HEADERS 8
+#define BATCH_TAGS 4
+#define BATCH_FLOWS 2
+// Flows in the table from which their slots are loaded ahead, the
+// slots of a smaller table stay in the cache
+#define BATCH_FLOWS_MIN (1 << 14)
+// Bytes of headers loaded by frame, Ethernet, IP and transport
+#define BATCH_LINES 2
+#define BATCH_LINE 64
+
+/*
+ * Frames read from memory which stays valid until the batch is
+ * decoded, the mapped file or a block of the ring. They are decoded
+ * in stages: while a frame is decoded, the headers and the flow slots
+ * of the next ones are loaded in the cache.
+ */
+typedef struct batch_t {
+
+    // flow table of the decoders, NULL if none
+    flow_table_t *flows;
+    int nb;
+    struct pcap_pkthdr headers[BATCH_SIZE];
+    const u_char *packets[BATCH_SIZE];
+    // hash of the flow of each frame, if hinted
+    uint64_t hashes[BATCH_SIZE];
+    uint8_t hinted[BATCH_SIZE];
+} batch_t;
+
+void batch_open(batch_t *batch, flow_table_t *flows);
+
+int batch_add(batch_t *batch, const struct pcap_pkthdr *header,
+              const u_char *packet);
+
+void batch_headers(const batch_t *batch, int i);
+
+void batch_tags(batch_t *batch, int i);
+
+void batch_flows(const batch_t *batch, int i);
+
+void batch_run(batch_t *batch, pcap_handler callback, u_char *args);
+
+int batch_loop(reader_t *reader, flow_table_t *flows,
+               pcap_handler callback, u_char *args);
+
+#endif
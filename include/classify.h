@@ -0,0 +1,22 @@
+#ifndef CLASSIFY
+#define CLASSIFY
+
+#include "../include/1_ethernet.h"
+#include "../include/2_ip.h"
+#include "../include/2_ipv6.h"
+#include "../include/3_tcp.h"
+#include "../include/3_udp.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/tunnel.h"
+
+void classify_transport(packet_t *pkt, const u_char *packet,
+                        int length);
+
+void classify_ip(packet_t *pkt, const u_char *packet, int length);
+
+void classify_ipv6(packet_t *pkt, const u_char *packet, int length);
+
+void classify_packet(packet_t *pkt, const u_char *packet, int length);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef CONTEXT
+#define CONTEXT
+
+#include "../include/dump.h"
+#include "../include/include.h"
+#include "../include/output.h"
+#include "../include/packet.h"
+#include "../include/registry.h"
+
+// Everything a frame is analyzed with, one by thread so that the
+// layers share no global state. The tables are known by their tag
+// since their headers include this one.
+
+typedef struct context_t {
+
+    int verbose;
+    // frame number
+    unsigned long count;
+    unsigned long bytes;
+    // counters of the kernel, online only
+    unsigned long received;
+    unsigned long dropped;
+    // frames by protocol, counted at verbose level 0
+    unsigned long ipv4;
+    unsigned long ipv6;
+    unsigned long arp;
+    unsigned long tcp;
+    unsigned long udp;
+    unsigned long icmp;
+    unsigned long apps[APP_MAX];
+    // flows added to the table, and the ones not tracked once full
+    unsigned long flow_count;
+    unsigned long flow_untracked;
+    // TCP and UDP flows of the thread, NULL if none are tracked
+    struct flow_table_t *flows;
+    // TCP reassembly of these flows, NULL if none
+    struct streams_t *streams;
+    // datagrams reassembled from their fragments, and the ones lost
+    unsigned long frag_count;
+    unsigned long frag_lost;
+    // IP fragments of the thread, NULL if they are not reassembled
+    struct frags_t *frags;
+    // DNS transactions of the thread, NULL if they are not matched
+    struct resolvers_t *resolvers;
+    // application of each port, from the options
+    const registry_t *registry;
+    // tunnels peeled at most in front of the network protocol
+    int tunnel_max;
+    // frames kept in a capture file, NULL if none
+    dump_t *dump;
+    // text of the frames analyzed, selected by the thread
+    output_t *output;
+} context_t;
+
+void init_context(context_t *ctx, int verbose);
+
+void merge_context(context_t *dst, const context_t *src);
+
+void close_flows(context_t *ctx);
+
+void close_frags(context_t *ctx);
+
+void close_resolvers(context_t *ctx);
+
+void count_protocols(context_t *ctx, const packet_t *pkt);
+
+void print_context(const context_t *ctx, const char *name);
+
+void print_summary(const context_t *ctx);
+
+#endif
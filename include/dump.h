@@ -0,0 +1,45 @@
+#ifndef DUMP
+#define DUMP
+
+#include "../include/reader.h"
+#include <sys/uio.h>
+
+// Frames written by one writev, two pieces each within IOV_MAX
+#define DUMP_BATCH 512
+// Buffer of the stream given to libpcap
+#define DUMP_BUFFER (1 << 22)
+#define DUMP_LINKTYPE 1
+
+/*
+ * Frames kept in a capture file. The record headers are built in the
+ * batch, the frames themselves are only pointed to where they were
+ * captured, so the batch must be flushed before that memory is given
+ * back. Several batches can share one file, opened in append mode.
+ */
+typedef struct dump_t {
+
+    int fd;
+    int nb;
+    // frames read by libpcap are copied by its own writer instead
+    pcap_dumper_t *dumper;
+    char *buffer;
+    struct pcap_record_hdr hdrs[DUMP_BATCH];
+    struct iovec iov[2 * DUMP_BATCH];
+} dump_t;
+
+int dump_open(dump_t *dump, const char *file, uint32_t snaplen);
+
+int dump_open_pcap(dump_t *dump, pcap_t *handle, const char *file);
+
+void dump_share(dump_t *dump, int fd);
+
+int dump_flush(dump_t *dump);
+
+void dump_packet(dump_t *dump, const struct pcap_pkthdr *header,
+                 const u_char *packet);
+
+int dump_append(dump_t *dump, FILE *file);
+
+int dump_close(dump_t *dump);
+
+#endif
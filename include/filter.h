@@ -0,0 +1,65 @@
+#ifndef FILTER
+#define FILTER
+
+#include "../include/include.h"
+#include <arpa/inet.h>
+
+// Primitives joined by "and" evaluated without the bpf program
+#define FILTER_MAX_TERMS 8
+
+// Kind of a primitive
+#define FILTER_ETHER 0
+#define FILTER_PROTO 1
+#define FILTER_PORT 2
+#define FILTER_HOST 3
+
+// Direction of a port or a host
+#define FILTER_ANY 0
+#define FILTER_SRC 1
+#define FILTER_DST 2
+
+/*
+ * One primitive of the expression, tested on the bytes of the frame
+ * exactly as the bpf program generated by libpcap would.
+ */
+typedef struct filter_term_t {
+
+    uint8_t kind;
+    uint8_t dir;
+    // ether type, IP protocol or port
+    uint16_t value;
+    // protocol of IPv4 only, like icmp
+    uint8_t ipv4;
+    // IPv4 address in network order
+    uint32_t addr;
+} filter_term_t;
+
+typedef struct filter_t {
+
+    // -1 when the expression needs the bpf program
+    int nb_terms;
+    filter_term_t terms[FILTER_MAX_TERMS];
+    struct bpf_program prog;
+} filter_t;
+
+int filter_parse(filter_t *filter, const char *expression);
+
+int filter_compile(filter_t *filter, const char *expression,
+                   int snaplen, char *errbuf);
+
+int filter_port(const filter_term_t *term, const u_char *l3,
+                uint32_t length, uint16_t type);
+
+int filter_host(const filter_term_t *term, const u_char *l3,
+                uint32_t length, uint16_t type);
+
+int filter_term(const filter_term_t *term, const u_char *packet,
+                uint32_t caplen);
+
+int filter_match(const filter_t *filter,
+                 const struct pcap_pkthdr *header,
+                 const u_char *packet);
+
+void filter_free(filter_t *filter);
+
+#endif
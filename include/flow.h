@@ -0,0 +1,124 @@
+#ifndef FLOW
+#define FLOW
+
+#include "../include/context.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Tags of a group are compared together
+#define FLOW_GROUP 16
+// Tag of a slot never used, and of a slot whose flow was removed.
+// The tag of a used slot is 7 bits of the hash, so positive.
+#define FLOW_EMPTY ((int8_t)0x80)
+#define FLOW_DELETED ((int8_t)0xfe)
+// Slots used or deleted before the table is full, in eighths
+#define FLOW_LOAD 7
+// Default number of flows by thread
+#define FLOW_CAPACITY (1 << 20)
+// Flows idle for this number of seconds are removed
+#define FLOW_TIMEOUT 300
+// Slots checked for idle flows at each new flow
+#define FLOW_SWEEP 8
+
+/*
+ * Both endpoints of a flow, always in the same order so the two
+ * directions have the same key. IPv4 addresses are mapped in IPv6
+ * ones. An expected flow, announced by another one, has the
+ * addresses of that flow and only one port.
+ */
+typedef struct flow_key_t {
+
+    struct in6_addr addr[2];
+    uint16_t port[2];
+    uint8_t proto;
+    uint8_t expect;
+} flow_key_t;
+
+/*
+ * A flow fills one cache line. The analyzers keep their own state of
+ * the flow in data, freed by the release function of the table.
+ */
+typedef struct flow_t {
+
+    flow_key_t key;
+    // seconds of the first and the last frame
+    uint32_t first;
+    uint32_t last;
+    uint32_t packets;
+    // application of the whole flow, APP_NONE if found by segment
+    uint8_t app;
+    // endpoint of the key which sent the first frame
+    uint8_t opener;
+    // expectations already looked for
+    uint16_t generation;
+    void *data;
+} __attribute__((aligned(64))) flow_t;
+
+/*
+ * Open addressing table: the tags of a group of slots are compared in
+ * one instruction, and only the flows whose tag matches are read.
+ */
+typedef struct flow_table_t {
+
+    int8_t *tags;
+    flow_t *flows;
+    size_t mask;
+    size_t count;
+    size_t deleted;
+    // next slot checked for idle flows
+    size_t hand;
+    uint32_t timeout;
+    // expected flows waiting, and a number changed at each new one
+    size_t expects;
+    uint16_t generation;
+    unsigned long created;
+    unsigned long dropped;
+    // frees the data of a flow removed, with args
+    void (*release)(flow_t *flow, void *args);
+    void *args;
+} flow_table_t;
+
+int flow_alloc(flow_table_t *table, size_t capacity);
+
+int flow_open(flow_table_t *table, size_t capacity, uint32_t timeout);
+
+uint64_t flow_hash(const flow_key_t *key);
+
+int flow_equal(const flow_key_t *a, const flow_key_t *b);
+
+uint32_t flow_group_match(const int8_t *group, int8_t tag);
+
+uint32_t flow_group_free(const int8_t *group);
+
+size_t flow_probe(const flow_table_t *table, const flow_key_t *key,
+                  uint64_t hash, int *found);
+
+void flow_remove(flow_table_t *table, size_t slot);
+
+void flow_expire(flow_table_t *table, uint32_t now, size_t budget);
+
+int flow_rebuild(flow_table_t *table);
+
+flow_t *flow_insert(flow_table_t *table, const flow_key_t *key,
+                    uint32_t now);
+
+int flow_key(flow_key_t *key, const packet_t *pkt);
+
+void flow_expected(flow_table_t *table, flow_t *flow);
+
+void flow_packet(packet_t *pkt);
+
+int flow_hint(const u_char *packet, uint32_t caplen, uint64_t *hash);
+
+void flow_prefetch_tags(const flow_table_t *table, uint64_t hash);
+
+void flow_prefetch_flows(const flow_table_t *table, uint64_t hash);
+
+void flow_expect(const packet_t *pkt, uint16_t port, uint8_t app);
+
+void flow_close(flow_table_t *table);
+
+#endif
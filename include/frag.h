@@ -0,0 +1,119 @@
+#ifndef FRAG
+#define FRAG
+
+#include "../include/context.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/pool.h"
+#include <netinet/ip6.h>
+
+// Datagrams being reassembled are found by a hash of their key
+#define FRAG_BUCKETS 1024
+// Slots of one second of the timer wheel, more than the timeout
+#define FRAG_WHEEL 64
+// Seconds to receive all the fragments of a datagram
+#define FRAG_TIMEOUT 30
+// Default bytes held by a thread
+#define FRAG_MAX (1 << 26)
+// Room for the headers before the payload: the largest IPv4 header,
+// or an IPv6 header with the extension headers before the fragment one
+#define FRAG_HEADER 256
+// End of the hole list, and last byte of the hole after the last
+// fragment received so far
+#define FRAG_NONE 0xffff
+
+/*
+ * Both addresses, IPv4 ones mapped in IPv6 ones, with the
+ * identification and the protocol of the datagram
+ */
+typedef struct frag_key_t {
+
+    struct in6_addr addr[2];
+    uint32_t id;
+    uint8_t proto;
+    uint8_t version;
+    uint16_t pad;
+} frag_key_t;
+
+/*
+ * Bytes still missing, described in the missing bytes themselves as
+ * in RFC 815. Every fragment but the last carries a multiple of 8
+ * bytes, so a hole always has room for its descriptor.
+ */
+typedef struct frag_hole_t {
+
+    uint16_t last;
+    uint16_t next;
+} frag_hole_t;
+
+/*
+ * A datagram being reassembled: the header of the first fragment is
+ * put right before the payload, so the whole datagram is contiguous.
+ */
+typedef struct datagram_t {
+
+    frag_key_t key;
+    // chain of the bucket, and of the slot of the wheel
+    struct datagram_t *next;
+    struct datagram_t **prev;
+    struct datagram_t *tick_next;
+    struct datagram_t **tick_prev;
+    uint32_t expire;
+    // offset of the first hole, FRAG_NONE once complete
+    uint16_t holes;
+    uint16_t hdr_len;
+    // payload bytes, known with the last fragment
+    uint16_t total;
+    u_char buffer[FRAG_HEADER + IP_MAXPACKET + 1];
+} datagram_t;
+
+/*
+ * Reassembly of the fragments of a thread. The datagrams come from a
+ * pool, which is the cap of the memory held: the datagram expiring
+ * first makes room for a new one when the pool is empty.
+ */
+typedef struct frags_t {
+
+    pool_t datagrams;
+    datagram_t *buckets[FRAG_BUCKETS];
+    datagram_t *wheel[FRAG_WHEEL];
+    // seconds up to which the datagrams are expired
+    uint32_t clock;
+    // datagram given to the analyzers, freed with the next fragment
+    datagram_t *done;
+    unsigned long reassembled;
+    unsigned long lost;
+} frags_t;
+
+void frag_open(frags_t *frags, size_t max);
+
+void frag_key(frag_key_t *key, const packet_t *pkt, uint32_t id);
+
+uint64_t frag_hash(const frag_key_t *key);
+
+void frag_free(frags_t *frags, datagram_t *datagram);
+
+void frag_expire(frags_t *frags, uint32_t now);
+
+void frag_evict(frags_t *frags);
+
+datagram_t *frag_find(frags_t *frags, const frag_key_t *key,
+                      uint32_t now);
+
+void frag_link(datagram_t *datagram, uint16_t prev, uint16_t hole);
+
+datagram_t *frag_add(frags_t *frags, const packet_t *pkt, uint32_t id,
+                     const u_char *header, uint16_t hdr_len,
+                     uint16_t offset, int more, const u_char *payload,
+                     uint16_t len);
+
+int frag_len(const packet_t *pkt);
+
+const u_char *frag_ip(packet_t *pkt, const u_char *packet,
+                      int *length);
+
+void frag_print(const packet_t *pkt, int verbose);
+
+void frag_close(frags_t *frags);
+
+#endif
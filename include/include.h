@@ -2,6 +2,7 @@
 #define INCLUDE_H
 
 #include "../include/netinet_bootp.h"
+#include "../include/output.h"
 #include "../include/panic.h"
 #include <ctype.h>
 #include <getopt.h>
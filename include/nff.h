@@ -0,0 +1,90 @@
+#ifndef NFF
+#define NFF
+
+#include "../include/batch.h"
+#include "../include/classify.h"
+#include "../include/context.h"
+#include "../include/filter.h"
+#include "../include/flow.h"
+#include "../include/frag.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/reader.h"
+#include "../include/registry.h"
+#include "../include/stream.h"
+
+// Layers a callback is registered on, each frame is given to the
+// callbacks of the layers it reached
+#define NFF_FRAME 0
+#define NFF_ARP 1
+#define NFF_IPV4 2
+#define NFF_IPV6 3
+#define NFF_TCP 4
+#define NFF_UDP 5
+#define NFF_ICMP 6
+// application protocol found, in the app field
+#define NFF_APP 7
+#define NFF_MAX 8
+
+// Where the frames come from
+#define NFF_READER 0
+#define NFF_PCAP 1
+
+/*
+ * Receives the dissection of a frame, valid until the callback
+ * returns: the frame may be a datagram reassembled from its fragments,
+ * in a buffer given back with the next frame
+ */
+typedef void (*nff_callback_t)(const packet_t *pkt, void *user);
+
+/*
+ * Decoders of the analyzer embedded in another program. Frames are
+ * read by batches and decoded without printing anything, the
+ * callbacks receive the packet_t filled by the decoders. Errors are
+ * returned, nothing exits, the message of the last one is in error.
+ * The port registry makes it large, it is better not on the stack.
+ */
+typedef struct nff_t {
+
+    int source;
+    // capture file read in place, or libpcap for the live capture and
+    // the formats the reader does not know
+    reader_t reader;
+    pcap_t *handle;
+    filter_t filter;
+    int filtered;
+    // counters, tables and options of the decoders
+    context_t ctx;
+    flow_table_t flows;
+    streams_t streams;
+    frags_t frags;
+    registry_t registry;
+    nff_callback_t callbacks[NFF_MAX];
+    void *users[NFF_MAX];
+    char error[PCAP_ERRBUF_SIZE];
+} nff_t;
+
+void nff_init(nff_t *nff);
+
+int nff_filter_pcap(nff_t *nff, const char *filter, int optimize);
+
+int nff_open_file(nff_t *nff, const char *file, const char *filter);
+
+int nff_open_live(nff_t *nff, const char *interface,
+                  const char *filter);
+
+int nff_tables(nff_t *nff);
+
+void nff_on(nff_t *nff, int layer, nff_callback_t callback,
+            void *user);
+
+void nff_call(const nff_t *nff, int layer, const packet_t *pkt);
+
+void nff_packet(u_char *args, const struct pcap_pkthdr *header,
+                const u_char *packet);
+
+int nff_next_batch(nff_t *nff, int max);
+
+void nff_close(nff_t *nff);
+
+#endif
@@ -2,13 +2,35 @@
 #define OPTION
 
 #include "include.h"
+#include "flow.h"
+#include "frag.h"
+#include "registry.h"
+#include "resolver.h"
+#include "stream.h"
+#include "ring.h"
 
 typedef struct usage_t {
 
     char *interface;
     char *file;
     char *filter;
+    char *dump;
     char *verbose;
+    int ring;
+    unsigned int block_size;
+    unsigned int block_nr;
+    unsigned int block_timeout;
+    int jobs;
+    unsigned long output_batch;
+    int async;
+    unsigned long flows;
+    unsigned long stream_flow_max;
+    unsigned long stream_max;
+    unsigned long frag_max;
+    registry_t registry;
+    int tunnel_max;
+    int dns_interval;
+    int dns_top;
 } usage_t;
 
 void init_usage(usage_t *usage);
@@ -0,0 +1,64 @@
+#ifndef OUTPUT
+#define OUTPUT
+
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "../include/writer.h"
+
+// Initial size of the buffer of a thread, grown for larger frames
+#define OUTPUT_SIZE (1 << 16)
+
+// Text of the frames analyzed by a thread, written in one piece
+typedef struct output_t {
+
+    char *buf;
+    size_t len;
+    size_t size;
+    // amount of text buffered before being written, 0 for every frame
+    size_t batch;
+    // queue of the writer thread, NULL to write on stdout
+    writer_ring_t *ring;
+} output_t;
+
+// sink of the calling thread, selected from its analyzer context
+extern __thread output_t *output;
+
+int output_grow(size_t needed);
+
+void output_printf(const char *format, ...);
+
+void output_char(char c);
+
+void output_str(const char *str);
+
+void output_pad(size_t start, size_t width);
+
+void output_uint(unsigned long value);
+
+void output_ip4(const struct in_addr *addr);
+
+void output_ip6(const struct in6_addr *addr);
+
+void output_mac(const struct ether_addr *addr);
+
+void output_dump(const u_char *data, int length, int width);
+
+void output_open(output_t *sink, size_t batch);
+
+void output_select(output_t *sink);
+
+void output_attach(writer_ring_t *ring);
+
+void output_frame(void);
+
+void output_flush(void);
+
+void output_free(void);
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef PACKET
+#define PACKET
+
+#include "../include/include.h"
+
+// Application protocol
+#define APP_NONE 0
+#define APP_DNS 1
+#define APP_SMTP 2
+#define APP_HTTP 3
+#define APP_HTTPS 4
+#define APP_FTP 5
+#define APP_POP3 6
+#define APP_IMAP 7
+#define APP_TELNET 8
+#define APP_BOOTP 9
+#define APP_MAX 10
+
+// Headers peeled before the network protocol of the frame
+#define TUNNEL_VLAN 1
+#define TUNNEL_MPLS 2
+#define TUNNEL_GRE 3
+#define TUNNEL_PPP 4
+#define TUNNEL_IPV4 5
+#define TUNNEL_IPV6 6
+// Room of the tunnel stack, and the depth peeled by default
+#define TUNNEL_MAX 16
+#define TUNNEL_DEPTH 8
+
+/*
+ * A header peeled by the decapsulation: the VLAN id, the MPLS label,
+ * the GRE key (the call id for PPTP) or the PPP protocol, 0 for IP,
+ * and the ethertype of the protocol it carries
+ */
+typedef struct tunnel_t {
+
+    uint32_t id;
+    uint16_t proto;
+    uint8_t type;
+} tunnel_t;
+
+/*
+ * Dissection of a frame, filled once by the decoders of each layer
+ * and read by the printers. Fields are in host byte order.
+ */
+typedef struct packet_t {
+
+    const u_char *data;
+    uint32_t caplen;
+    uint32_t len;
+    // seconds of the capture, and microseconds of that second
+    uint32_t ts;
+    uint32_t ts_usec;
+
+    // offset of each layer from the beginning of the frame
+    uint16_t l3_offset;
+    uint16_t l4_offset;
+    uint16_t l7_offset;
+
+    // Ethernet
+    struct ether_addr mac_src;
+    struct ether_addr mac_dst;
+    uint16_t ether_type;
+
+    // IPv4 / IPv6
+    uint8_t ip_version;
+    uint8_t ip_proto;
+    // IPv6 extension headers included
+    uint16_t ip_hdr_len;
+    uint8_t ip_tos;
+    uint8_t ip_ttl;
+    // identification, of the fragment header for IPv6
+    uint32_t ip_id;
+    uint16_t ip_len;
+    uint16_t ip_frag_off;
+    uint16_t ip_check;
+    uint32_t ip_flow;
+    union {
+        struct in_addr v4;
+        struct in6_addr v6;
+    } ip_src, ip_dst;
+
+    // TCP / UDP
+    uint16_t sport;
+    uint16_t dport;
+    uint32_t tcp_seq;
+    uint32_t tcp_ack;
+    uint8_t tcp_off;
+    uint8_t tcp_flags;
+    uint16_t tcp_win;
+    uint16_t tcp_urp;
+    uint16_t l4_len;
+    uint16_t l4_check;
+
+    // Application
+    uint8_t app;
+
+    // Analyzer context of the thread, with its tables and options
+    struct context_t *ctx;
+    // Flow of a TCP or UDP segment, NULL without flow table
+    struct flow_t *flow;
+    // 0 from the endpoint which opened the flow, 1 from the other
+    uint8_t flow_dir;
+
+    // Tunnels peeled, from the outermost one, at most the tunnel_max
+    // of the context
+    uint8_t tunnel_depth;
+    tunnel_t tunnels[TUNNEL_MAX];
+} packet_t;
+
+/*
+ * Decoder of a protocol, given its header, the bytes left from it to
+ * the end of the frame and the verbosity
+ */
+typedef void (*decoder_t)(packet_t *pkt, const u_char *packet,
+                          int length, int verbose);
+
+/*
+ * Entry of a dispatch table indexed by protocol number: the decoder
+ * of the protocol, or the label printed at verbosity 1 when it is not
+ * decoded. An empty entry is an unknown protocol.
+ */
+typedef struct dissector_t {
+
+    decoder_t decode;
+    const char *label;
+} dissector_t;
+
+void init_packet(packet_t *pkt, const struct pcap_pkthdr *header,
+                 const u_char *packet);
+
+const char *app_name(uint8_t app);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef POOL
+#define POOL
+
+#include <stddef.h>
+#include <stdlib.h>
+
+// Objects allocated together when the pool is empty
+#define POOL_SLAB 64
+
+/*
+ * Objects of one size, taken and given back without calling malloc
+ * once the pool has grown. The pool never holds more than max objects,
+ * so the memory of the objects is bounded.
+ */
+typedef struct pool_t {
+
+    size_t size;
+    size_t max;
+    size_t used;
+    size_t allocated;
+    // free objects, linked through their first bytes
+    void *free;
+    // slabs allocated, linked through their header
+    void *slabs;
+} pool_t;
+
+void pool_open(pool_t *pool, size_t size, size_t max);
+
+void *pool_get(pool_t *pool);
+
+void pool_put(pool_t *pool, void *object);
+
+void pool_close(pool_t *pool);
+
+#endif
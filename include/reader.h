@@ -0,0 +1,106 @@
+#ifndef READER
+#define READER
+
+#include "../include/filter.h"
+#include "../include/include.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Magic numbers of the capture files
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAPNG_SHB 0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER 0x1a2b3c4d
+
+// pcapng block types
+#define PCAPNG_IDB 1
+#define PCAPNG_OPB 2
+#define PCAPNG_SPB 3
+#define PCAPNG_EPB 6
+
+// Largest frame accepted, as libpcap does
+#define READER_MAX_SNAPLEN 262144
+// Interfaces of a pcapng section whose resolution is kept
+#define READER_MAX_IF 16
+// Zeroed bytes mapped after the file, analyzers may read past a frame
+#define READER_PADDING (1 << 16)
+// Amount of file read ahead of the current frame
+#define READER_WINDOW (1 << 26)
+// Headers checked in a row to find a record boundary
+#define READER_CHECK 8
+// Largest gap between the timestamps of two records in a row
+#define READER_MAX_GAP 86400
+
+#define READER_PCAP 0
+#define READER_PCAPNG 1
+
+struct pcap_file_hdr {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct pcap_record_hdr {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t caplen;
+    uint32_t len;
+};
+
+typedef struct reader_t {
+
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    size_t size;
+    size_t offset;
+    size_t advised;
+    int format;
+    int swap;
+    int nsec;
+    uint32_t snaplen;
+    // timestamp of the first record of a classic pcap file
+    uint32_t first_sec;
+    int nb_if;
+    // units by second of the timestamps of each pcapng interface
+    uint64_t ts_units[READER_MAX_IF];
+    // frames not matching are skipped, NULL to keep them all
+    const filter_t *filter;
+} reader_t;
+
+uint16_t reader_u16(const reader_t *reader, const uint8_t *field);
+uint32_t reader_u32(const reader_t *reader, const uint8_t *field);
+
+void reader_advise(reader_t *reader);
+
+int reader_open(reader_t *reader, const char *file);
+
+int reader_next_pcap(reader_t *reader, struct pcap_pkthdr *header,
+                     const u_char **packet);
+
+void reader_interface(reader_t *reader, const uint8_t *block,
+                      uint32_t length, int nb_if);
+
+int reader_next_pcapng(reader_t *reader, struct pcap_pkthdr *header,
+                       const u_char **packet);
+
+int reader_next(reader_t *reader, struct pcap_pkthdr *header,
+                const u_char **packet);
+
+int reader_is_record(const reader_t *reader, size_t offset);
+
+int reader_split(const reader_t *reader, size_t *bounds,
+                 int nb_chunks);
+
+void reader_chunk(const reader_t *reader, reader_t *chunk,
+                  size_t start, size_t end);
+
+void reader_close(reader_t *reader);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef REGISTRY
+#define REGISTRY
+
+#include "../include/include.h"
+#include "../include/packet.h"
+#include <strings.h>
+
+// Transports whose ports are registered
+#define REGISTRY_TCP 0
+#define REGISTRY_UDP 1
+#define REGISTRY_MAX 2
+
+#define REGISTRY_PORTS 65536
+
+/*
+ * Application of every port of each transport, filled once at startup
+ * and only read afterwards, so the threads share it. When both ports
+ * are registered, the application with the lowest id is chosen.
+ */
+typedef struct registry_t {
+
+    uint8_t apps[REGISTRY_MAX][REGISTRY_PORTS];
+} registry_t;
+
+void registry_init(registry_t *registry);
+
+int registry_parse(registry_t *registry, const char *override);
+
+uint8_t registry_pick(uint8_t src, uint8_t dst);
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef RESOLVER
+#define RESOLVER
+
+#include "../include/4_dns.h"
+#include "../include/context.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/pool.h"
+#include "../include/topk.h"
+#include <time.h>
+
+// Queries waiting for their response are found by a hash of their key
+#define RESOLVER_BUCKETS 4096
+// Slots of one second of the timer wheel, more than the timeout
+#define RESOLVER_WHEEL 16
+// Seconds a query waits for its response before it is lost
+#define RESOLVER_TIMEOUT 5
+// Queries waiting at most by thread
+#define RESOLVER_QUERIES (1 << 16)
+// Servers counted apart, a power of 2, filled up to three quarters.
+// The others are counted together in the last slot.
+#define RESOLVER_SERVERS 64
+// Response times by power of 2 of microseconds, the last one holds
+// the longer ones
+#define RESOLVER_TIMES 24
+// Response codes counted apart, up to REFUSED, the others together
+#define RESOLVER_RCODES 6
+// Response code of a name which does not exist
+#define RESOLVER_NXDOMAIN 3
+
+/*
+ * Client and server addresses, IPv4 ones mapped in IPv6 ones, with
+ * the port of the client, the transaction id and a hash of the name
+ * asked, which the response repeats
+ */
+typedef struct query_key_t {
+
+    struct in6_addr addr[2];
+    uint16_t port;
+    uint16_t id;
+    uint32_t name;
+} query_key_t;
+
+/*
+ * A query waiting for its response, in the chain of its bucket and in
+ * the slot of the wheel of the second it expires
+ */
+typedef struct query_t {
+
+    query_key_t key;
+    struct query_t *next;
+    struct query_t **prev;
+    struct query_t *tick_next;
+    struct query_t **tick_prev;
+    // microseconds of the capture it was sent
+    uint64_t sent;
+    uint32_t expire;
+    uint16_t server;
+} query_t;
+
+/*
+ * Counters of a server since the last summary
+ */
+typedef struct server_t {
+
+    struct in6_addr addr;
+    int used;
+    unsigned long queries;
+    unsigned long answers;
+    // queries never answered, and responses to no query seen
+    unsigned long lost;
+    unsigned long unmatched;
+    unsigned long rcodes[RESOLVER_RCODES + 1];
+    unsigned long times[RESOLVER_TIMES];
+} server_t;
+
+/*
+ * DNS transactions of a thread: each response is matched with its
+ * query, its time and its code are counted by server, and the
+ * counters are printed then cleared at each interval of the capture
+ * time. The queries come from a pool, nothing is allocated once it
+ * has grown, and the query expiring first makes room when it is
+ * empty. The names asked, the names not found and the clients most
+ * seen are counted by sketches of a fixed size.
+ */
+typedef struct resolvers_t {
+
+    pool_t queries;
+    query_t *buckets[RESOLVER_BUCKETS];
+    query_t *wheel[RESOLVER_WHEEL];
+    // seconds up to which the queries are expired
+    uint32_t clock;
+    // seconds between two summaries, and the end of this one
+    uint32_t interval;
+    uint32_t next;
+    server_t servers[RESOLVER_SERVERS + 1];
+    int nb_servers;
+    // queries not tracked, no room was left
+    unsigned long dropped;
+    // entries printed by sketch, 0 to count none
+    uint32_t top;
+    topk_t names;
+    topk_t nxdomains;
+    topk_t clients;
+} resolvers_t;
+
+int resolver_open(resolvers_t *resolvers, uint32_t interval,
+                  size_t max, uint32_t top);
+
+void resolver_addr(struct in6_addr *addr, const packet_t *pkt,
+                   int dst);
+
+uint64_t resolver_hash(const query_key_t *key);
+
+uint32_t resolver_name(const u_char *packet, int length);
+
+int resolver_question(const u_char *packet, int length, u_char *key);
+
+const char *resolver_type(uint16_t type, char *buf, size_t size);
+
+server_t *resolver_server(resolvers_t *resolvers,
+                          const struct in6_addr *addr);
+
+void resolver_free(resolvers_t *resolvers, query_t *query);
+
+void resolver_expire(resolvers_t *resolvers, uint32_t now);
+
+void resolver_evict(resolvers_t *resolvers);
+
+query_t *resolver_find(resolvers_t *resolvers, const query_key_t *key,
+                       uint64_t hash);
+
+void resolver_query(resolvers_t *resolvers, const query_key_t *key,
+                    uint64_t sent, uint32_t now);
+
+void resolver_response(resolvers_t *resolvers, const query_key_t *key,
+                       uint64_t received, int rcode);
+
+void resolver_packet(packet_t *pkt, const u_char *packet, int length);
+
+void resolver_clock(resolvers_t *resolvers, uint32_t now);
+
+void resolver_message(packet_t *pkt, const u_char *packet,
+                      int length);
+
+int resolver_time(uint64_t usec);
+
+void resolver_print(const server_t *server);
+
+void resolver_top(topk_t *topk, uint32_t top, const char *what,
+                  int client);
+
+void resolver_summary(resolvers_t *resolvers, uint32_t start);
+
+void resolver_merge(resolvers_t *dst, resolvers_t *src);
+
+int resolver_save(resolvers_t *resolvers, FILE *file);
+
+int resolver_load(resolvers_t *resolvers, FILE *file);
+
+void resolver_close(resolvers_t *resolvers);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef RING
+#define RING
+
+#include "../include/batch.h"
+#include "../include/include.h"
+#include <errno.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+// Default parameters of the TPACKET_V3 ring
+#define RING_BLOCK_SIZE (1 << 22)
+#define RING_BLOCK_NR 64
+#define RING_FRAME_SIZE (1 << 11)
+#define RING_TIMEOUT 60
+// Period to check if the capture must stop
+#define RING_POLL_MS 100
+
+typedef struct ring_t {
+
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    unsigned int block_size;
+    unsigned int block_nr;
+    unsigned int block;
+} ring_t;
+
+int ring_open(ring_t *ring, const char *interface,
+              unsigned int block_size, unsigned int block_nr,
+              unsigned int timeout);
+
+int ring_set_filter(ring_t *ring, const char *filter);
+
+int ring_join_fanout(ring_t *ring, int group);
+
+int ring_stats(ring_t *ring, unsigned long *received,
+               unsigned long *dropped);
+
+void ring_walk_block(struct tpacket_block_desc *block, batch_t *batch,
+                     pcap_handler callback, u_char *args);
+
+int ring_loop(ring_t *ring, flow_table_t *flows, pcap_handler callback,
+              void (*release)(u_char *), u_char *args);
+
+void ring_breakloop(void);
+
+void ring_close(ring_t *ring);
+
+#endif
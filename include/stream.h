@@ -0,0 +1,106 @@
+#ifndef STREAM
+#define STREAM
+
+#include "../include/context.h"
+#include "../include/flow.h"
+#include "../include/frag.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+#include "../include/pool.h"
+
+// Payload bytes of a segment buffer, the buffer fills 2 KiB
+#define STREAM_CHUNK (2048 - 2 * sizeof(void *))
+// Default bytes held by a flow, and by a thread for all its flows
+#define STREAM_FLOW_MAX (1 << 20)
+#define STREAM_MAX (1 << 28)
+// A segment further ahead starts the stream again
+#define STREAM_WINDOW (1 << 24)
+// Message of an application framed by a 2-byte length, and the ones
+// split across segments kept at once by a thread
+#define STREAM_MESSAGE (2 + 65535)
+#define STREAM_MESSAGES 64
+
+// Sequence numbers compared modulo 2^32
+#define SEQ_LT(a, b) ((int32_t)((a) - (b)) < 0)
+#define SEQ_LEQ(a, b) ((int32_t)((a) - (b)) <= 0)
+
+/*
+ * Bytes received ahead of the next ones expected, waiting for the gap
+ * before them to be filled. The buffers of a direction are sorted and
+ * never overlap.
+ */
+typedef struct segment_t {
+
+    struct segment_t *next;
+    uint32_t seq;
+    uint32_t len;
+    u_char data[STREAM_CHUNK];
+} segment_t;
+
+// One direction of a TCP connection
+typedef struct stream_t {
+
+    segment_t *segments;
+    // sequence number of the next byte delivered
+    uint32_t next;
+    // bytes of the segment buffers held
+    uint32_t held;
+    // highest acknowledgment of the other endpoint
+    uint32_t acked;
+    uint8_t init;
+    uint8_t ack;
+    // bytes given up since the SYN, the messages cannot be framed
+    uint8_t lost;
+    // message being framed by the application: bytes delivered, its
+    // length included, and its length once known
+    uint32_t framed;
+    uint32_t frame_len;
+    // bytes of a message split across segments, NULL if not kept
+    u_char *message;
+} stream_t;
+
+// State of a TCP flow, in the data of the flow
+typedef struct connection_t {
+
+    stream_t dir[2];
+} connection_t;
+
+/*
+ * Reassembly of the TCP flows of a thread. The segments and the
+ * connections come from pools, so the memory held stays under the
+ * global cap whatever the loss and the reordering.
+ */
+typedef struct streams_t {
+
+    pool_t segments;
+    pool_t connections;
+    pool_t messages;
+    // bytes held by one direction of a flow at most
+    uint32_t flow_max;
+    // contiguous bytes delivered from several segments
+    u_char *buffer;
+} streams_t;
+
+int stream_open(streams_t *streams, flow_table_t *flows,
+                uint32_t flow_max, size_t max);
+
+void stream_unframe(streams_t *streams, stream_t *stream);
+
+void stream_clear(streams_t *streams, stream_t *stream);
+
+void stream_release(flow_t *flow, void *args);
+
+int stream_hold(streams_t *streams, stream_t *stream, uint32_t seq,
+                const u_char *payload, uint32_t len);
+
+const u_char *stream_deliver(streams_t *streams, stream_t *stream,
+                             const u_char *payload, int *length);
+
+const u_char *stream_segment(packet_t *pkt, const u_char *payload,
+                             int *length);
+
+stream_t *stream_direction(const packet_t *pkt);
+
+void stream_close(streams_t *streams);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef TOPK
+#define TOPK
+
+#include "../include/include.h"
+
+// Longest key counted: a DNS name with its type
+#define TOPK_KEY 260
+// Counters kept by entry printed, the more the fewer miscounts
+#define TOPK_FACTOR 8
+// Entries printed at most
+#define TOPK_MAX 10000
+// Slot of the index without entry
+#define TOPK_NONE UINT32_MAX
+
+/*
+ * A key counted, with the count it may have inherited from the key it
+ * replaced: it was seen at least count - error times
+ */
+typedef struct topk_entry_t {
+
+    unsigned long count;
+    unsigned long error;
+    uint32_t hash;
+    // position in the heap
+    uint32_t heap;
+    uint16_t len;
+    u_char key[TOPK_KEY];
+} topk_entry_t;
+
+/*
+ * Space-saving sketch: a fixed number of counters, the keys most seen
+ * keep theirs. A new key takes the counter of the least counted key,
+ * found at the top of a heap. The keys are found by an index with
+ * linear probing, twice as large as the counters.
+ */
+typedef struct topk_t {
+
+    topk_entry_t *entries;
+    uint32_t *heap;
+    uint32_t *index;
+    // entries in the order they are printed
+    const topk_entry_t **sorted;
+    uint32_t mask;
+    uint32_t capacity;
+    uint32_t used;
+    unsigned long total;
+} topk_t;
+
+int topk_open(topk_t *topk, uint32_t capacity);
+
+uint32_t topk_hash(const u_char *key, uint16_t len);
+
+uint32_t topk_find(const topk_t *topk, const u_char *key, uint16_t len,
+                   uint32_t hash);
+
+void topk_swap(topk_t *topk, uint32_t a, uint32_t b);
+
+void topk_up(topk_t *topk, uint32_t pos);
+
+void topk_down(topk_t *topk, uint32_t pos);
+
+void topk_unlink(topk_t *topk, uint32_t entry);
+
+void topk_link(topk_t *topk, uint32_t entry);
+
+void topk_add(topk_t *topk, const u_char *key, uint16_t len);
+
+void topk_insert(topk_t *topk, const u_char *key, uint16_t len,
+                 unsigned long count, unsigned long error);
+
+void topk_merge(topk_t *dst, const topk_t *src);
+
+int topk_save(const topk_t *topk, FILE *file);
+
+int topk_load(topk_t *topk, FILE *file);
+
+int topk_compare(const void *a, const void *b);
+
+uint32_t topk_sort(topk_t *topk, uint32_t k);
+
+void topk_clear(topk_t *topk);
+
+void topk_close(topk_t *topk);
+
+#endif
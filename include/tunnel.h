@@ -0,0 +1,83 @@
+#ifndef TUNNEL
+#define TUNNEL
+
+#include "../include/1_ethernet.h"
+#include "../include/2_ip.h"
+#include "../include/2_ipv6.h"
+#include "../include/context.h"
+#include "../include/frag.h"
+#include "../include/include.h"
+#include "../include/packet.h"
+
+// Ethertypes of the headers peeled, beside the 802.1Q tag
+#define ETHERTYPE_QINQ 0x88a8
+#define ETHERTYPE_QINQ_OLD 0x9100
+#define ETHERTYPE_MPLS 0x8847
+#define ETHERTYPE_MPLS_MULTI 0x8848
+// Ethernet bridged by GRE
+#define ETHERTYPE_TEB 0x6558
+// PPP carried by the enhanced GRE of PPTP
+#define ETHERTYPE_PPP 0x880b
+
+// GRE flags, version 0 and 1
+#define GRE_CHECKSUM 0x8000
+#define GRE_ROUTING 0x4000
+#define GRE_KEY 0x2000
+#define GRE_SEQ 0x1000
+#define GRE_ACK 0x0080
+#define GRE_VERSION 0x0007
+
+// PPP address and control of the HDLC-like framing
+#define PPP_ADDRESS 0xff
+#define PPP_CONTROL 0x03
+// PPP protocols peeled
+#define PPP_IP 0x0021
+#define PPP_IPV6 0x0057
+
+struct vlan_hdr {
+    uint16_t tci;
+    uint16_t type;
+};
+
+struct gre_hdr {
+    uint16_t flags;
+    uint16_t type;
+};
+
+int tunnel_room(const packet_t *pkt, const u_char *packet, int length);
+
+void tunnel_push(packet_t *pkt, uint8_t type, uint32_t id,
+                 uint16_t proto);
+
+void tunnel_print_ip(const packet_t *pkt, int verbose);
+
+int tunnel_vlan(packet_t *pkt, const u_char *packet, int length,
+                int verbose);
+
+int tunnel_mpls(packet_t *pkt, const u_char *packet, int length,
+                int verbose);
+
+int tunnel_ethernet(packet_t *pkt, const u_char *packet, int length,
+                    int verbose);
+
+int tunnel_ppp(packet_t *pkt, const u_char *packet, int length,
+               int verbose);
+
+int tunnel_gre(packet_t *pkt, const u_char *packet, int length,
+               int verbose);
+
+int tunnel_size(uint8_t proto);
+
+int tunnel_carry(packet_t *pkt, const u_char **packet, int *length,
+                 const u_char *payload, int len, int verbose);
+
+int tunnel_ip(packet_t *pkt, const u_char **packet, int *length,
+              int verbose);
+
+int tunnel_ipv6(packet_t *pkt, const u_char **packet, int *length,
+                int verbose);
+
+const u_char *tunnel_decap(packet_t *pkt, const u_char *packet,
+                           int *length, int verbose);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef WORKER
+#define WORKER
+
+#include "../include/context.h"
+#include "../include/dump.h"
+#include "../include/include.h"
+#include "../include/option.h"
+#include "../include/reader.h"
+#include "../include/ring.h"
+#include "../include/stream.h"
+#include <pthread.h>
+#include <sys/wait.h>
+
+typedef struct worker_t {
+
+    pthread_t thread;
+    ring_t ring;
+    context_t ctx;
+    pcap_handler callback;
+    // text of the frames of the worker
+    output_t sink;
+    // queue of the writer thread, NULL to write on stdout
+    writer_ring_t *output;
+    // frames of the worker waiting to be saved
+    dump_t dump;
+    flow_table_t flows;
+    streams_t streams;
+    resolvers_t resolvers;
+} worker_t;
+
+// Shared by the processes analyzing the chunks of a file
+typedef struct chunks_t {
+
+    pthread_barrier_t barrier;
+    // frames of each chunk
+    unsigned long *counts;
+    // counters of each chunk once analyzed
+    context_t ctxs[];
+} chunks_t;
+
+int open_workers(worker_t *workers, int nb_workers, usage_t *usage,
+                 int verbose, pcap_handler callback);
+
+void worker_packet(u_char *args, const struct pcap_pkthdr *header,
+                   const u_char *packet);
+
+void worker_release(u_char *args);
+
+void *worker_routine(void *args);
+
+int start_workers(worker_t *workers, int nb_workers);
+
+void join_workers(worker_t *workers, int nb_workers,
+                  context_t *total);
+
+void analyze_chunk(reader_t *reader, chunks_t *chunks, size_t *bounds,
+                   int chunk, FILE *output, FILE *frames, FILE *tops,
+                   const context_t *total, pcap_handler callback);
+
+int copy_output(FILE *output);
+
+int analyze_chunks(reader_t *reader, int nb_workers, context_t *total,
+                   pcap_handler callback);
+
+#endif
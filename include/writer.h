@@ -0,0 +1,58 @@
+#ifndef WRITER
+#define WRITER
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Policy when the ring of a thread is full
+#define WRITER_SYNC 0
+#define WRITER_BLOCK 1
+#define WRITER_DROP 2
+
+// Bytes of text buffered for each thread, a power of two
+#define WRITER_RING_SIZE (1 << 24)
+// Pause of the writer when every ring is empty
+#define WRITER_IDLE_NS 1000000
+// Pause of a thread waiting for room in its ring
+#define WRITER_WAIT_NS 100000
+
+/*
+ * Text of the frames of one thread waiting to be written. Only the
+ * thread moves the head and only the writer moves the tail, so no
+ * lock is needed. Positions grow forever and are taken modulo size.
+ */
+typedef struct writer_ring_t {
+
+    char *buf;
+    size_t size;
+    int policy;
+    unsigned long dropped;
+    size_t head __attribute__((aligned(64)));
+    size_t tail __attribute__((aligned(64)));
+} writer_ring_t;
+
+typedef struct writer_t {
+
+    pthread_t thread;
+    int nb_rings;
+    writer_ring_t *rings;
+    int stop;
+} writer_t;
+
+int writer_open(writer_t *writer, int nb_rings, int policy);
+
+int writer_push(writer_ring_t *ring, const char *data, size_t len);
+
+size_t writer_drain(writer_ring_t *ring);
+
+void *writer_routine(void *args);
+
+int writer_start(writer_t *writer);
+
+unsigned long writer_close(writer_t *writer);
+
+#endif
@@ -1,61 +1,130 @@
 #include "../include/1_ethernet.h"
 
-char *addr_mac_print(const struct ether_addr *addr, char *buf) {
+/*
+ * Slot of every ethertype in the table of the network protocols, so
+ * the table stays dense while the ethertypes are spread over 16 bits
+ */
+static const uint8_t ether_slots[1 << 16] = {
+    [ETHERTYPE_IP] = ETHER_IP,
+    [ETHERTYPE_IPV6] = ETHER_IPV6,
+    [ETHERTYPE_ARP] = ETHER_ARP,
+    [ETHERTYPE_REVARP] = ETHER_REVARP,
+    [ETHERTYPE_PUP] = ETHER_PUP,
+    [ETHERTYPE_SPRITE] = ETHER_SPRITE,
+    [ETHERTYPE_AT] = ETHER_AT,
+    [ETHERTYPE_AARP] = ETHER_AARP,
+    [ETHERTYPE_VLAN] = ETHER_VLAN,
+    [ETHERTYPE_IPX] = ETHER_IPX,
+    [ETHERTYPE_LOOPBACK] = ETHER_LOOPBACK,
+    [ETHERTYPE_QINQ] = ETHER_QINQ,
+    [ETHERTYPE_QINQ_OLD] = ETHER_QINQ,
+    [ETHERTYPE_MPLS] = ETHER_MPLS,
+    [ETHERTYPE_MPLS_MULTI] = ETHER_MPLS,
+    [ETHERTYPE_PPP] = ETHER_PPP,
+};
+
+static const dissector_t ether_protocols[ETHER_MAX] = {
+    [ETHER_UNKNOWN] = {NULL, "-\t\t\t" RED "Unknown" NC},
+    [ETHER_IP] = {ip_dissect, NULL},
+    [ETHER_IPV6] = {ipv6_dissect, NULL},
+    [ETHER_ARP] = {arp_dissect, NULL},
+    [ETHER_REVARP] = {NULL, "-\t\t\tRARP"},
+    [ETHER_PUP] = {NULL, "-\t\t\tPUP"},
+    [ETHER_SPRITE] = {NULL, "-\t\t\tSPRITE"},
+    [ETHER_AT] = {NULL, "-\t\t\tAT"},
+    [ETHER_AARP] = {NULL, "-\t\t\tAARP"},
+    [ETHER_VLAN] = {NULL, "-\t\t\tVLAN"},
+    [ETHER_IPX] = {NULL, "-\t\t\tIPX"},
+    [ETHER_LOOPBACK] = {NULL, "-\t\t\tLOOPBACK"},
+    [ETHER_QINQ] = {NULL, "-\t\t\tVLAN"},
+    [ETHER_MPLS] = {NULL, "-\t\t\tMPLS"},
+    [ETHER_PPP] = {NULL, "-\t\t\tPPP"},
+};
 
-    int ret_snprintf;
+char *addr_mac_print(const struct ether_addr *addr, char *buf) {
 
-    NCHK(ret_snprintf = snprintf(
-             buf, 18, "%02x:%02x:%02x:%02x:%02x:%02x",
+    snprintf(buf, 18, "%02x:%02x:%02x:%02x:%02x:%02x",
              addr->ether_addr_octet[0], addr->ether_addr_octet[1],
              addr->ether_addr_octet[2], addr->ether_addr_octet[3],
-             addr->ether_addr_octet[4], addr->ether_addr_octet[5]));
+             addr->ether_addr_octet[4], addr->ether_addr_octet[5]);
 
     return buf;
 }
 
-void add_mac_print_lvl1(struct ether_header *eth_header) {
+void add_mac_print_lvl1(const packet_t *pkt) {
 
-    char buf[18];
-    printf("%s\t\t\t\t",
-           addr_mac_print(
-               (struct ether_addr *)eth_header->ether_shost, buf));
-    printf("%s\t\t\t\t",
-           addr_mac_print(
-               (struct ether_addr *)eth_header->ether_dhost, buf));
+    output_mac(&pkt->mac_src);
+    output_str("\t\t\t\t");
+    output_mac(&pkt->mac_dst);
+    output_str("\t\t\t\t");
 }
 
-struct ether_header *ethernet_analyzer(const u_char *packet,
-                                       int verbose) {
+/**
+ * @brief Fill the ethernet fields of the dissection
+ */
+void ethernet_decode(packet_t *pkt, const u_char *packet) {
 
     struct ether_header *eth_header = (struct ether_header *)packet;
 
-    char buf[18];
+    memcpy(&pkt->mac_src, eth_header->ether_shost, ETH_ALEN);
+    memcpy(&pkt->mac_dst, eth_header->ether_dhost, ETH_ALEN);
+    pkt->ether_type = ntohs(eth_header->ether_type);
+    pkt->l3_offset = (packet - pkt->data) + sizeof(struct ether_header);
+}
+
+/**
+ * @brief Print the ethernet fields of the dissection
+ */
+void ethernet_print(const packet_t *pkt, int verbose) {
+
+    char src[18], dst[18];
+
+    if (verbose < 2)
+        return;
+
+    addr_mac_print(&pkt->mac_src, src);
+    addr_mac_print(&pkt->mac_dst, dst);
 
     // One line from the ethernet header
-    PRV2(printf(
-             GRN "Ethernet" NC "\tMac src : %s, ",
-             addr_mac_print(
-                 (struct ether_addr *)eth_header->ether_shost, buf)),
-         verbose);
-    PRV2(printf(
-             "Mac dst : %s\n",
-             addr_mac_print(
-                 (struct ether_addr *)eth_header->ether_dhost, buf)),
+    PRV2(output_printf(GRN "Ethernet" NC "\tMac src : %s, "
+                           "Mac dst : %s\n",
+                       src, dst),
          verbose);
 
     // Multiple lines from the ethernet header
-    PRV3(printf(
-             GRN "Ethernet Header" NC "\n"
-                 "Source MAC : %s\n",
-             addr_mac_print(
-                 (struct ether_addr *)eth_header->ether_shost, buf)),
+    PRV3(output_printf(GRN "Ethernet Header" NC "\n"
+                           "Source MAC : %s\n"
+                           "Destination MAC : %s\n",
+                       src, dst),
          verbose);
+}
 
-    PRV3(printf(
-             "Destination MAC : %s\n",
-             addr_mac_print(
-                 (struct ether_addr *)eth_header->ether_dhost, buf)),
-         verbose);
+void ethernet_analyzer(packet_t *pkt, const u_char *packet,
+                       int verbose) {
+
+    ethernet_decode(pkt, packet);
+    ethernet_print(pkt, verbose);
+}
+
+/**
+ * @brief Get the network protocol of the frame, behind its tunnels,
+ * from the table of the ethertypes. A protocol which is not decoded
+ * only prints its label, after the MAC addresses.
+ */
+void get_protocol_ethernet(packet_t *pkt, const u_char *packet,
+                           int length, int verbose) {
 
-    return eth_header;
-}
\ No newline at end of file
+    const dissector_t *dissector;
+
+    if ((packet = tunnel_decap(pkt, packet, &length, verbose)) == NULL)
+        return;
+
+    dissector = &ether_protocols[ether_slots[pkt->ether_type]];
+    if (dissector->decode != NULL) {
+        dissector->decode(pkt, packet, length, verbose);
+        return;
+    }
+
+    PRV1(add_mac_print_lvl1(pkt), verbose);
+    PRV1(output_str(dissector->label), verbose);
+}
@@ -3,88 +3,108 @@
 void arp_analyzer(const u_char *packet, int verbose) {
 
     struct ether_arp *arp = (struct ether_arp *)packet;
-    char buf[18];
+    char buf[18], ip[INET_ADDRSTRLEN];
 
     // One line by frame
     int k;
     for (k = 0; k < 6; k++) {
         sprintf(buf, "%02x", arp->arp_sha[k]);
-        PRV1(printf("%s", buf), verbose);
+        PRV1(output_printf("%s", buf), verbose);
         if (k < 5)
-            PRV1(printf(":"), verbose);
+            PRV1(output_str(":"), verbose);
     }
-    PRV1(printf("\t\t\t\t"), verbose);
+    PRV1(output_str("\t\t\t\t"), verbose);
 
     for (k = 0; k < 6; k++) {
         sprintf(buf, "%02x", arp->arp_tha[k]);
-        PRV1(printf("%s", buf), verbose);
+        PRV1(output_printf("%s", buf), verbose);
         if (k < 5)
-            PRV1(printf(":"), verbose);
+            PRV1(output_str(":"), verbose);
     }
-    PRV1(printf("\t\t\t\t"), verbose);
+    PRV1(output_str("\t\t\t\t"), verbose);
 
     // One line from the arp header
-    PRV2(printf(YEL "ARP" NC "\t\t"), verbose);
+    PRV2(output_str(YEL "ARP" NC "\t\t"), verbose);
 
     // Multiple lines from the arp header
-    PRV3(printf("\n" GRN "ARP Header" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "ARP Header" NC "\n"), verbose);
 
     if (ntohs(arp->arp_hrd) == ARPHRD_ETHER) {
-        PRV2(printf("Ethernet (%d), ", ntohs(arp->arp_hrd)), verbose);
-        PRV3(printf("Hardware type : Ethernet (%d)\n",
-                    ntohs(arp->arp_hrd)),
+        PRV2(output_printf("Ethernet (%d), ", ntohs(arp->arp_hrd)),
+             verbose);
+        PRV3(output_printf("Hardware type : Ethernet (%d)\n",
+                           ntohs(arp->arp_hrd)),
              verbose);
     } else
-        PRV3(printf("Hardware type : Unknown (%d)\n",
-                    ntohs(arp->arp_hrd)),
+        PRV3(output_printf("Hardware type : Unknown (%d)\n",
+                           ntohs(arp->arp_hrd)),
              verbose);
 
     if (ntohs(arp->arp_pro) == ETHERTYPE_IP) {
-        PRV2(printf("IPv4 (0x%02x), ", ntohs(arp->arp_pro)), verbose);
-        PRV3(printf("Protocol type : IP (0x%02x)\n",
-                    ntohs(arp->arp_pro)),
+        PRV2(output_printf("IPv4 (0x%02x), ", ntohs(arp->arp_pro)),
+             verbose);
+        PRV3(output_printf("Protocol type : IP (0x%02x)\n",
+                           ntohs(arp->arp_pro)),
              verbose);
     } else
-        PRV3(printf("Protocol type : Unknown (0x%02x)\n",
-                    ntohs(arp->arp_pro)),
+        PRV3(output_printf("Protocol type : Unknown (0x%02x)\n",
+                           ntohs(arp->arp_pro)),
              verbose);
 
     if (ntohs(arp->arp_op) == ARPOP_REQUEST) {
-        PRV2(printf("Request (%d), ", ntohs(arp->arp_op)), verbose);
-        PRV3(printf("Operation : ARP request (%d)\n",
-                    ntohs(arp->arp_op)),
+        PRV2(output_printf("Request (%d), ", ntohs(arp->arp_op)),
+             verbose);
+        PRV3(output_printf("Operation : ARP request (%d)\n",
+                           ntohs(arp->arp_op)),
              verbose);
     } else if (ntohs(arp->arp_op) == ARPOP_REPLY) {
-        PRV2(printf("Reply (%d), ", ntohs(arp->arp_op)), verbose);
-        PRV3(printf("Operation : ARP reply (%d)\n",
-                    ntohs(arp->arp_op)),
+        PRV2(output_printf("Reply (%d), ", ntohs(arp->arp_op)),
+             verbose);
+        PRV3(output_printf("Operation : ARP reply (%d)\n",
+                           ntohs(arp->arp_op)),
              verbose);
     } else
-        PRV3(printf("Operation : Unknown (%d)\n", ntohs(arp->arp_op)),
+        PRV3(output_printf("Operation : Unknown (%d)\n",
+                           ntohs(arp->arp_op)),
              verbose);
 
-    PRV2(printf("Hardware size : %d\n", arp->arp_hln), verbose);
+    PRV2(output_printf("Hardware size : %d\n", arp->arp_hln), verbose);
 
-    PRV3(printf("ARP Hardware size : %d\n"
-                "ARP Protocol size : %d\n",
-                arp->arp_hln, arp->arp_pln),
+    PRV3(output_printf("ARP Hardware size : %d\n"
+                       "ARP Protocol size : %d\n",
+                       arp->arp_hln, arp->arp_pln),
          verbose);
 
-    PRV3(printf(
+    PRV3(output_printf(
              "Sender MAC : %s\n",
              addr_mac_print((struct ether_addr *)arp->arp_sha, buf)),
          verbose);
 
-    PRV3(printf("Sender IP address : %s\n",
-                inet_ntoa(*(struct in_addr *)arp->arp_spa)),
+    PRV3(output_printf("Sender IP address : %s\n",
+                       inet_ntop(AF_INET, arp->arp_spa, ip,
+                                 INET_ADDRSTRLEN)),
          verbose);
 
-    PRV3(printf(
+    PRV3(output_printf(
              "Target MAC : %s\n",
              addr_mac_print((struct ether_addr *)arp->arp_tha, buf)),
          verbose);
 
-    PRV3(printf("Target IP address : %s\n",
-                inet_ntoa(*(struct in_addr *)arp->arp_tpa)),
+    PRV3(output_printf("Target IP address : %s\n",
+                       inet_ntop(AF_INET, arp->arp_tpa, ip,
+                                 INET_ADDRSTRLEN)),
          verbose);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Analyze the ARP packet of a frame
+ */
+void arp_dissect(packet_t *pkt, const u_char *packet, int length,
+                 int verbose) {
+
+    (void)pkt;
+    (void)length;
+
+    arp_analyzer(packet, verbose);
+    PRV1(output_str("-\t\t\tARP"), verbose);
+}
@@ -1,179 +1,168 @@
 #include "../include/2_ip.h"
 
+// Protocols carried by IPv4, the others are printed as Ipv4. The
+// tunnels are peeled before, up to the depth allowed.
+static const dissector_t ip_protocols[256] = {
+    [IPPROTO_TCP] = {tcp_dissect, NULL},
+    [IPPROTO_UDP] = {udp_dissect, NULL},
+    [IPPROTO_SCTP] = {sctp_dissect, NULL},
+    [IPPROTO_ICMP] = {icmp_analyzer, NULL},
+    [IPPROTO_IPIP] = {NULL, "-\t\t\tIPIP"},
+    [IPPROTO_IPV6] = {NULL, "-\t\t\tIPv6"},
+    [IPPROTO_IGMP] = {NULL, "-\t\t\tIGMP"},
+    [IPPROTO_EGP] = {NULL, "-\t\t\tEGP"},
+    [IPPROTO_PUP] = {NULL, "-\t\t\tPUP"},
+    [IPPROTO_IDP] = {NULL, "-\t\t\tIDP"},
+    [IPPROTO_TP] = {NULL, "-\t\t\tTP"},
+    [IPPROTO_DCCP] = {NULL, "-\t\t\tDCCP"},
+    [IPPROTO_RSVP] = {NULL, "-\t\t\tRSVP"},
+    [IPPROTO_GRE] = {NULL, "-\t\t\tGRE"},
+    [IPPROTO_ESP] = {NULL, "-\t\t\tESP"},
+    [IPPROTO_AH] = {NULL, "-\t\t\tAH"},
+    [IPPROTO_MTP] = {NULL, "-\t\t\tMTP"},
+    [IPPROTO_BEETPH] = {NULL, "-\t\t\tBEETPH"},
+    [IPPROTO_ENCAP] = {NULL, "-\t\t\tENCAP"},
+    [IPPROTO_PIM] = {NULL, "-\t\t\tPIM"},
+    [IPPROTO_COMP] = {NULL, "-\t\t\tCOMP"},
+    [IPPROTO_UDPLITE] = {NULL, "-\t\t\tUDPLITE"},
+    [IPPROTO_MPLS] = {NULL, "-\t\t\tMPLS"},
+    [IPPROTO_RAW] = {NULL, "-\t\t\tRAW"},
+};
+
 /**
- * @brief Print informations contained in IPv4 header and return the
- * header in a structure
- * @return struct iphdr*
+ * @brief Fill the IPv4 fields of the dissection
  */
-struct iphdr *ip_analyzer(const u_char *packet, int verbose) {
+void ip_decode(packet_t *pkt, const u_char *packet) {
 
     struct iphdr *ip = (struct iphdr *)packet;
 
-    char *src_ip = inet_ntoa(*(struct in_addr *)&ip->saddr);
-    char *dst_ip = inet_ntoa(*(struct in_addr *)&ip->daddr);
-
-    // One line by frame
-    int k;
-    for (k = 0; k < strlen(src_ip); k++)
-        PRV1(printf("%c", src_ip[k]), verbose);
-    for (k = strlen(src_ip); k < 15; k++)
-        PRV1(printf(" "), verbose);
-    PRV1(printf("\t\t\t\t\t"), verbose);
-    for (k = 0; k < strlen(dst_ip); k++)
-        PRV1(printf("%c", dst_ip[k]), verbose);
-    for (k = strlen(dst_ip); k < 15; k++)
-        PRV1(printf(" "), verbose);
-    PRV1(printf("\t\t\t\t\t"), verbose);
+    pkt->ip_version = 4;
+    pkt->ip_proto = ip->protocol;
+    pkt->ip_hdr_len = ip->ihl * 4;
+    pkt->ip_tos = ip->tos;
+    pkt->ip_ttl = ip->ttl;
+    pkt->ip_id = ntohs(ip->id);
+    pkt->ip_len = ntohs(ip->tot_len);
+    pkt->ip_frag_off = ntohs(ip->frag_off);
+    pkt->ip_check = ntohs(ip->check);
+    pkt->ip_src.v4.s_addr = ip->saddr;
+    pkt->ip_dst.v4.s_addr = ip->daddr;
+    pkt->l3_offset = packet - pkt->data;
+    pkt->l4_offset = pkt->l3_offset + pkt->ip_hdr_len;
+}
+
+/**
+ * @brief Print the IPv4 fields of the dissection
+ */
+void ip_print(const packet_t *pkt, int verbose) {
+
+    char src_ip[INET_ADDRSTRLEN], dst_ip[INET_ADDRSTRLEN];
+
+    if (verbose < 1)
+        return;
+
+    // One line by frame, addresses are padded to 15 characters
+    if (verbose == 1) {
+        size_t start = output->len;
+        output_ip4(&pkt->ip_src.v4);
+        output_pad(start, 15);
+        output_str("\t\t\t\t\t");
+        start = output->len;
+        output_ip4(&pkt->ip_dst.v4);
+        output_pad(start, 15);
+        output_str("\t\t\t\t\t");
+        return;
+    }
+
+    inet_ntop(AF_INET, &pkt->ip_src.v4, src_ip, INET_ADDRSTRLEN);
+    inet_ntop(AF_INET, &pkt->ip_dst.v4, dst_ip, INET_ADDRSTRLEN);
 
     // One line from the ipv4 header
-    PRV2(printf(YEL "IPv4" NC "\t\t"
-                    "IP src : %s, ",
-                inet_ntoa(*(struct in_addr *)&ip->saddr)),
-         verbose);
-    PRV2(printf("IP dst : %s, ",
-                inet_ntoa(*(struct in_addr *)&ip->daddr)),
+    PRV2(output_printf(YEL "IPv4" NC "\t\t"
+                           "IP src : %s, "
+                           "IP dst : %s, "
+                           "Id : 0x%02x\n",
+                       src_ip, dst_ip, pkt->ip_id),
          verbose);
 
-    PRV2(printf("Id : 0x%02x\n", ntohs(ip->id)), verbose);
-
-    // Multiple lines from the ipv4 header
-    PRV3(printf("\n" GRN "IPv4 Header" NC "\n"
-                "IP source : %s\n"
-                "IP destination : %s\n"
-                "IHL : %d\n"
-                "Identification : 0x%02x (%d)\n"
-                "Type of service : 0x%02x (%d)\n"
-                "Total length : %d\n"
-                "Time to live : %d\n"
-                "Fragment offset : 0x%02x (%d)\n"
-                "Protocol : %d\n"
-                "Checksum : 0x%02x (%d)\n",
-                src_ip, dst_ip, ip->ihl, (ip->id), ntohs(ip->id),
-                ip->tos, ip->tos, ntohs(ip->tot_len), ip->ttl,
-                ip->frag_off, ip->frag_off, ip->protocol,
-                ntohs(ip->check), ntohs(ip->check)),
+    // Multiple lines from the ipv4 header, identification and
+    // fragment offset are shown as read on the wire in hexadecimal
+    PRV3(output_printf("\n" GRN "IPv4 Header" NC "\n"
+                       "IP source : %s\n"
+                       "IP destination : %s\n"
+                       "IHL : %d\n"
+                       "Identification : 0x%02x (%d)\n"
+                       "Type of service : 0x%02x (%d)\n"
+                       "Total length : %d\n"
+                       "Time to live : %d\n"
+                       "Fragment offset : 0x%02x (%d)\n"
+                       "Protocol : %d\n"
+                       "Checksum : 0x%02x (%d)\n",
+                       src_ip, dst_ip, pkt->ip_hdr_len / 4,
+                       htons(pkt->ip_id), pkt->ip_id, pkt->ip_tos,
+                       pkt->ip_tos, pkt->ip_len, pkt->ip_ttl,
+                       htons(pkt->ip_frag_off), htons(pkt->ip_frag_off),
+                       pkt->ip_proto, pkt->ip_check, pkt->ip_check),
          verbose);
+}
+
+/**
+ * @brief Decode and print the IPv4 header
+ */
+void ip_analyzer(packet_t *pkt, const u_char *packet, int verbose) {
+
+    ip_decode(pkt, packet);
+    ip_print(pkt, verbose);
+}
+
+/**
+ * @brief Payload of the datagram, once all its fragments are received
+ * @return the payload, its length in length, NULL if fragments are
+ * missing
+ */
+const u_char *ip_payload(packet_t *pkt, const u_char *packet,
+                         int *length) {
 
-    return ip;
+    if ((pkt->ip_frag_off & (IP_MF | IP_OFFMASK)) != 0)
+        return frag_ip(pkt, packet, length);
+
+    return packet;
 }
 
-void get_protocol_ip(const u_char *packet, struct iphdr *ip_header,
-                     int length, int verbose) {
-
-    struct tcphdr *tcp_header;
-    struct udphdr *udp_header;
-
-    switch (ip_header->protocol) {
-
-    // TCP protocol
-    case IPPROTO_TCP:
-        tcp_header = tcp_analyzer(packet, length, verbose);
-        packet += tcp_header->th_off * 4;
-        length -= tcp_header->th_off * 4;
-
-        // Get the application layer protocol
-        get_protocol_tcp(packet, tcp_header, length, verbose);
-        break;
-
-    // UDP protocol
-    case IPPROTO_UDP:
-        udp_header = udp_analyzer(packet, length, verbose);
-        packet += sizeof(struct udphdr);
-        length -= sizeof(struct udphdr);
-
-        // Get the application layer protocol
-        get_protocol_udp(packet, udp_header, length, verbose);
-        break;
-
-    // SCTP protocol
-    case IPPROTO_SCTP:
-        sctp_analyzer(packet, length, verbose);
-        break;
-
-    // IPIP protocol
-    case IPPROTO_IPIP:
-        // avoid print twice ipv4 in verbose level 1
-        if (verbose == 1)
-            verbose = -1;
-
-        ip_header = ip_analyzer(packet, verbose);
-        packet += ip_header->ihl * 4;
-        length -= ip_header->ihl * 4;
-
-        // avoid print twice ipv4 in verbose level 1
-        if (verbose == -1)
-            verbose = 1;
-
-        get_protocol_ip(packet, ip_header, length, verbose);
-        break;
-
-    // IPv6 protocol
-    case IPPROTO_IPV6:
-        ipv6_analyzer(packet, verbose);
-        break;
-
-    // ICMP protocol
-    case IPPROTO_ICMP:
-        icmp_analyzer(packet, length, verbose);
-        break;
-
-    // Other protocols
-    case IPPROTO_IGMP:
-        PRV1(printf("-\t\t\tIGMP"), verbose);
-        break;
-    case IPPROTO_EGP:
-        PRV1(printf("-\t\t\tEGP"), verbose);
-        break;
-    case IPPROTO_PUP:
-        PRV1(printf("-\t\t\tPUP"), verbose);
-        break;
-    case IPPROTO_IDP:
-        PRV1(printf("-\t\t\tIDP"), verbose);
-        break;
-    case IPPROTO_TP:
-        PRV1(printf("-\t\t\tTP"), verbose);
-        break;
-    case IPPROTO_DCCP:
-        PRV1(printf("-\t\t\tDCCP"), verbose);
-        break;
-    case IPPROTO_RSVP:
-        PRV1(printf("-\t\t\tRSVP"), verbose);
-        break;
-    case IPPROTO_GRE:
-        PRV1(printf("-\t\t\tGRE"), verbose);
-        break;
-    case IPPROTO_ESP:
-        PRV1(printf("-\t\t\tESP"), verbose);
-        break;
-    case IPPROTO_AH:
-        PRV1(printf("-\t\t\tAH"), verbose);
-        break;
-    case IPPROTO_MTP:
-        PRV1(printf("-\t\t\tMTP"), verbose);
-        break;
-    case IPPROTO_BEETPH:
-        PRV1(printf("-\t\t\tBEETPH"), verbose);
-        break;
-    case IPPROTO_ENCAP:
-        PRV1(printf("-\t\t\tENCAP"), verbose);
-        break;
-    case IPPROTO_PIM:
-        PRV1(printf("-\t\t\tPIM"), verbose);
-        break;
-    case IPPROTO_COMP:
-        PRV1(printf("-\t\t\tCOMP"), verbose);
-        break;
-    case IPPROTO_UDPLITE:
-        PRV1(printf("-\t\t\tUDPLITE"), verbose);
-        break;
-    case IPPROTO_MPLS:
-        PRV1(printf("-\t\t\tMPLS"), verbose);
-        break;
-    case IPPROTO_RAW:
-        PRV1(printf("-\t\t\tRAW"), verbose);
-        break;
-    default:
-        PRV1(printf("-\t\t\tIpv4"), verbose);
-        break;
+/**
+ * @brief Get the protocol of the datagram, once all its fragments are
+ * received, from the table of the IP protocols
+ */
+void get_protocol_ip(packet_t *pkt, const u_char *packet, int length,
+                     int verbose) {
+
+    const dissector_t *dissector;
+
+    if ((packet = ip_payload(pkt, packet, &length)) == NULL) {
+        frag_print(pkt, verbose);
+        return;
     }
-}
\ No newline at end of file
+
+    dissector = &ip_protocols[pkt->ip_proto];
+    if (dissector->decode != NULL)
+        dissector->decode(pkt, packet, length, verbose);
+    else if (dissector->label != NULL)
+        PRV1(output_str(dissector->label), verbose);
+    else
+        PRV1(output_str("-\t\t\tIpv4"), verbose);
+}
+
+/**
+ * @brief Analyze the IPv4 header of a frame and the protocol it
+ * carries
+ */
+void ip_dissect(packet_t *pkt, const u_char *packet, int length,
+                int verbose) {
+
+    ip_analyzer(pkt, packet, verbose);
+    packet += pkt->ip_hdr_len;
+    length -= pkt->ip_hdr_len;
+
+    // Get the transport layer protocol and the application layer
+    get_protocol_ip(pkt, packet, length, verbose);
+}
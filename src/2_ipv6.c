@@ -1,128 +1,246 @@
 #include "../include/2_ipv6.h"
 
+// Protocols carried by IPv6, the others are printed as IPv6. The
+// extension headers are only left when they cannot be walked.
+static const dissector_t ipv6_protocols[256] = {
+    [IPPROTO_TCP] = {tcp_dissect, NULL},
+    [IPPROTO_UDP] = {udp_dissect, NULL},
+    [IPPROTO_SCTP] = {sctp_dissect, NULL},
+    [IPPROTO_HOPOPTS] = {NULL, "HOPOPTS\t\t\t-"},
+    [IPPROTO_ROUTING] = {NULL, "ROUTING\t\t\t-"},
+    [IPPROTO_FRAGMENT] = {NULL, "FRAGMENT\t\t-"},
+    [IPPROTO_ICMPV6] = {NULL, "ICMPV6\t\t\t-"},
+    [IPPROTO_NONE] = {NULL, "IPv6\t\t\t-"},
+    [IPPROTO_DSTOPTS] = {NULL, "DSTOPTS\t\t\t-"},
+    [IPPROTO_MH] = {NULL, "MH\t\t\t-"},
+};
+
 /**
- * @brief Print informations contained in IPv6 header and return the
- * header in a structure
- * @return struct iphdr*
+ * @brief Fill the IPv6 fields of the dissection
  */
-struct ip6_hdr *ipv6_analyzer(const u_char *packet, int verbose) {
+void ipv6_decode(packet_t *pkt, const u_char *packet) {
 
     struct ip6_hdr *ipv6_header = (struct ip6_hdr *)packet;
 
+    pkt->ip_version = 6;
+    pkt->ip_proto = ipv6_header->ip6_nxt;
+    pkt->ip_hdr_len = sizeof(struct ip6_hdr);
+    pkt->ip_ttl = ipv6_header->ip6_hops;
+    pkt->ip_len = ntohs(ipv6_header->ip6_plen);
+    pkt->ip_flow = ipv6_header->ip6_flow;
+    // only a fragment header sets them, not the outer IPv4 header of
+    // a tunnel
+    pkt->ip_frag_off = 0;
+    pkt->ip_id = 0;
+    memcpy(&pkt->ip_src.v6, &ipv6_header->ip6_src,
+           sizeof(struct in6_addr));
+    memcpy(&pkt->ip_dst.v6, &ipv6_header->ip6_dst,
+           sizeof(struct in6_addr));
+    pkt->l3_offset = packet - pkt->data;
+    pkt->l4_offset = pkt->l3_offset + pkt->ip_hdr_len;
+}
+
+/**
+ * @brief Print the IPv6 fields of the dissection
+ */
+void ipv6_print(const packet_t *pkt, int verbose) {
+
     char src_ip[INET6_ADDRSTRLEN];
     char dst_ip[INET6_ADDRSTRLEN];
-    inet_ntop(AF_INET6, &(ipv6_header->ip6_src), src_ip,
-              INET6_ADDRSTRLEN);
-    inet_ntop(AF_INET6, &(ipv6_header->ip6_dst), dst_ip,
-              INET6_ADDRSTRLEN);
-
-    if (verbose == 1) {
-
-        int k;
-        if (strlen(src_ip) != INET6_ADDRSTRLEN) {
-            for (k = strlen(src_ip); k < INET6_ADDRSTRLEN; k++)
-                src_ip[k] = ' ';
-            src_ip[k] = '\0';
-        }
-        if (strlen(dst_ip) != INET6_ADDRSTRLEN) {
-            for (k = strlen(dst_ip); k < INET6_ADDRSTRLEN; k++)
-                dst_ip[k] = ' ';
-            dst_ip[k] = '\0';
-        }
-    }
 
-    // One line by frame
-    PRV1(printf("%s\t"
-                "%s\t",
-                src_ip, dst_ip),
+    if (verbose < 1)
+        return;
+
+    inet_ntop(AF_INET6, &pkt->ip_src.v6, src_ip, INET6_ADDRSTRLEN);
+    inet_ntop(AF_INET6, &pkt->ip_dst.v6, dst_ip, INET6_ADDRSTRLEN);
+
+    // One line by frame, addresses are padded to the longest one
+    PRV1(output_printf("%-*s\t"
+                       "%-*s\t",
+                       INET6_ADDRSTRLEN, src_ip, INET6_ADDRSTRLEN,
+                       dst_ip),
          verbose);
 
     // One line from the ipv6 header
-    PRV2(printf(YEL "IPv6" NC "\t\t"
-                    "IP src : %s, "
-                    "IP dst : %s\n",
-                src_ip, dst_ip),
+    PRV2(output_printf(YEL "IPv6" NC "\t\t"
+                           "IP src : %s, "
+                           "IP dst : %s\n",
+                       src_ip, dst_ip),
          verbose);
 
     // Multiple lines from the ipv6 header
-    PRV3(printf("\n" GRN "IPv6 Header" NC "\n"
-                "Source IP : %s\n"
-                "Destination IP : %s\n"
-                "Payload Length : %d\n"
-                "Next Header : %d\n"
-                "Hop Limit: %d\n"
-                "Traffic Class : 0x%02x (%d)\n"
-                "Flow Label : 0x%02x (%d)\n",
-                src_ip, dst_ip, ntohs(ipv6_header->ip6_plen),
-                ipv6_header->ip6_nxt, ipv6_header->ip6_hops,
-                ipv6_header->ip6_flow >> 8,
-                ipv6_header->ip6_flow >> 8,
-                ipv6_header->ip6_flow >> 20,
-                ipv6_header->ip6_flow >> 20),
+    PRV3(output_printf("\n" GRN "IPv6 Header" NC "\n"
+                       "Source IP : %s\n"
+                       "Destination IP : %s\n"
+                       "Payload Length : %d\n"
+                       "Next Header : %d\n"
+                       "Hop Limit: %d\n"
+                       "Traffic Class : 0x%02x (%d)\n"
+                       "Flow Label : 0x%02x (%d)\n",
+                       src_ip, dst_ip, pkt->ip_len, pkt->ip_proto,
+                       pkt->ip_ttl, pkt->ip_flow >> 8,
+                       pkt->ip_flow >> 8, pkt->ip_flow >> 20,
+                       pkt->ip_flow >> 20),
+         verbose);
+}
+
+/**
+ * @brief Decode and print the IPv6 header
+ */
+void ipv6_analyzer(packet_t *pkt, const u_char *packet, int verbose) {
+
+    ipv6_decode(pkt, packet);
+    ipv6_print(pkt, verbose);
+}
+
+/**
+ * @brief Walk the extension headers in one pass, from the one of type
+ * ip_proto, up to the upper-layer protocol or to the fragment header
+ * of a fragment. The header length then counts the headers walked.
+ * @return bytes of the headers walked, -1 if one is truncated or if
+ * there are too many, ip_proto is then the type of that header
+ */
+int ipv6_walk(packet_t *pkt, const u_char *packet, int length) {
+
+    const struct ip6_frag *frag;
+    int offset = 0, size, i;
+    uint8_t next;
+
+    // bytes captured, a header must fit in both
+    if (length > (int)(pkt->data + pkt->caplen - packet))
+        length = pkt->data + pkt->caplen - packet;
+
+    for (i = 0; i < IPV6_MAX_HEADERS; i++) {
+
+        switch (pkt->ip_proto) {
+        case IPPROTO_HOPOPTS:
+        case IPPROTO_ROUTING:
+        case IPPROTO_DSTOPTS:
+        case IPPROTO_AH:
+        case IPPROTO_FRAGMENT:
+            break;
+        default:
+            return offset;
+        }
+
+        // every extension header starts with the type of the next one
+        if (offset + 8 > length)
+            return -1;
+        next = packet[offset];
+
+        switch (pkt->ip_proto) {
+
+        // length in blocks of 8 bytes, the first one not counted
+        default:
+            size = (packet[offset + 1] + 1) * 8;
+            break;
+
+        // authentication header, in words of 4 bytes
+        case IPPROTO_AH:
+            size = (packet[offset + 1] + 2) * 4;
+            break;
+
+        // offset and M flag are kept as the ones of IPv4
+        case IPPROTO_FRAGMENT:
+            frag = (const struct ip6_frag *)(packet + offset);
+            size = sizeof(struct ip6_frag);
+            pkt->ip_id = ntohl(frag->ip6f_ident);
+            pkt->ip_frag_off =
+                ntohs(frag->ip6f_offlg & IP6F_OFF_MASK) >> 3;
+            if (frag->ip6f_offlg & IP6F_MORE_FRAG)
+                pkt->ip_frag_off |= IP_MF;
+            break;
+        }
+
+        if (offset + size > length)
+            return -1;
+
+        offset += size;
+        pkt->ip_proto = next;
+        pkt->ip_hdr_len += size;
+        pkt->l4_offset += size;
+
+        // the rest is only known once reassembled
+        if (pkt->ip_frag_off != 0)
+            return offset;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Walk the extension headers up to the upper-layer protocol,
+ * once all the fragments of the datagram are received
+ * @return the upper-layer payload, its length in length, NULL if
+ * fragments are missing
+ */
+const u_char *ipv6_payload(packet_t *pkt, const u_char *packet,
+                           int *length, int verbose) {
+
+    int offset = ipv6_walk(pkt, packet, *length);
+
+    if (offset <= 0)
+        return packet;
+
+    packet += offset;
+    *length -= offset;
+
+    // the fragmentable part may start with extension headers
+    if (pkt->ip_frag_off != 0) {
+        if ((packet = frag_ip(pkt, packet, length)) == NULL)
+            return NULL;
+        if ((offset = ipv6_walk(pkt, packet, *length)) > 0) {
+            packet += offset;
+            *length -= offset;
+        }
+        // a fragment inside a fragment is never complete
+        if (pkt->ip_frag_off != 0)
+            return NULL;
+    }
+
+    PRV3(output_printf("Extension headers : %d bytes\n",
+                       pkt->ip_hdr_len - (int)sizeof(struct ip6_hdr)),
          verbose);
 
-    return ipv6_header;
+    return packet;
 }
 
-void get_protocol_ipv6(const u_char *packet,
-                       struct ip6_hdr *ipv6_header, int length,
-                       int verbose) {
-
-    struct tcphdr *tcp_header;
-    struct udphdr *udp_header;
-
-    // TCP protocol
-    switch (ipv6_header->ip6_nxt) {
-    case IPPROTO_TCP:
-
-        tcp_header = tcp_analyzer(packet, length, verbose);
-        packet += tcp_header->th_off * 4;
-        length -= tcp_header->th_off * 4;
-
-        get_protocol_tcp(packet, tcp_header, length, verbose);
-        break;
-
-    // UDP protocol
-    case IPPROTO_UDP:
-
-        udp_header = udp_analyzer(packet, length, verbose);
-        packet += sizeof(struct udphdr);
-        length -= sizeof(struct udphdr);
-
-        // Get the application layer protocol
-        get_protocol_udp(packet, udp_header, length, verbose);
-        break;
-
-    // SCTP protocol
-    case IPPROTO_SCTP:
-        sctp_analyzer(packet, length, verbose);
-        break;
-
-    // Other protocols
-    case IPPROTO_HOPOPTS:
-        PRV1(printf("HOPOPTS\t\t\t-"), verbose);
-        break;
-    case IPPROTO_ROUTING:
-        PRV1(printf("ROUTING\t\t\t-"), verbose);
-        break;
-    case IPPROTO_FRAGMENT:
-        PRV1(printf("FRAGMENT\t\t-"), verbose);
-        break;
-    case IPPROTO_ICMPV6:
-        PRV1(printf("ICMPV6\t\t\t-"), verbose);
-        break;
-    case IPPROTO_NONE:
-        PRV1(printf("IPv6\t\t\t-"), verbose);
-        break;
-    case IPPROTO_DSTOPTS:
-        PRV1(printf("DSTOPTS\t\t\t-"), verbose);
-        break;
-    case IPPROTO_MH:
-        PRV1(printf("MH\t\t\t-"), verbose);
-        break;
-
-    default:
-        PRV1(printf("-\t\t\tIPv6"), verbose);
-        break;
+/**
+ * @brief Get the upper-layer protocol behind the extension headers,
+ * once all the fragments of the datagram are received, from the
+ * table of the IP protocols
+ */
+void get_protocol_ipv6(packet_t *pkt, const u_char *packet,
+                       int length, int verbose) {
+
+    const dissector_t *dissector;
+
+    packet = ipv6_payload(pkt, packet, &length, verbose);
+    if (packet == NULL) {
+        frag_print(pkt, verbose);
+        return;
     }
-}
\ No newline at end of file
+
+    dissector = &ipv6_protocols[pkt->ip_proto];
+    if (dissector->decode != NULL)
+        dissector->decode(pkt, packet, length, verbose);
+    else if (dissector->label != NULL)
+        PRV1(output_str(dissector->label), verbose);
+    else
+        PRV1(output_str("-\t\t\tIPv6"), verbose);
+}
+
+/**
+ * @brief Analyze the IPv6 header of a frame and the protocol it
+ * carries
+ */
+void ipv6_dissect(packet_t *pkt, const u_char *packet, int length,
+                  int verbose) {
+
+    ipv6_analyzer(pkt, packet, verbose);
+    packet += sizeof(struct ip6_hdr);
+    length -= sizeof(struct ip6_hdr);
+
+    // Get the transport layer protocol and the application layer
+    get_protocol_ipv6(pkt, packet, length, verbose);
+}
@@ -3,59 +3,60 @@
 /**
  * @brief Print informations contained in ICMP header
  */
-void icmp_analyzer(const u_char *packet, int length, int verbose) {
+void icmp_analyzer(packet_t *pkt, const u_char *packet, int length,
+                   int verbose) {
 
     // ICMP header
     struct icmp_hdr *icmp_header = (struct icmp_hdr *)packet;
 
-    PRV1(printf("-\t\t\tICMP"), verbose);
+    PRV1(output_str("-\t\t\tICMP"), verbose);
 
-    PRV2(printf(MAG "ICMP" NC "\t\tLength : %d bits\n", length),
+    PRV2(output_printf(MAG "ICMP" NC "\t\tLength : %d bits\n", length),
          verbose);
 
-    PRV3(printf("\n" GRN "ICMP Header" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "ICMP Header" NC "\n"), verbose);
 
     // ICMP type
-    PRV3(printf("ICMP Type : "), verbose);
+    PRV3(output_str("ICMP Type : "), verbose);
     switch (icmp_header->type) {
     case ICMP_ECHO_REPLY:
-        PRV3(printf("Echo Reply\n"), verbose);
+        PRV3(output_str("Echo Reply\n"), verbose);
         break;
     case ICMP_DEST_UNREACH:
-        PRV3(printf("Destination Unreachable\n"), verbose);
+        PRV3(output_str("Destination Unreachable\n"), verbose);
         break;
     case ICMP_SOURCE_QUENCH:
-        PRV3(printf("Source Quench\n"), verbose);
+        PRV3(output_str("Source Quench\n"), verbose);
         break;
     case ICMP_REDIRECT:
-        PRV3(printf("Redirect\n"), verbose);
+        PRV3(output_str("Redirect\n"), verbose);
         break;
     case ICMP_ECHO:
-        PRV3(printf("Echo\n"), verbose);
+        PRV3(output_str("Echo\n"), verbose);
         break;
     case ICMP_TIME_EXCEEDED:
-        PRV3(printf("Time Exceeded\n"), verbose);
+        PRV3(output_str("Time Exceeded\n"), verbose);
         break;
     case ICMP_PARAM_PROB:
-        PRV3(printf("Parameter Problem\n"), verbose);
+        PRV3(output_str("Parameter Problem\n"), verbose);
         break;
     case ICMP_TIMESTAMP:
-        PRV3(printf("Timestamp Request\n"), verbose);
+        PRV3(output_str("Timestamp Request\n"), verbose);
         break;
     case ICMP_TIMESTAMP_REPLY:
-        PRV3(printf("Timestamp Reply\n"), verbose);
+        PRV3(output_str("Timestamp Reply\n"), verbose);
         break;
     case ICMP_INFO_REQUEST:
-        PRV3(printf("Information Request\n"), verbose);
+        PRV3(output_str("Information Request\n"), verbose);
         break;
     case ICMP_INFO_REPLY:
-        PRV3(printf("Information Reply\n"), verbose);
+        PRV3(output_str("Information Reply\n"), verbose);
         break;
     case ICMP_ADDRESS:
-        PRV3(printf("Address Mask Request\n"), verbose);
+        PRV3(output_str("Address Mask Request\n"), verbose);
         break;
     case ICMP_ADDRESS_REPLY:
-        PRV3(printf("Address Mask Reply\n"), verbose);
+        PRV3(output_str("Address Mask Reply\n"), verbose);
         break;
     }
 
@@ -64,60 +65,61 @@ void icmp_analyzer(const u_char *packet, int length, int verbose) {
         icmp_header->type == ICMP_REDIRECT ||
         icmp_header->type == ICMP_TIME_EXCEEDED ||
         icmp_header->type == ICMP_PARAM_PROB)
-        PRV3(printf("ICMP Code : "), verbose);
+        PRV3(output_str("ICMP Code : "), verbose);
 
     if (icmp_header->type == ICMP_DEST_UNREACH) {
 
         switch (icmp_header->code) {
         case ICMP_NET_UNREACH:
-            PRV3(printf("Network Unreachable\n"), verbose);
+            PRV3(output_str("Network Unreachable\n"), verbose);
             break;
         case ICMP_HOST_UNREACH:
-            PRV3(printf("Host Unreachable\n"), verbose);
+            PRV3(output_str("Host Unreachable\n"), verbose);
             break;
         case ICMP_PROT_UNREACH:
-            PRV3(printf("Protocol Unreachable\n"), verbose);
+            PRV3(output_str("Protocol Unreachable\n"), verbose);
             break;
         case ICMP_PORT_UNREACH:
-            PRV3(printf("Port Unreachable\n"), verbose);
+            PRV3(output_str("Port Unreachable\n"), verbose);
             break;
         case ICMP_FRAG_NEEDED:
-            PRV3(printf("Fragmentation Needed\n"), verbose);
+            PRV3(output_str("Fragmentation Needed\n"), verbose);
             break;
         case ICMP_SR_FAILED:
-            PRV3(printf("Source Route Failed\n"), verbose);
+            PRV3(output_str("Source Route Failed\n"), verbose);
             break;
         case ICMP_NET_UNKNOWN:
-            PRV3(printf("Network Unknown\n"), verbose);
+            PRV3(output_str("Network Unknown\n"), verbose);
             break;
         case ICMP_HOST_UNKNOWN:
-            PRV3(printf("Host Unknown\n"), verbose);
+            PRV3(output_str("Host Unknown\n"), verbose);
             break;
         case ICMP_HOST_ISOLATED:
-            PRV3(printf("Host Isolated\n"), verbose);
+            PRV3(output_str("Host Isolated\n"), verbose);
             break;
         case ICMP_NET_ANO:
-            PRV3(printf("Network Administratively Prohibited\n"),
+            PRV3(output_str("Network Administratively Prohibited\n"),
                  verbose);
             break;
         case ICMP_HOST_ANO:
-            PRV3(printf("Host Administratively Prohibited\n"),
+            PRV3(output_str("Host Administratively Prohibited\n"),
                  verbose);
             break;
         case ICMP_NET_UNR_TOS:
-            PRV3(printf("Network Unreachable for TOS\n"), verbose);
+            PRV3(output_str("Network Unreachable for TOS\n"),
+                 verbose);
             break;
         case ICMP_HOST_UNR_TOS:
-            PRV3(printf("Host Unreachable for TOS\n"), verbose);
+            PRV3(output_str("Host Unreachable for TOS\n"), verbose);
             break;
         case ICMP_PKT_FILTERED:
-            PRV3(printf("Packet Filtered\n"), verbose);
+            PRV3(output_str("Packet Filtered\n"), verbose);
             break;
         case ICMP_PREC_VIOLATION:
-            PRV3(printf("Precedence Violation\n"), verbose);
+            PRV3(output_str("Precedence Violation\n"), verbose);
             break;
         case ICMP_PREC_CUTOFF:
-            PRV3(printf("Precedence Cutoff\n"), verbose);
+            PRV3(output_str("Precedence Cutoff\n"), verbose);
             break;
         }
     }
@@ -125,17 +127,17 @@ void icmp_analyzer(const u_char *packet, int length, int verbose) {
     if (icmp_header->type == ICMP_REDIRECT) {
         switch (icmp_header->code) {
         case ICMP_REDIR_NET:
-            PRV3(printf("Redirect Network\n"), verbose);
+            PRV3(output_str("Redirect Network\n"), verbose);
             break;
         case ICMP_REDIR_HOST:
-            PRV3(printf("Redirect Host\n"), verbose);
+            PRV3(output_str("Redirect Host\n"), verbose);
             break;
         case ICMP_REDIR_NET_TOS:
-            PRV3(printf("Redirect Type of Service and Network\n"),
+            PRV3(output_str("Redirect Type of Service and Network\n"),
                  verbose);
             break;
         case ICMP_REDIR_HOST_TOS:
-            PRV3(printf("Redirect Type of Service and Host\n"),
+            PRV3(output_str("Redirect Type of Service and Host\n"),
                  verbose);
             break;
         }
@@ -144,10 +146,10 @@ void icmp_analyzer(const u_char *packet, int length, int verbose) {
     if (icmp_header->type == ICMP_TIME_EXCEEDED) {
         switch (icmp_header->code) {
         case ICMP_EXC_TTL:
-            PRV3(printf("Time to Live exceeded\n"), verbose);
+            PRV3(output_str("Time to Live exceeded\n"), verbose);
             break;
         case ICMP_EXC_FRAGTIME:
-            PRV3(printf("Fragment Reassembly Time Exceeded\n"),
+            PRV3(output_str("Fragment Reassembly Time Exceeded\n"),
                  verbose);
             break;
         }
@@ -156,20 +158,21 @@ void icmp_analyzer(const u_char *packet, int length, int verbose) {
     if (icmp_header->type == ICMP_PARAM_PROB) {
         switch (icmp_header->code) {
         case ICMP_PTR_INDICATES_ERROR:
-            PRV3(printf("Pointer indicates the error\n"), verbose);
+            PRV3(output_str("Pointer indicates the error\n"),
+                 verbose);
             break;
         case ICMP_MISSING_REQ_OPTION:
-            PRV3(printf("Missing a Required Option\n"), verbose);
+            PRV3(output_str("Missing a Required Option\n"), verbose);
             break;
         case ICMP_BAD_LENGTH:
-            PRV3(printf("Bad Length\n"), verbose);
+            PRV3(output_str("Bad Length\n"), verbose);
             break;
         }
     }
 
     // ICMP checksum
-    PRV3(printf("ICMP Checksum : 0x%0x (%d)\n", icmp_header->checksum,
-                icmp_header->checksum),
+    PRV3(output_printf("ICMP Checksum : 0x%0x (%d)\n",
+                       icmp_header->checksum, icmp_header->checksum),
          verbose);
 
     // ICMP echo request/reply, info request/reply, address mask
@@ -185,9 +188,9 @@ void icmp_analyzer(const u_char *packet, int length, int verbose) {
         uint16_t id = ntohs(*(uint16_t *)packet);
         // ICMP sequence number
         uint16_t seq = ntohs(*(uint16_t *)(packet + 2));
-        PRV3(printf("ICMP Identifier : %d\n"
-                    "ICMP Sequence Number : %d\n",
-                    id, seq),
+        PRV3(output_printf("ICMP Identifier : %d\n"
+                           "ICMP Sequence Number : %d\n",
+                           id, seq),
              verbose);
     }
 
@@ -201,12 +204,21 @@ void icmp_analyzer(const u_char *packet, int length, int verbose) {
         if (verbose == 1)
             verbose = 0;
 
-        struct iphdr *ip_header = ip_analyzer(packet, verbose);
-        if (ip_header == NULL)
-            return;
+        // The quoted header has its own dissection, the one of the
+        // frame is kept, and is not part of a flow nor of a datagram
+        // nor of a transaction
+        context_t quoted_ctx = *pkt->ctx;
+        quoted_ctx.flows = NULL;
+        quoted_ctx.streams = NULL;
+        quoted_ctx.frags = NULL;
+        quoted_ctx.resolvers = NULL;
+        packet_t quoted = *pkt;
+        quoted.ctx = &quoted_ctx;
+        quoted.flow = NULL;
+        ip_analyzer(&quoted, packet, verbose);
         packet += sizeof(struct iphdr);
         length -= sizeof(struct iphdr);
 
-        get_protocol_ip(packet, ip_header, length, verbose);
+        get_protocol_ip(&quoted, packet, length, verbose);
     }
 }
\ No newline at end of file
@@ -1,57 +1,82 @@
 #include "../include/3_tcp.h"
 
-// global variable to store the port of the ftp connection
-volatile sig_atomic_t port_ftp = 0;
-
 /**
- * @brief Print informations contained in TCP header and return the
- * header in a structure
- * @return struct tcphdr*
+ * @brief Fill the TCP fields of the dissection
  */
-struct tcphdr *tcp_analyzer(const u_char *packet, int length,
-                            int verbose) {
+void tcp_decode(packet_t *pkt, const u_char *packet) {
 
     struct tcphdr *tcp_header = (struct tcphdr *)packet;
 
-    PRV1(printf("%d -> %d\t\t", ntohs(tcp_header->th_sport),
-                ntohs(tcp_header->th_dport)),
-         verbose);
+    pkt->sport = ntohs(tcp_header->th_sport);
+    pkt->dport = ntohs(tcp_header->th_dport);
+    pkt->tcp_seq = ntohl(tcp_header->th_seq);
+    pkt->tcp_ack = ntohl(tcp_header->th_ack);
+    pkt->tcp_off = tcp_header->th_off;
+    pkt->tcp_flags = tcp_header->th_flags;
+    pkt->tcp_win = ntohs(tcp_header->th_win);
+    pkt->l4_check = ntohs(tcp_header->th_sum);
+    pkt->tcp_urp = ntohs(tcp_header->th_urp);
+    pkt->l4_offset = packet - pkt->data;
+    pkt->l7_offset = pkt->l4_offset + pkt->tcp_off * 4;
+}
+
+/**
+ * @brief Print the TCP fields of the dissection
+ */
+void tcp_print(const packet_t *pkt, int verbose) {
+
+    if (verbose < 1)
+        return;
+
+    // One line by frame
+    if (verbose == 1) {
+        output_uint(pkt->sport);
+        output_str(" -> ");
+        output_uint(pkt->dport);
+        output_str("\t\t");
+        return;
+    }
 
     // One line from the tcp header
-    PRV2(printf(MAG "TCP" NC "\t\t"
-                    "src port : %d, "
-                    "dst port : %d, "
-                    "Flags : ",
-                ntohs(tcp_header->th_sport),
-                ntohs(tcp_header->th_dport)),
+    PRV2(output_printf(MAG "TCP" NC "\t\t"
+                           "src port : %d, "
+                           "dst port : %d, "
+                           "Flags : ",
+                       pkt->sport, pkt->dport),
          verbose);
-    tcp_flags(tcp_header->th_flags, verbose + 1);
+    tcp_flags(pkt->tcp_flags, verbose + 1);
 
     // Multiple lines from the tcp header
-    PRV3(printf("\n" GRN "TCP Header" NC "\n"
-                "Source port : %d\n"
-                "Destination port : %d\n"
-                "Sequence number : %u\n"
-                "Acknowledgment number : %u\n"
-                "Data offset : %d bits (%d)\n"
-                "Flags : ",
-                ntohs(tcp_header->th_sport),
-                ntohs(tcp_header->th_dport),
-                ntohl(tcp_header->th_seq), ntohl(tcp_header->th_ack),
-                tcp_header->th_off * 4, tcp_header->th_off),
+    PRV3(output_printf("\n" GRN "TCP Header" NC "\n"
+                       "Source port : %d\n"
+                       "Destination port : %d\n"
+                       "Sequence number : %u\n"
+                       "Acknowledgment number : %u\n"
+                       "Data offset : %d bits (%d)\n"
+                       "Flags : ",
+                       pkt->sport, pkt->dport, pkt->tcp_seq,
+                       pkt->tcp_ack, pkt->tcp_off * 4, pkt->tcp_off),
          verbose);
-    tcp_flags(tcp_header->th_flags, verbose);
-
-    PRV3(printf("Window size : %d\n"
-                "Checksum : 0x%0x\n"
-                "Urgent pointer : %d\n"
-                "Options : ",
-                ntohs(tcp_header->th_win), ntohs(tcp_header->th_sum),
-                ntohs(tcp_header->th_urp)),
+    tcp_flags(pkt->tcp_flags, verbose);
+
+    PRV3(output_printf("Window size : %d\n"
+                       "Checksum : 0x%0x\n"
+                       "Urgent pointer : %d\n"
+                       "Options : ",
+                       pkt->tcp_win, pkt->l4_check, pkt->tcp_urp),
          verbose);
-    tcp_options(packet, tcp_header->th_off, verbose);
+    tcp_options(pkt->data + pkt->l4_offset, pkt->tcp_off, verbose);
+}
 
-    return tcp_header;
+/**
+ * @brief Decode and print the TCP header
+ */
+void tcp_analyzer(packet_t *pkt, const u_char *packet, int length,
+                  int verbose) {
+
+    tcp_decode(pkt, packet);
+    flow_packet(pkt);
+    tcp_print(pkt, verbose);
 }
 
 /**
@@ -63,49 +88,49 @@ void tcp_flags(uint8_t flags, int verbose) {
 
     if (flags & TH_SYN) {
         if (nb_flags != 0)
-            PRV3(printf(", "), verbose);
-        PRV3(printf("SYN"), verbose);
+            PRV3(output_str(", "), verbose);
+        PRV3(output_str("SYN"), verbose);
         nb_flags++;
     }
 
     if (flags & TH_ACK) {
         if (nb_flags != 0)
-            PRV3(printf(", "), verbose);
-        PRV3(printf("ACK"), verbose);
+            PRV3(output_str(", "), verbose);
+        PRV3(output_str("ACK"), verbose);
         nb_flags++;
     }
 
     if (flags & TH_FIN) {
         if (nb_flags != 0)
-            PRV3(printf(", "), verbose);
-        PRV3(printf("FIN"), verbose);
+            PRV3(output_str(", "), verbose);
+        PRV3(output_str("FIN"), verbose);
         nb_flags++;
     }
 
     if (flags & TH_RST) {
         if (nb_flags != 0)
-            PRV3(printf(", "), verbose);
-        PRV3(printf("RST"), verbose);
+            PRV3(output_str(", "), verbose);
+        PRV3(output_str("RST"), verbose);
         nb_flags++;
     }
 
     if (flags & TH_PUSH) {
         if (nb_flags != 0)
-            PRV3(printf(", "), verbose);
-        PRV3(printf("PUSH"), verbose);
+            PRV3(output_str(", "), verbose);
+        PRV3(output_str("PUSH"), verbose);
         nb_flags++;
     }
 
     if (flags & TH_URG) {
         if (nb_flags != 0)
-            PRV3(printf(", "), verbose);
-        PRV3(printf("URG"), verbose);
+            PRV3(output_str(", "), verbose);
+        PRV3(output_str("URG"), verbose);
         nb_flags++;
     }
 
     if (nb_flags == 0)
-        PRV3(printf("none"), verbose);
-    PRV3(printf("\n"), verbose);
+        PRV3(output_str("none"), verbose);
+    PRV3(output_str("\n"), verbose);
 }
 
 /**
@@ -118,130 +143,185 @@ void tcp_options(const u_char *packet, uint8_t offset, int verbose) {
 
     int i, nb_options = 0;
     for (i = 20; i < (offset * 4); i++) {
+
+        // options with a length must fit in the header
+        if (packet[i] != TCPOPT_EOL && packet[i] != TCPOPT_NOP &&
+            (i + 1 >= offset * 4 || packet[i + 1] < 2 ||
+             i + packet[i + 1] > offset * 4))
+            break;
+
         switch (packet[i]) {
 
         case TCPOPT_EOL:
-            PRV3(printf("\n- End of options list"), verbose);
+            PRV3(output_str("\n- End of options list"), verbose);
             nb_options++;
             break;
         case TCPOPT_NOP:
-            PRV3(printf("\n- No operation"), verbose);
+            PRV3(output_str("\n- No operation"), verbose);
             break;
         case TCPOPT_MAXSEG:
-            PRV3(printf("\n- Maximum segment size : %d bytes",
-                        (packet[i + 2] << 8) + packet[i + 3]),
+            PRV3(output_printf("\n- Maximum segment size : %d bytes",
+                               (packet[i + 2] << 8) + packet[i + 3]),
                  verbose);
             i += TCPOLEN_MAXSEG - 1;
             nb_options++;
             break;
         case TCPOPT_WINDOW:
-            PRV3(printf("\n- Window scale : %d", packet[i + 2]),
+            PRV3(output_printf("\n- Window scale : %d", packet[i + 2]),
                  verbose);
             i += TCPOLEN_WINDOW - 1;
             nb_options++;
             break;
         case TCPOPT_SACK_PERMITTED:
-            PRV3(printf("\n- SACK permitted"), verbose);
+            PRV3(output_str("\n- SACK permitted"), verbose);
             i += TCPOLEN_SACK_PERMITTED - 1;
             nb_options++;
             break;
         case TCPOPT_SACK:
-            PRV3(printf("\n- SACK"), verbose);
+            PRV3(output_str("\n- SACK"), verbose);
+            i += packet[i + 1] - 1;
             nb_options++;
             break;
         case TCPOPT_TIMESTAMP:
             PRV3(
-                printf("\n- Timestamp : %u, Timestamp echo "
-                       "reply : %u",
-                       (packet[i + 2] << 24) + (packet[i + 3] << 16) +
-                           (packet[i + 4] << 8) + packet[i + 5],
-                       (packet[i + 6] << 24) + (packet[i + 7] << 16) +
-                           (packet[i + 8] << 8) + packet[i + 9]),
+                output_printf("\n- Timestamp : %u, Timestamp echo "
+                              "reply : %u",
+                              (packet[i + 2] << 24) +
+                                  (packet[i + 3] << 16) +
+                                  (packet[i + 4] << 8) + packet[i + 5],
+                              (packet[i + 6] << 24) +
+                                  (packet[i + 7] << 16) +
+                                  (packet[i + 8] << 8) + packet[i + 9]),
                 verbose);
             i += TCPOLEN_TIMESTAMP - 1;
             nb_options++;
             break;
         default:
+            i += packet[i + 1] - 1;
             break;
         }
     }
 
     if (nb_options == 0)
-        PRV3(printf("None\n"), verbose);
+        PRV3(output_str("None\n"), verbose);
     else
-        PRV3(printf("\n"), verbose);
+        PRV3(output_str("\n"), verbose);
+}
+
+/**
+ * @brief Find the application protocol of a TCP segment from the
+ * registry of its ports, and from its flow for an FTP data connection.
+ * SMTP is only analyzed on segments pushing data.
+ * @return APP_NONE if the protocol is unknown
+ */
+uint8_t tcp_app(const packet_t *pkt) {
+
+    const uint8_t *apps = pkt->ctx->registry->apps[REGISTRY_TCP];
+    uint8_t src = apps[pkt->sport], dst = apps[pkt->dport], app;
+
+    if (!(pkt->tcp_flags & TH_ACK) || !(pkt->tcp_flags & TH_PUSH)) {
+        if (src == APP_SMTP)
+            src = APP_NONE;
+        if (dst == APP_SMTP)
+            dst = APP_NONE;
+    }
+
+    app = registry_pick(src, dst);
+    if (pkt->flow != NULL)
+        app = registry_pick(app, pkt->flow->app);
+
+    return app;
 }
 
 /**
- * @brief Get the protocol under TCP header
- *
+ * @brief Classify the segment and expect the FTP data connection
+ * announced by its payload, without printing anything
  */
-void get_protocol_tcp(const u_char *packet, struct tcphdr *tcp_header,
-                      int length, int verbose) {
-
-    // DNS
-    if (ntohs(tcp_header->th_dport) == DNS_PORT ||
-        ntohs(tcp_header->th_sport) == DNS_PORT)
-        dns_analyzer(packet, DNS_TCP, length, verbose);
-
-    // SMTP
-    else if ((ntohs(tcp_header->th_dport) == SMTP_PORT ||
-              ntohs(tcp_header->th_sport) == SMTP_PORT) &&
-             (tcp_header->th_flags & TH_ACK) &&
-             (tcp_header->th_flags & TH_PUSH))
+void tcp_classify(packet_t *pkt, const u_char *packet, int length) {
+
+    int connection_ftp;
+
+    pkt->app = tcp_app(pkt);
+    if (pkt->app == APP_FTP &&
+        (connection_ftp = ftp_data_port(packet, length)) != 0)
+        flow_expect(pkt, connection_ftp, APP_FTP);
+}
+
+/**
+ * @brief Get the protocol under TCP header, the analyzers are given
+ * the bytes of the stream which come next
+ */
+void get_protocol_tcp(packet_t *pkt, const u_char *packet, int length,
+                      int verbose) {
+
+    int connection_ftp;
+
+    packet = stream_segment(pkt, packet, &length);
+
+    switch (pkt->app = tcp_app(pkt)) {
+
+    case APP_DNS:
+        dns_stream(pkt, packet, length, verbose);
+        break;
+
+    case APP_SMTP:
         smtp_analyzer(packet, length, verbose);
+        break;
 
-    // HTTP/1.1
-    else if (ntohs(tcp_header->th_dport) == HTTP_PORT ||
-             ntohs(tcp_header->th_sport) == HTTP_PORT)
+    case APP_HTTP:
         http_analyzer(packet, length, verbose);
+        break;
 
     // In the case of HTTPS (port 443), the packet is crypted
-    else if (ntohs(tcp_header->th_dport) == HTTPS_PORT ||
-             ntohs(tcp_header->th_sport) == HTTPS_PORT) {
+    case APP_HTTPS:
         if (length >= 1) {
-            PRV1(printf("HTTPS"), verbose);
-            PRV2(printf(CYN1 "HTTPS" NC
-                             "\t\tTransport Layer Security\n"),
+            PRV1(output_str("HTTPS"), verbose);
+            PRV2(output_str(CYN1 "HTTPS" NC
+                                "\t\tTransport Layer Security\n"),
+                 verbose);
+            PRV3(output_str(GRN "HTTPS" NC
+                                "\nTransport Layer Security\n"),
                  verbose);
-            PRV3(
-                printf(GRN "HTTPS" NC "\nTransport Layer Security\n"),
-                verbose);
         } else
-            PRV1(printf("TCP"), verbose);
-    }
+            PRV1(output_str("TCP"), verbose);
+        break;
 
-    // FTP
-    else if (ntohs(tcp_header->th_dport) == FTP_PORT ||
-             ntohs(tcp_header->th_sport) == FTP_PORT ||
-             ntohs(tcp_header->th_dport) == DATA_FTP_PORT ||
-             ntohs(tcp_header->th_sport) == DATA_FTP_PORT ||
-             (ntohs(tcp_header->th_dport) == port_ftp &&
-              port_ftp != 0) ||
-             (ntohs(tcp_header->th_sport) == port_ftp &&
-              port_ftp != 0)) {
-
-        // if a new port is established, we save it
-        int connection_ftp = ftp_analyzer(packet, length, verbose);
+    case APP_FTP:
+        // if a new port is established, the connection is expected
+        connection_ftp = ftp_analyzer(packet, length, verbose);
         if (connection_ftp != 0)
-            port_ftp = connection_ftp;
-    }
+            flow_expect(pkt, connection_ftp, APP_FTP);
+        break;
 
-    // POP3
-    else if (ntohs(tcp_header->th_dport) == POP3_PORT ||
-             ntohs(tcp_header->th_sport) == POP3_PORT)
+    case APP_POP3:
         pop3_analyzer(packet, length, verbose);
+        break;
 
-    // IMAP
-    else if (ntohs(tcp_header->th_dport) == IMAP_PORT ||
-             ntohs(tcp_header->th_sport) == IMAP_PORT)
+    case APP_IMAP:
         imap_analyzer(packet, length, verbose);
+        break;
 
-    // TELNET
-    else if (ntohs(tcp_header->th_dport) == TELNET_PORT ||
-             ntohs(tcp_header->th_sport) == TELNET_PORT)
+    case APP_TELNET:
         telnet_analyzer(packet, length, verbose);
+        break;
 
-    else
-        PRV1(printf("TCP"), verbose);
+    default:
+        PRV1(output_str("TCP"), verbose);
+        break;
+    }
+}
+
+/**
+ * @brief Analyze the TCP header and the application protocol of the
+ * segment
+ */
+void tcp_dissect(packet_t *pkt, const u_char *packet, int length,
+                 int verbose) {
+
+    tcp_analyzer(pkt, packet, length, verbose);
+    packet += pkt->tcp_off * 4;
+    length -= pkt->tcp_off * 4;
+
+    // Get the application layer protocol
+    get_protocol_tcp(pkt, packet, length, verbose);
 }
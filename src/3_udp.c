@@ -1,60 +1,113 @@
 #include "../include/3_udp.h"
 
 /**
- * @brief Print informations contained in UDP header and return the
- * header in a structure
- * @return struct udphdr*
+ * @brief Fill the UDP fields of the dissection
  */
-struct udphdr *udp_analyzer(const u_char *packet, int length,
-                            int verbose) {
+void udp_decode(packet_t *pkt, const u_char *packet) {
 
     struct udphdr *udp_header = (struct udphdr *)packet;
 
-    PRV1(printf("%d -> %d\t\t", ntohs(udp_header->uh_sport),
-                ntohs(udp_header->uh_dport)),
-         verbose);
+    pkt->sport = ntohs(udp_header->uh_sport);
+    pkt->dport = ntohs(udp_header->uh_dport);
+    pkt->l4_len = ntohs(udp_header->uh_ulen);
+    pkt->l4_check = ntohs(udp_header->uh_sum);
+    pkt->l4_offset = packet - pkt->data;
+    pkt->l7_offset = pkt->l4_offset + sizeof(struct udphdr);
+}
+
+/**
+ * @brief Print the UDP fields of the dissection
+ */
+void udp_print(const packet_t *pkt, int verbose) {
+
+    // One line by frame
+    if (verbose == 1) {
+        output_uint(pkt->sport);
+        output_str(" -> ");
+        output_uint(pkt->dport);
+        output_str("\t\t");
+        return;
+    }
 
     // One line from the udp header
-    PRV2(printf(MAG "UDP" NC "\t\t"
-                    "src port : %d, "
-                    "dst port : %d, "
-                    "Checksum : 0x%0x\n",
-                ntohs(udp_header->uh_sport),
-                ntohs(udp_header->uh_dport),
-                ntohs(udp_header->uh_sum)),
+    PRV2(output_printf(MAG "UDP" NC "\t\t"
+                           "src port : %d, "
+                           "dst port : %d, "
+                           "Checksum : 0x%0x\n",
+                       pkt->sport, pkt->dport, pkt->l4_check),
          verbose);
 
     // Multiple lines from the udp header
-    PRV3(printf("\n" GRN "UDP Header" NC "\n"
-                "Source port : %d\n"
-                "Destination port : %d\n"
-                "Length : %d\n"
-                "Checksum : 0x%02x (%d)\n",
-                ntohs(udp_header->uh_sport),
-                ntohs(udp_header->uh_dport),
-                ntohs(udp_header->uh_ulen), ntohs(udp_header->uh_sum),
-                ntohs(udp_header->uh_sum)),
+    PRV3(output_printf("\n" GRN "UDP Header" NC "\n"
+                       "Source port : %d\n"
+                       "Destination port : %d\n"
+                       "Length : %d\n"
+                       "Checksum : 0x%02x (%d)\n",
+                       pkt->sport, pkt->dport, pkt->l4_len,
+                       pkt->l4_check, pkt->l4_check),
          verbose);
+}
+
+/**
+ * @brief Decode and print the UDP header
+ */
+void udp_analyzer(packet_t *pkt, const u_char *packet, int length,
+                  int verbose) {
+
+    udp_decode(pkt, packet);
+    flow_packet(pkt);
+    udp_print(pkt, verbose);
+}
 
-    return udp_header;
+/**
+ * @brief Find the application protocol of a UDP datagram from the
+ * registry of its ports
+ * @return APP_NONE if the protocol is unknown
+ */
+uint8_t udp_app(const packet_t *pkt) {
+
+    const uint8_t *apps = pkt->ctx->registry->apps[REGISTRY_UDP];
+
+    return registry_pick(apps[pkt->sport], apps[pkt->dport]);
 }
 
 /**
  * @brief Get the protocol under UDP header
  */
-void get_protocol_udp(const u_char *packet, struct udphdr *udp_header,
-                      int length, int verbose) {
+void get_protocol_udp(packet_t *pkt, const u_char *packet, int length,
+                      int verbose) {
+
+    switch (pkt->app = udp_app(pkt)) {
 
-    // Bootp + DHCP
-    if (ntohs(udp_header->uh_dport) == BOOTP_PORT ||
-        ntohs(udp_header->uh_sport) == BOOTP_PORT)
+    case APP_BOOTP:
+        // the options are not read past the bytes captured
+        if (length > (int)(pkt->data + pkt->caplen - packet))
+            length = pkt->data + pkt->caplen - packet;
         bootp_analyzer(packet, length, verbose);
+        break;
+
+    case APP_DNS:
+        resolver_packet(pkt, packet, length);
+        dns_analyzer(packet, length, verbose);
+        break;
 
-    // DNS
-    else if (ntohs(udp_header->uh_dport) == DNS_PORT ||
-             ntohs(udp_header->uh_sport) == DNS_PORT)
-        dns_analyzer(packet, DNS_UDP, length, verbose);
+    default:
+        PRV1(output_str("UDP"), verbose);
+        break;
+    }
+}
+
+/**
+ * @brief Analyze the UDP header and the application protocol of the
+ * datagram
+ */
+void udp_dissect(packet_t *pkt, const u_char *packet, int length,
+                 int verbose) {
+
+    udp_analyzer(pkt, packet, length, verbose);
+    packet += sizeof(struct udphdr);
+    length -= sizeof(struct udphdr);
 
-    else
-        PRV1(printf("UDP"), verbose);
-}
\ No newline at end of file
+    // Get the application layer protocol
+    get_protocol_udp(pkt, packet, length, verbose);
+}
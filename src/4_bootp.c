@@ -8,921 +8,570 @@ void bootp_analyzer(const u_char *packet, int length, int verbose) {
     // if there is no data left of a padding empty, it is just a
     // tcp/udp packet
     if (length < 1 || packet[0] == 0) {
-        PRV1(printf("UDP"), verbose);
+        PRV1(output_str("UDP"), verbose);
+        return;
+    }
+
+    if (length < (int)sizeof(struct bootp)) {
+        PRV1(output_str("BOOTP"), verbose);
+        PRV2(output_str(CYN1 "Bootp" NC "\t\tTruncated\n"), verbose);
+        PRV3(output_str("\n" GRN "Bootp protocol" NC "\nTruncated\n"),
+             verbose);
         return;
     }
 
     struct bootp *bootp_header = (struct bootp *)packet;
 
-    if (bootp_header->bp_vend[0] == 0x63 &&
-        bootp_header->bp_vend[1] == 0x82 &&
-        bootp_header->bp_vend[2] == 0x53 &&
-        bootp_header->bp_vend[3] == 0x63)
+    if (dhcp_cookie(bootp_header->bp_vend,
+                    length - sizeof(struct bootp)))
         // One line by frame
-        PRV1(printf("DHCP"), verbose);
+        PRV1(output_str("DHCP"), verbose);
     else
         // One line by frame
-        PRV1(printf("BOOTP"), verbose);
+        PRV1(output_str("BOOTP"), verbose);
 
     // One line from the bootp packet
-    PRV2(printf(CYN1 "Bootp" NC "\t\t"), verbose);
+    PRV2(output_str(CYN1 "Bootp" NC "\t\t"), verbose);
 
     // Multiple lines from the bootp packet
-    PRV3(printf("\n" GRN "Bootp protocol" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "Bootp protocol" NC "\n"), verbose);
 
-    PRV3(printf("Message type : "), verbose);
+    PRV3(output_str("Message type : "), verbose);
     if (bootp_header->bp_op == BOOTREQUEST) {
-        PRV2(printf("Request, "), verbose);
-        PRV3(printf("Request"), verbose);
+        PRV2(output_str("Request, "), verbose);
+        PRV3(output_str("Request"), verbose);
     } else if (bootp_header->bp_op == BOOTREPLY) {
-        PRV2(printf("Reply, "), verbose);
-        PRV3(printf("Reply"), verbose);
+        PRV2(output_str("Reply, "), verbose);
+        PRV3(output_str("Reply"), verbose);
     }
-    PRV3(printf("\n"), verbose);
+    PRV3(output_str("\n"), verbose);
 
     if (bootp_header->bp_htype == HTYPE_ETHER)
-        PRV3(printf("Hardware type : Ethernet\n"), verbose);
+        PRV3(output_str("Hardware type : Ethernet\n"), verbose);
 
-    PRV3(printf("Flags : "), verbose);
+    PRV3(output_str("Flags : "), verbose);
     if (bootp_header->bp_flags == BOOTPUNICAST) {
-        PRV2(printf("Unicast, "), verbose);
-        PRV3(printf("Unicast (0x%02x)", bootp_header->bp_flags),
+        PRV2(output_str("Unicast, "), verbose);
+        PRV3(output_printf("Unicast (0x%02x)", bootp_header->bp_flags),
              verbose);
     } else if (ntohs(bootp_header->bp_flags) & BOOTPBROADCAST) {
-        PRV2(printf("Broadcast, "), verbose);
-        PRV3(printf("Broadcast (0x%02x)", bootp_header->bp_flags),
+        PRV2(output_str("Broadcast, "), verbose);
+        PRV3(output_printf("Broadcast (0x%02x)",
+                           bootp_header->bp_flags),
              verbose);
     }
-    PRV3(printf("\n"), verbose);
+    PRV3(output_str("\n"), verbose);
 
-    PRV2(printf("Transaction ID : %02x:%02x:%02x:%02x\n",
-                bootp_header->bp_xid[0], bootp_header->bp_xid[1],
-                bootp_header->bp_xid[2], bootp_header->bp_xid[3]),
+    PRV2(output_printf("Transaction ID : %02x:%02x:%02x:%02x\n",
+                       bootp_header->bp_xid[0],
+                       bootp_header->bp_xid[1],
+                       bootp_header->bp_xid[2],
+                       bootp_header->bp_xid[3]),
          verbose);
 
-    PRV3(printf("Transaction ID : %02x:%02x:%02x:%02x\n",
-                bootp_header->bp_xid[0], bootp_header->bp_xid[1],
-                bootp_header->bp_xid[2], bootp_header->bp_xid[3]),
+    PRV3(output_printf("Transaction ID : %02x:%02x:%02x:%02x\n",
+                       bootp_header->bp_xid[0],
+                       bootp_header->bp_xid[1],
+                       bootp_header->bp_xid[2],
+                       bootp_header->bp_xid[3]),
          verbose);
 
-    PRV3(printf("Client IP address : %s\n",
-                inet_ntoa(bootp_header->bp_ciaddr)),
+    char ip[INET_ADDRSTRLEN];
+    PRV3(output_printf("Client IP address : %s\n",
+                       inet_ntop(AF_INET, &bootp_header->bp_ciaddr, ip,
+                                 INET_ADDRSTRLEN)),
          verbose);
 
-    PRV3(printf("Your IP address : %s\n",
-                inet_ntoa(bootp_header->bp_yiaddr)),
+    PRV3(output_printf("Your IP address : %s\n",
+                       inet_ntop(AF_INET, &bootp_header->bp_yiaddr, ip,
+                                 INET_ADDRSTRLEN)),
          verbose);
 
-    PRV3(printf("Server IP address : %s\n",
-                inet_ntoa(bootp_header->bp_siaddr)),
+    PRV3(output_printf("Server IP address : %s\n",
+                       inet_ntop(AF_INET, &bootp_header->bp_siaddr, ip,
+                                 INET_ADDRSTRLEN)),
          verbose);
 
-    PRV3(printf("Gateway IP address : %s\n",
-                inet_ntoa(bootp_header->bp_giaddr)),
+    PRV3(output_printf("Gateway IP address : %s\n",
+                       inet_ntop(AF_INET, &bootp_header->bp_giaddr, ip,
+                                 INET_ADDRSTRLEN)),
          verbose);
 
-    PRV3(printf("Client hardware address : %s\n",
-                ether_ntoa(
-                    (struct ether_addr *)bootp_header->bp_chaddr)),
+    char buf[18];
+    PRV3(output_printf("Client hardware address : %s\n",
+                       ether_ntoa_r((struct ether_addr *)
+                                        bootp_header->bp_chaddr,
+                                    buf)),
          verbose);
 
-    PRV3(printf("Hardware address length : %d\n"
-                "Hops : %d\n"
-                "Seconds since boot began : %d\n",
-                bootp_header->bp_hlen, bootp_header->bp_hops,
-                bootp_header->bp_secs),
+    PRV3(output_printf("Hardware address length : %d\n"
+                       "Hops : %d\n"
+                       "Seconds since boot began : %d\n",
+                       bootp_header->bp_hlen, bootp_header->bp_hops,
+                       bootp_header->bp_secs),
          verbose);
 
     if (bootp_header->bp_sname[0] == '\0')
-        PRV3(printf("Server host name : not given\n"), verbose);
+        PRV3(output_str("Server host name : not given\n"), verbose);
     else
         PRV3(
-            printf("Server host name : %s\n", bootp_header->bp_sname),
+            output_printf("Server host name : %s\n",
+                          bootp_header->bp_sname),
             verbose);
 
     if (bootp_header->bp_file[0] == '\0')
-        PRV3(printf("Boot file name : not given\n"), verbose);
+        PRV3(output_str("Boot file name : not given\n"), verbose);
     else
-        PRV3(printf("Boot file name : %s\n", bootp_header->bp_file),
+        PRV3(output_printf("Boot file name : %s\n",
+                           bootp_header->bp_file),
              verbose);
 
-    // Vendor is a variable length field
-    const u_char *bp_vend = bootp_header->bp_vend;
+    // Vendor is a variable length field, up to the end of the datagram
+    bootp_vendor_specific(bootp_header->bp_vend,
+                          length - sizeof(struct bootp), verbose);
+}
+
+// Options known, by tag. The value of an option shorter than its
+// minimum is not decoded.
+static const dhcp_desc_t dhcp_options[DHCP_TAGS] = {
+    // RFC1048
+    [TAG_SUBNET_MASK] = {"Subnet mask", DHCP_ADDR, 4},
+    [TAG_TIME_OFFSET] = {"Time offset", DHCP_S32, 4},
+    [TAG_GATEWAY] = {"Router", DHCP_ADDR, 4},
+    [TAG_TIME_SERVER] = {"Time server", DHCP_ADDR, 4},
+    [TAG_NAME_SERVER] = {"Name server", DHCP_ADDR, 4},
+    [TAG_DOMAIN_SERVER] = {"DNS", DHCP_ADDR, 4},
+    [TAG_LOG_SERVER] = {"Log server", DHCP_ADDR, 4},
+    [TAG_COOKIE_SERVER] = {"Cookie server", DHCP_ADDR, 4},
+    [TAG_LPR_SERVER] = {"LPR server", DHCP_ADDR, 4},
+    [TAG_IMPRESS_SERVER] = {"Impress server", DHCP_ADDR, 4},
+    [TAG_RLP_SERVER] = {"RLP server", DHCP_ADDR, 4},
+    [TAG_HOSTNAME] = {"Hostname", DHCP_NAME, 1},
+    [TAG_BOOTSIZE] = {"Boot size", DHCP_U16, 2},
+    // RFC1497
+    [TAG_DUMPPATH] = {"Dump path", DHCP_NAME, 1},
+    [TAG_DOMAINNAME] = {"Domain name", DHCP_NAME, 1},
+    [TAG_SWAP_SERVER] = {"Swap server", DHCP_ADDR, 4},
+    [TAG_ROOTPATH] = {"Root path", DHCP_NAME, 1},
+    [TAG_EXTPATH] = {"Extension path", DHCP_NAME, 1},
+    // RFC2132
+    [TAG_IP_FORWARD] = {"IP forward", DHCP_U8, 1},
+    [TAG_NL_SRCRT] = {"Non-local source routing", DHCP_U8, 1},
+    [TAG_PFILTERS] = {"Policy filters", DHCP_ADDR, 8},
+    [TAG_REASS_SIZE] = {"Maximum datagram reassembly size", DHCP_U16,
+                        2},
+    [TAG_DEF_TTL] = {"Default IP time-to-live", DHCP_U8, 1},
+    [TAG_MTU_TIMEOUT] = {"Path MTU aging timeout", DHCP_U32, 4},
+    [TAG_MTU_TABLE] = {"MTU table", DHCP_HEX, 2},
+    [TAG_INT_MTU] = {"Interface MTU", DHCP_U16, 2},
+    [TAG_LOCAL_SUBNETS] = {"All subnets are local", DHCP_U8, 1},
+    [TAG_BROAD_ADDR] = {"Broadcast", DHCP_ADDR, 4},
+    [TAG_DO_MASK_DISC] = {"Perform mask discovery", DHCP_U8, 1},
+    [TAG_SUPPLY_MASK] = {"Supply mask to other hosts", DHCP_U8, 1},
+    [TAG_DO_RDISC] = {"Perform router discovery", DHCP_U8, 1},
+    [TAG_RTR_SOL_ADDR] = {"Router solicitation address", DHCP_ADDR,
+                          4},
+    [TAG_STATIC_ROUTE] = {"Static route", DHCP_ADDR, 8},
+    [TAG_USE_TRAILERS] = {"Trailer encapsulation", DHCP_U8, 1},
+    [TAG_ARP_TIMEOUT] = {"ARP cache timeout", DHCP_U32, 4},
+    [TAG_ETH_ENCAP] = {"Ethernet encapsulation", DHCP_U8, 1},
+    [TAG_TCP_TTL] = {"TCP default TTL", DHCP_U8, 1},
+    [TAG_TCP_KEEPALIVE] = {"TCP keepalive interval", DHCP_U32, 4},
+    [TAG_KEEPALIVE_GO] = {"TCP keepalive garbage", DHCP_U8, 1},
+    [TAG_NIS_DOMAIN] = {"NIS domain", DHCP_NAME, 1},
+    [TAG_NIS_SERVERS] = {"NIS servers", DHCP_ADDR, 4},
+    [TAG_NTP_SERVERS] = {"NTP servers", DHCP_ADDR, 4},
+    [TAG_VENDOR_OPTS] = {"Vendor specific information", DHCP_HEX, 1},
+    [TAG_NETBIOS_NS] = {"Netbios name server", DHCP_ADDR, 4},
+    [TAG_NETBIOS_DDS] = {"Netbios datagram distribution server",
+                         DHCP_ADDR, 4},
+    [TAG_NETBIOS_NODE] = {"Netbios node type", DHCP_U8, 1},
+    [TAG_NETBIOS_SCOPE] = {"Netbios scope", DHCP_NAME, 1},
+    [TAG_XWIN_FS] = {"X Window font server", DHCP_ADDR, 4},
+    [TAG_XWIN_DM] = {"X Window display manager", DHCP_ADDR, 4},
+    [TAG_NIS_P_DOMAIN] = {"NIS+ domain", DHCP_NAME, 1},
+    [TAG_NIS_P_SERVERS] = {"NIS+ servers", DHCP_ADDR, 4},
+    [TAG_MOBILE_HOME] = {"Mobile IP home agent", DHCP_ADDR, 0},
+    [TAG_SMPT_SERVER] = {"SMTP server", DHCP_ADDR, 4},
+    [TAG_POP3_SERVER] = {"POP3 server", DHCP_ADDR, 4},
+    [TAG_NNTP_SERVER] = {"NNTP server", DHCP_ADDR, 4},
+    [TAG_WWW_SERVER] = {"WWW server", DHCP_ADDR, 4},
+    [TAG_FINGER_SERVER] = {"Finger server", DHCP_ADDR, 4},
+    [TAG_IRC_SERVER] = {"IRC server", DHCP_ADDR, 4},
+    [TAG_STREETTALK_SRVR] = {"Streettalk server", DHCP_ADDR, 4},
+    [TAG_STREETTALK_STDA] = {"Streettalk directory assistance",
+                             DHCP_ADDR, 4},
+    // DHCP options
+    [TAG_REQUESTED_IP] = {"Requested IP address", DHCP_ADDR, 4},
+    [TAG_IP_LEASE] = {"Lease time", DHCP_U32, 4},
+    [TAG_OPT_OVERLOAD] = {"Overload", DHCP_U8, 1},
+    [TAG_TFTP_SERVER] = {"TFTP server", DHCP_NAME, 1},
+    [TAG_BOOTFILENAME] = {"Bootfile", DHCP_NAME, 1},
+    [TAG_DHCP_MESSAGE] = {"DHCP message type", DHCP_MESSAGE, 1},
+    [TAG_SERVER_ID] = {"DHCP server", DHCP_ADDR, 4},
+    [TAG_PARM_REQUEST] = {"Parameter request list", DHCP_REQUEST, 1},
+    [TAG_MESSAGE] = {"Message", DHCP_NAME, 1},
+    [TAG_MAX_MSG_SIZE] = {"Maximum DHCP message size", DHCP_U16, 2},
+    [TAG_RENEWAL_TIME] = {"Renewal time", DHCP_U32, 4},
+    [TAG_REBIND_TIME] = {"Rebinding time", DHCP_U32, 4},
+    [TAG_VENDOR_CLASS] = {"Vendor class identifier", DHCP_NAME, 1},
+    [TAG_CLIENT_ID] = {"Client identifier", DHCP_CLIENT, 2},
+    // RFC 2241
+    [TAG_NDS_SERVERS] = {"NDS servers", DHCP_ADDR, 4},
+    [TAG_NDS_TREE_NAME] = {"NDS tree name", DHCP_NAME, 1},
+    [TAG_NDS_CONTEXT] = {"NDS context", DHCP_NAME, 1},
+    // RFC 2485
+    [TAG_OPEN_GROUP_UAP] = {"Open Group's User Authentication "
+                            "Protocol",
+                            DHCP_NAME, 1},
+    // RFC 2563
+    [TAG_DISABLE_AUTOCONF] = {"Disable Autoconfiguration", DHCP_U8,
+                              1},
+    // RFC 2610
+    [TAG_SLP_DA] = {"Service Location Protocol Directory Agent",
+                    DHCP_HEX, 1},
+    [TAG_SLP_SCOPE] = {"Service Location Protocol Scope", DHCP_HEX,
+                       1},
+    // RFC 2937
+    [TAG_NS_SEARCH] = {"NetBIOS over TCP/IP Name Server Search Order",
+                       DHCP_HEX, 2},
+    // RFC 3011
+    [TAG_IP4_SUBNET_SELECT] = {"IP4 subnet select", DHCP_ADDR, 4},
+    // Bootp extensions
+    [TAG_USER_CLASS] = {"User class", DHCP_NAME, 1},
+    [TAG_SLP_NAMING_AUTH] = {"Service Location Protocol Naming "
+                             "Authority",
+                             DHCP_NAME, 1},
+    [TAG_CLIENT_FQDN] = {"Client Fully Qualified Domain Name",
+                         DHCP_NAME, 1},
+    [TAG_AGENT_CIRCUIT] = {"Agent Information Option", DHCP_AGENT, 2},
+    [TAG_AGENT_MASK] = {"Agent Subnet Mask", DHCP_ADDR, 4},
+    [TAG_TZ_STRING] = {"Time Zone String", DHCP_NAME, 1},
+    [TAG_FQDN_OPTION] = {"Fully Qualified Domain Name", DHCP_NAME, 1},
+    [TAG_AUTH] = {"Authentication", DHCP_AUTH, 3},
+    [TAG_VINES_SERVERS] = {"Vines servers", DHCP_ADDR, 4},
+    [TAG_SERVER_RANK] = {"Server rank", DHCP_HEX, 1},
+    [TAG_CLIENT_ARCH] = {"Client architecture", DHCP_U16, 2},
+    [TAG_CLIENT_NDI] = {"Client network device interface", DHCP_HEX,
+                        3},
+    [TAG_CLIENT_GUID] = {"Client GUID", DHCP_HEX, 1},
+    [TAG_LDAP_URL] = {"LDAP URL", DHCP_NAME, 1},
+    [TAG_6OVER4] = {"6over4", DHCP_ADDR, 4},
+    [TAG_PRINTER_NAME] = {"Printer name", DHCP_NAME, 1},
+    [TAG_MDHCP_SERVER] = {"MDHCP server", DHCP_ADDR, 4},
+    [TAG_IPX_COMPAT] = {"IPX compatibility", DHCP_HEX, 1},
+    [TAG_NETINFO_PARENT] = {"NetInfo parent server", DHCP_ADDR, 4},
+    [TAG_NETINFO_PARENT_TAG] = {"NetInfo parent server tag",
+                                DHCP_NAME, 1},
+    [TAG_URL] = {"URL", DHCP_NAME, 1},
+    [TAG_FAILOVER] = {"Failover", DHCP_HEX, 1},
+    [TAG_EXTENDED_REQUEST] = {"Extended request", DHCP_HEX, 1},
+    [TAG_EXTENDED_OPTION] = {"Extended option", DHCP_HEX, 1},
+    [TAG_SIP_SERVER] = {"SIP server", DHCP_SIP, 1},
+};
+
+// Names of the DHCP message types, by value
+static const char *dhcp_messages[] = {
+    NULL,      "Discover", "Offer",   "Request", "Decline",
+    "Ack",     "Nack",     "Release", "Inform"};
+
+/**
+ * @brief Whether the vendor area starts with the magic cookie of the
+ * DHCP options
+ */
+int dhcp_cookie(const u_char *bp_vend, int length) {
 
-    bootp_vendor_specific(
-        bp_vend, length - sizeof(struct bootp *) + 64, verbose);
+    return length >= 4 && bp_vend[0] == 0x63 && bp_vend[1] == 0x82 &&
+           bp_vend[2] == 0x53 && bp_vend[3] == 0x63;
 }
 
 /**
- * @brief Used for print IP address in the vendor specific print's
- * function
+ * @brief Decode the option at offset, the padding before it is
+ * skipped. Its value is read in place, the integers are decoded.
+ * @return 1 if an option is decoded and offset moved after it, 0 at
+ * the end of the options, -1 if the option goes past the bytes
  */
-void print_dhcp_option_addr(const u_char *bp_vend, int i,
-                            int length) {
+int dhcp_option_next(const u_char *options, int length, int *offset,
+                     dhcp_option_t *option) {
 
-    if (i + 1 > length || i + bp_vend[i + 1] > length)
-        return;
+    const dhcp_desc_t *desc;
+    int i = *offset;
 
-    int j;
-    for (j = 1; j <= bp_vend[i + 1]; j++) {
-        if ((j != 1 && j != bp_vend[i + 1] + 1) && j % 4 != 1)
-            printf(".");
+    while (i < length && options[i] == TAG_PAD)
+        i++;
+
+    if (i >= length || options[i] == TAG_END)
+        return 0;
+
+    option->tag = options[i];
+    if (i + 2 > length || i + 2 + options[i + 1] > length)
+        return -1;
+
+    desc = &dhcp_options[option->tag];
+    option->len = options[i + 1];
+    option->data = options + i + 2;
+    option->type = option->len < desc->min ? DHCP_SHORT : desc->type;
+    option->value = 0;
+
+    switch (option->type) {
+    case DHCP_U8:
+    case DHCP_MESSAGE:
+        option->value = option->data[0];
+        break;
+    case DHCP_U16:
+        option->value = option->data[0] << 8 | option->data[1];
+        break;
+    case DHCP_U32:
+    case DHCP_S32:
+        option->value = (uint32_t)option->data[0] << 24 |
+                        option->data[1] << 16 | option->data[2] << 8 |
+                        option->data[3];
+        break;
+    }
+
+    *offset = i + 2 + option->len;
+
+    return 1;
+}
 
-        printf("%d", bp_vend[i + j + 1]);
+/**
+ * @brief Print IPv4 addresses one after the other
+ */
+void print_dhcp_option_addr(const u_char *data, int len) {
 
-        if (j % 4 == 0 && j != bp_vend[i + 1])
-            printf(" ");
+    int j;
+
+    for (j = 0; j < len; j++) {
+        if (j != 0)
+            output_str(j % 4 == 0 ? " " : ".");
+        output_printf("%d", data[j]);
     }
-    printf("\n");
+    output_str("\n");
 }
 
 /**
- * @brief Used for print name in the vendor specific print's
- * function
+ * @brief Print text, the bytes not printable are replaced
  */
-void print_dhcp_option_name(const u_char *bp_vend, int i,
-                            int length) {
+void print_dhcp_option_name(const u_char *data, int len) {
 
-    if (i + 1 > length || i + bp_vend[i + 1] > length)
-        return;
+    int j;
+
+    for (j = 0; j < len; j++)
+        output_printf("%c", isprint(data[j]) ? data[j] : '?');
+    output_str("\n");
+}
+
+/**
+ * @brief Print opaque bytes in hexadecimal
+ */
+void print_dhcp_option_hex(const u_char *data, int len) {
 
     int j;
-    for (j = 1; j <= bp_vend[i + 1]; j++) {
-        printf("%c", bp_vend[i + j + 1]);
-    }
-    printf("\n");
+
+    for (j = 0; j < len; j++)
+        output_printf(j == 0 ? "%02x" : ":%02x", data[j]);
+    output_str("\n");
 }
 
 /**
- * @brief Used for print integer in the vendor specific print's
- * function
+ * @brief Print an option decoded. Only the message type is printed
+ * on the line of the frame, the other options are printed with the
+ * detail.
  */
-void print_dhcp_option_int(const u_char *bp_vend, int i, int length) {
+void dhcp_option_print(const dhcp_option_t *option, int verbose) {
 
-    if (i + 5 > length || bp_vend[i + 1] != 4)
+    const char *name = dhcp_options[option->tag].name;
+    const char *message = NULL;
+
+    if (option->type == DHCP_MESSAGE &&
+        option->value < sizeof(dhcp_messages) / sizeof(*dhcp_messages))
+        message = dhcp_messages[option->value];
+
+    if (option->type == DHCP_MESSAGE && message != NULL)
+        PRV2(output_printf("%s, ", message), verbose);
+
+    if (verbose < 3)
         return;
 
-    uint32_t j = 0;
-    j += bp_vend[i + 2] << 24;
-    j += bp_vend[i + 3] << 16;
-    j += bp_vend[i + 4] << 8;
-    j += bp_vend[i + 5];
-    printf("%d", j);
-    printf("\n");
+    if (name == NULL)
+        output_printf("Option %d : ", option->tag);
+    else if (option->type == DHCP_REQUEST ||
+             option->type == DHCP_AGENT || option->type == DHCP_AUTH)
+        output_printf("%s :\n", name);
+    else
+        output_printf("%s : ", name);
+
+    switch (option->type) {
+    case DHCP_SHORT:
+        output_printf("Malformed (%d bytes)\n", option->len);
+        break;
+    case DHCP_ADDR:
+        print_dhcp_option_addr(option->data, option->len);
+        break;
+    case DHCP_NAME:
+        print_dhcp_option_name(option->data, option->len);
+        break;
+    case DHCP_U8:
+    case DHCP_U16:
+    case DHCP_U32:
+        output_printf("%u\n", option->value);
+        break;
+    case DHCP_S32:
+        output_printf("%d\n", (int32_t)option->value);
+        break;
+    case DHCP_MESSAGE:
+        if (message != NULL)
+            output_printf("%s\n", message);
+        else
+            output_printf("%u\n", option->value);
+        break;
+    case DHCP_REQUEST:
+        parameter_request_list_print(option->data, option->len);
+        break;
+    case DHCP_AGENT:
+        dhcp_agent_print(option->data, option->len);
+        break;
+    case DHCP_AUTH:
+        dhcp_auth_print(option->data);
+        break;
+    case DHCP_CLIENT:
+        // a type 0 is followed by a name, the others by an address
+        if (option->data[0] == 0)
+            print_dhcp_option_name(option->data + 1, option->len - 1);
+        else
+            print_dhcp_option_hex(option->data, option->len);
+        break;
+    case DHCP_SIP:
+        // the servers are given by their names or their addresses
+        if (option->data[0] == 1)
+            print_dhcp_option_addr(option->data + 1, option->len - 1);
+        else
+            print_dhcp_option_hex(option->data + 1, option->len - 1);
+        break;
+    default:
+        print_dhcp_option_hex(option->data, option->len);
+        break;
+    }
 }
 
 /**
  * @brief
  * This function is used to print the vendor specific information.
- * There is a lot of line, they all print options and their content
- * which can be an IP address, a name or a number.
+ * The options are walked one after the other from their length, and
+ * printed from the table of the options known.
  */
 void bootp_vendor_specific(const u_char *bp_vend, int length,
                            int verbose) {
 
-    if (bp_vend[0] == 0x63 && bp_vend[1] == 0x82 &&
-        bp_vend[2] == 0x53 && bp_vend[3] == 0x63) {
-        PRV2(printf(RED "Dhcp" NC "\t\t"), verbose);
+    dhcp_option_t option;
+    int offset = 4, ret;
+
+    // the vendor area of a BOOTP message is not read, and nothing of
+    // the options is on the line of the frame
+    if (dhcp_cookie(bp_vend, length) && verbose >= 2) {
+
+        PRV2(output_str(RED "Dhcp" NC "\t\t"), verbose);
         // Multiple lines from the dhcp header
-        PRV3(printf("\n" GRN "DHCP protocol" NC "\n"), verbose);
-    }
+        PRV3(output_str("\n" GRN "DHCP protocol" NC "\n"), verbose);
 
-    int i = 0, j;
-    while (bp_vend[i] != TAG_END && i < length) {
-
-        switch (bp_vend[i]) {
-
-        case TAG_PAD:
-            break;
-
-        // RFC1048
-        case TAG_SUBNET_MASK:
-            PRV3(printf("Subnet mask : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_TIME_OFFSET:
-            PRV3(printf("Time offset : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += 5;
-            break;
-        case TAG_GATEWAY:
-            PRV3(printf("Router : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_TIME_SERVER:
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NAME_SERVER:
-            PRV3(printf("Name server : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_DOMAIN_SERVER:
-            PRV3(printf("DNS : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_LOG_SERVER:
-            PRV3(printf("Log server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_COOKIE_SERVER:
-            PRV3(printf("Cookie server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_LPR_SERVER:
-            PRV3(printf("LPR server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_IMPRESS_SERVER:
-            PRV3(printf("Impress server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_RLP_SERVER:
-            PRV3(printf("RLP server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_HOSTNAME:
-            PRV3(printf("Hostname : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_BOOTSIZE:
-            PRV3(printf("Boot size : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC1497
-        case TAG_DUMPPATH:
-            PRV3(printf("Dump path : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_DOMAINNAME:
-            PRV3(printf("Domain name : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SWAP_SERVER:
-            PRV3(printf("Swap server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_ROOTPATH:
-            PRV3(printf("Root path : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_EXTPATH:
-            PRV3(printf("Extension path : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC2132
-        case TAG_IP_FORWARD:
-            PRV3(printf("IP forward : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NL_SRCRT:
-            PRV3(printf("Non-local source routing : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_PFILTERS:
-            PRV3(printf("Policy filters : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_REASS_SIZE:
-            PRV3(printf("Maximum datagram reassembly size : "),
-                 verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_DEF_TTL:
-            PRV3(printf("Default IP time-to-live : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_MTU_TIMEOUT:
-            PRV3(printf("Path MTU aging timeout : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_MTU_TABLE:
-            PRV3(printf("MTU table : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_INT_MTU:
-            PRV3(printf("Interface MTU : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_LOCAL_SUBNETS:
-            PRV3(printf("All subnets are local : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_BROAD_ADDR:
-            PRV3(printf("Broadcast : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_DO_MASK_DISC:
-            PRV3(printf("Perform mask discovery : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SUPPLY_MASK:
-            PRV3(printf("Supply mask to other hosts : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_DO_RDISC:
-            PRV3(printf("Perform router discovery : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_RTR_SOL_ADDR:
-            PRV3(printf("Router solicitation address : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_STATIC_ROUTE:
-            PRV3(printf("Static route : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_USE_TRAILERS:
-            PRV3(printf("Trailer encapsulation : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_ARP_TIMEOUT:
-            PRV3(printf("ARP cache timeout : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_ETH_ENCAP:
-            PRV3(printf("Ethernet encapsulation : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_TCP_TTL:
-            PRV3(printf("TCP default TTL : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_TCP_KEEPALIVE:
-            PRV3(printf("TCP keepalive interval : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_KEEPALIVE_GO:
-            PRV3(printf("TCP keepalive garbage : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NIS_DOMAIN:
-            PRV3(printf("NIS domain : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            break;
-            i += bp_vend[i + 1] + 1;
-        case TAG_NIS_SERVERS:
-            PRV3(printf("NIS servers : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NTP_SERVERS:
-            PRV3(printf("NTP servers : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_VENDOR_OPTS:
-            PRV3(printf("Vendor specific information : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NETBIOS_NS:
-            PRV3(printf("Netbios name server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NETBIOS_DDS:
-            PRV3(printf("Netbios datagram distribution server : "),
-                 verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NETBIOS_NODE:
-            PRV3(printf("Netbios node type : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NETBIOS_SCOPE:
-            PRV3(printf("Netbios scope : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_XWIN_FS:
-            PRV3(printf("X Window font server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_XWIN_DM:
-            PRV3(printf("X Window display manager : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NIS_P_DOMAIN:
-            PRV3(printf("NIS+ domain : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NIS_P_SERVERS:
-            PRV3(printf("NIS+ servers : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_MOBILE_HOME:
-            PRV3(printf("Mobile IP home agent : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SMPT_SERVER:
-            PRV3(printf("SMPT server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_POP3_SERVER:
-            PRV3(printf("POP3 server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NNTP_SERVER:
-            PRV3(printf("NNTP server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_WWW_SERVER:
-            PRV3(printf("WWW server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_FINGER_SERVER:
-            PRV3(printf("Finger server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_IRC_SERVER:
-            PRV3(printf("IRC server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_STREETTALK_SRVR:
-            PRV3(printf("Streettalk server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_STREETTALK_STDA:
-            PRV3(printf("Streettalk directory assistance : "),
-                 verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // DHCP options
-        case TAG_REQUESTED_IP:
-            PRV3(printf("Requested IP address : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_IP_LEASE:
-            PRV3(printf("Lease time : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += 5;
-            break;
-        case TAG_OPT_OVERLOAD:
-            PRV3(printf("Overload : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_TFTP_SERVER:
-            PRV3(printf("TFTP server : "), verbose);
-            for (j = 0; j < bp_vend[i + 1]; j++)
-                PRV3(printf("%c", bp_vend[i + 2 + j]), verbose);
-            PRV3(printf("\n"), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_BOOTFILENAME:
-            PRV3(printf("Bootfile : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_DHCP_MESSAGE:
-            PRV3(printf("DHCP message type : "), verbose);
-            for (j = 1; j <= bp_vend[i + 1]; j++) {
-                switch (bp_vend[i + 1 + j]) {
-                case DHCPDISCOVER:
-                    PRV2(printf("Discover, "), verbose);
-                    PRV3(printf("Discover "), verbose);
-                    break;
-                case DHCPOFFER:
-                    PRV2(printf("Offer, "), verbose);
-                    PRV3(printf("Offer "), verbose);
-                    break;
-                case DHCPREQUEST:
-                    PRV2(printf("Request, "), verbose);
-                    PRV3(printf("Request "), verbose);
-                    break;
-                case DHCPDECLINE:
-                    PRV2(printf("Decline, "), verbose);
-                    PRV3(printf("Decline "), verbose);
-                    break;
-                case DHCPACK:
-                    PRV2(printf("Ack, "), verbose);
-                    PRV3(printf("Ack "), verbose);
-                    break;
-                case DHCPNAK:
-                    PRV2(printf("Nack, "), verbose);
-                    PRV3(printf("Nack "), verbose);
-                    break;
-                case DHCPRELEASE:
-                    PRV2(printf("Release, "), verbose);
-                    PRV3(printf("Release "), verbose);
-                    break;
-                case DHCPINFORM:
-                    PRV2(printf("Inform, "), verbose);
-                    PRV3(printf("Inform "), verbose);
-                    break;
-                default:
-                    break;
-                }
-                PRV3(printf("\n"), verbose);
-            }
-
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SERVER_ID:
-            PRV3(printf("DHCP server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_PARM_REQUEST:
-            PRV3(printf("Parameter request list :\n"), verbose);
-            parameter_request_list_print(bp_vend, i + 2, verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_MESSAGE:
-            PRV3(printf("Message : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_MAX_MSG_SIZE:
-            PRV3(printf("Maximum DHCP message size : "), verbose);
-            PRV3(
-                printf("%d\n", bp_vend[i + 2] * 256 + bp_vend[i + 3]),
-                verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_RENEWAL_TIME:
-            PRV3(printf("Renewal time : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_REBIND_TIME:
-            PRV3(printf("Rebinding time : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_VENDOR_CLASS:
-            PRV3(printf("Vendor class identifier : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_CLIENT_ID:
-            PRV3(printf("Client identifier : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC 2241
-        case TAG_NDS_SERVERS:
-            PRV3(printf("NDS servers : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NDS_TREE_NAME:
-            PRV3(printf("NDS tree name : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NDS_CONTEXT:
-            PRV3(printf("NDS context : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC 2485
-        case TAG_OPEN_GROUP_UAP:
-            PRV3(printf("Open Group's User Authentication "
-                        "Protocol : "),
-                 verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC 2563
-        case TAG_DISABLE_AUTOCONF:
-            PRV3(printf("Disable Autoconfiguration : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC 2610
-        case TAG_SLP_DA:
-            PRV3(printf("Service Location Protocol Directory "
-                        "Agent : "),
-                 verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SLP_SCOPE:
-            PRV3(printf("Service Location Protocol Scope : "),
-                 verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC 2937
-        case TAG_NS_SEARCH:
-            PRV3(printf("NetBIOS over TCP/IP Name Server Search "
-                        "Order : "),
-                 verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // RFC 3011
-        case TAG_IP4_SUBNET_SELECT:
-            PRV3(printf("IP4 subnet select : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        // Bootp extensions
-        case TAG_USER_CLASS:
-            PRV3(printf("User class : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SLP_NAMING_AUTH:
-            PRV3(printf("Service Location Protocol Naming "
-                        "Authority : "),
-                 verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_CLIENT_FQDN:
-            PRV3(printf("Client Fully Qualified Domain Name : "),
-                 verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_AGENT_CIRCUIT:
-            PRV3(printf("Agent Information Option :\n"), verbose);
-            switch (bp_vend[i + 2]) {
-            case 1:
-                PRV3(printf("- Circuit ID : "), verbose);
-                for (j = 0; j < bp_vend[i + 3]; j++)
-                    PRV3(printf("%0x", bp_vend[i + 4 + j]), verbose);
-                PRV3(printf("\n"), verbose);
-                break;
-            case 2:
-                PRV3(printf("- Remote ID : "), verbose);
-                for (j = 0; j < bp_vend[i + 3]; j++)
-                    PRV3(printf("%0x", bp_vend[i + 4 + j]), verbose);
-                PRV3(printf("\n"), verbose);
-                break;
-            default:
-                break;
-            }
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_AGENT_MASK:
-            PRV3(printf("Agent Subnet Mask : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_TZ_STRING:
-            PRV3(printf("Time Zone String : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_FQDN_OPTION:
-            PRV3(printf("Fully Qualified Domain Name : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_AUTH:
-            PRV3(printf("Authentication :\n"), verbose);
-            switch (bp_vend[i + 2]) {
-            case 1:
-                PRV3(printf("- Protocol : Delayed "
-                            "authentification\n"),
-                     verbose);
-                break;
-            case 2:
-                PRV3(printf("- Protocol : Reconfigure key\n"),
-                     verbose);
-                break;
-            case 3:
-                PRV3(printf("- Protocol : HMAC-MD5\n"), verbose);
-                break;
-            case 4:
-                PRV3(printf("- Protocol : HMAC-SHA1\n"), verbose);
-                break;
-            default:
-                break;
-            }
-
-            PRV3(printf("Algorithm : "), verbose);
-            switch (bp_vend[i + 3]) {
-            case 1:
-                PRV3(printf("HMAC-MD5\n"), verbose);
-                break;
-            case 2:
-                PRV3(printf("HMAC-SHA1\n"), verbose);
-                break;
-            default:
-                break;
-            }
-
-            PRV3(printf("RDM : "), verbose);
-            switch (bp_vend[i + 4]) {
-            case 0:
-                PRV3(printf("Monotonically-increasing counter\n"),
-                     verbose);
-                break;
-            case 1:
-                PRV3(printf("Replay detection\n"), verbose);
-                break;
-            case 2:
-                PRV3(printf("Replay detection and "
-                            "broadcast/multicast\n"),
-                     verbose);
-                break;
-            default:
-                break;
-            }
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_VINES_SERVERS:
-            PRV3(printf("Vines servers : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SERVER_RANK:
-            PRV3(printf("Server rank : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_CLIENT_ARCH:
-            PRV3(printf("Client architecture : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_CLIENT_NDI:
-            PRV3(printf("Client network device interface : "),
+        while ((ret = dhcp_option_next(bp_vend, length, &offset,
+                                       &option)) == 1)
+            dhcp_option_print(&option, verbose);
+
+        if (ret == -1)
+            PRV3(output_printf("Option %d : Truncated\n", option.tag),
                  verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_CLIENT_GUID:
-            PRV3(printf("Client GUID : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_LDAP_URL:
-            PRV3(printf("LDAP URL : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_6OVER4:
-            PRV3(printf("6over4 : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_PRINTER_NAME:
-            PRV3(printf("Printer name : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_MDHCP_SERVER:
-            PRV3(printf("MDHCP server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_IPX_COMPAT:
-            PRV3(printf("IPX compatibility : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NETINFO_PARENT:
-            PRV3(printf("NetInfo parent server : "), verbose);
-            PRV3(print_dhcp_option_addr(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_NETINFO_PARENT_TAG:
-            PRV3(printf("NetInfo parent server tag : "), verbose);
-            PRV3(print_dhcp_option_int(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_URL:
-            PRV3(printf("URL : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_FAILOVER:
-            PRV3(printf("Failover : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_EXTENDED_REQUEST:
-            PRV3(printf("Extended request : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_EXTENDED_OPTION:
-            PRV3(printf("Extended option : "), verbose);
-            PRV3(print_dhcp_option_name(bp_vend, i, length), verbose);
-            i += bp_vend[i + 1] + 1;
-            break;
-        case TAG_SIP_SERVER:
-            PRV3(printf("SIP server : "), verbose);
-            for (j = 2; j <= bp_vend[i + 1]; j++) {
-                if ((j != 2 && j != bp_vend[i + 1] + 1) && j % 4 != 1)
-                    PRV3(printf("."), verbose);
-
-                PRV3(printf("%d", bp_vend[i + j + 1]), verbose);
-
-                if (j % 4 == 0 && j != bp_vend[i + 1])
-                    PRV3(printf(" "), verbose);
-            }
-            PRV3(printf("\n"), verbose);
-
-            i += bp_vend[i + 1] + 1;
-            break;
-
-        case TAG_END:
-            i = 64;
-            break;
-        default:
-            break;
-        }
-        i++;
     }
 
-    PRV2(printf("Length : %d bits\n", length), verbose);
+    PRV2(output_printf("Length : %d bytes\n", length), verbose);
+}
+
+/**
+ * @brief Print the names of the options asked by the client
+ */
+void parameter_request_list_print(const u_char *data, int len) {
+
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (dhcp_options[data[i]].name != NULL)
+            output_printf("- %s\n", dhcp_options[data[i]].name);
+        else
+            output_printf("- Option %d\n", data[i]);
+    }
+}
+
+/**
+ * @brief Print the sub-options of the relay agent information
+ */
+void dhcp_agent_print(const u_char *data, int len) {
+
+    int i = 0;
+
+    while (i + 2 <= len && i + 2 + data[i + 1] <= len) {
+        if (data[i] == DHCP_AGENT_CIRCUIT)
+            output_str("- Circuit ID : ");
+        else if (data[i] == DHCP_AGENT_REMOTE)
+            output_str("- Remote ID : ");
+        else
+            output_printf("- Sub-option %d : ", data[i]);
+        print_dhcp_option_hex(data + i + 2, data[i + 1]);
+        i += 2 + data[i + 1];
+    }
+
+    if (i != len)
+        output_str("- Truncated\n");
 }
 
-void parameter_request_list_print(const u_char *bp_vend, int start,
-                                  int verbose) {
-    int i, length = bp_vend[start + 1] + start;
-
-    for (i = start; i < length; i++) {
-        switch (bp_vend[i]) {
-        case TAG_SUBNET_MASK:
-            PRV3(printf("- Subnet mask\n"), verbose);
-            break;
-        case TAG_TIME_OFFSET:
-            PRV3(printf("- Time offset\n"), verbose);
-            break;
-        case TAG_GATEWAY:
-            PRV3(printf("- Router\n"), verbose);
-            break;
-        case TAG_TIME_SERVER:
-            PRV3(printf("- Time server\n"), verbose);
-            break;
-        case TAG_NAME_SERVER:
-            break;
-            PRV3(printf("- Name server\n"), verbose);
-        case TAG_DOMAIN_SERVER:
-            PRV3(printf("- Domain name\n"), verbose);
-            break;
-
-            // to complete ...
-        }
+/**
+ * @brief Print the protocol, the algorithm and the replay detection
+ * method of the authentication
+ */
+void dhcp_auth_print(const u_char *data) {
+
+    switch (data[0]) {
+    case 1:
+        output_str("- Protocol : Delayed authentification\n");
+        break;
+    case 2:
+        output_str("- Protocol : Reconfigure key\n");
+        break;
+    case 3:
+        output_str("- Protocol : HMAC-MD5\n");
+        break;
+    case 4:
+        output_str("- Protocol : HMAC-SHA1\n");
+        break;
+    default:
+        break;
+    }
+
+    output_str("Algorithm : ");
+    switch (data[1]) {
+    case 1:
+        output_str("HMAC-MD5\n");
+        break;
+    case 2:
+        output_str("HMAC-SHA1\n");
+        break;
+    default:
+        output_str("\n");
+        break;
+    }
+
+    output_str("RDM : ");
+    switch (data[2]) {
+    case 0:
+        output_str("Monotonically-increasing counter\n");
+        break;
+    case 1:
+        output_str("Replay detection\n");
+        break;
+    case 2:
+        output_str("Replay detection and broadcast/multicast\n");
+        break;
+    default:
+        output_str("\n");
+        break;
     }
 }
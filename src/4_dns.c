@@ -1,57 +1,193 @@
 #include "../include/4_dns.h"
 
 /**
- * @brief Print informations contained in DNS header and print
- * queries, answers and authorities which can be found in the packet
+ * @brief Print the DNS message of a UDP datagram
  */
-void dns_analyzer(const u_char *packet, int transport, int length,
-                  int verbose) {
+void dns_analyzer(const u_char *packet, int length, int verbose) {
 
     // if there is no data left of a padding empty, it is just a
-    // tcp/udp packet
+    // udp packet
     if (length < sizeof(struct dns_hdr) + 2) {
-        if (transport == DNS_TCP)
-            PRV1(printf("TCP"), verbose);
-        if (transport == DNS_UDP)
-            PRV1(printf("UDP"), verbose);
+        PRV1(output_str("UDP"), verbose);
         return;
     }
 
-    int dns_length;
+    // One line by frame
+    PRV1(output_str("DNS"), verbose);
 
-    // there is a length field in the DNS header only if the packet is
-    // under TCP
-    if (transport == DNS_TCP) {
+    dns_message(packet, DNS_UDP, length, verbose);
+}
 
-        dns_length = ntohs(*(uint16_t *)packet);
-        packet += 2;
-    }
+/**
+ * @brief Print the DNS messages of the bytes of a TCP stream. Every
+ * message comes after its length on 2 bytes, and may span several
+ * segments. Without reassembly, each segment is framed alone.
+ */
+void dns_stream(packet_t *pkt, const u_char *packet, int length,
+                int verbose) {
 
-    struct dns_hdr *dns_header = (struct dns_hdr *)packet;
+    streams_t *streams = pkt->ctx->streams;
+    stream_t *stream = stream_direction(pkt), alone;
+
+    if (length <= 0) {
+        PRV1(output_str("TCP"), verbose);
+        return;
+    }
 
     // One line by frame
-    PRV1(printf("DNS"), verbose);
+    PRV1(output_str("DNS"), verbose);
+
+    // bytes captured
+    if (length > (int)(pkt->data + pkt->caplen - packet))
+        length = pkt->data + pkt->caplen - packet;
+
+    if (stream == NULL) {
+        memset(&alone, 0, sizeof(stream_t));
+        stream = &alone;
+        streams = NULL;
+    }
+
+    // the beginning of the next message is not known anymore
+    if (stream->lost) {
+        PRV2(output_str(CYN1 "DNS" NC "\t\tBytes not framed\n"),
+             verbose);
+        PRV3(output_printf("\n" GRN "DNS Protocol" NC "\n"
+                           "Bytes not framed : %d\n",
+                           length),
+             verbose);
+        return;
+    }
+
+    if (dns_frame(pkt, streams, stream, packet, length, verbose) > 0)
+        return;
+
+    PRV2(output_printf(CYN1 "DNS" NC "\t\tMessage continued "
+                                     "(%u of %u bytes)\n",
+                       stream->framed, stream->frame_len),
+         verbose);
+    PRV3(output_printf("\n" GRN "DNS Protocol" NC "\n"
+                       "Message continued : %u of %u bytes\n",
+                       stream->framed, stream->frame_len),
+         verbose);
+}
+
+/**
+ * @brief Cut the bytes of a stream into messages. A message whole in
+ * the bytes is read in place, a message split across segments is
+ * copied until complete, in a buffer of the reassembly, or skipped if
+ * none is left.
+ * @return number of messages which ended in the bytes
+ */
+int dns_frame(packet_t *pkt, streams_t *streams, stream_t *stream,
+              const u_char *packet, int length, int verbose) {
+
+    int messages = 0;
+    uint32_t need;
+
+    while (length > 0) {
+
+        // the length may be split too
+        if (stream->framed < 2) {
+            stream->frame_len = stream->frame_len << 8 | *packet++;
+            length--;
+            if (++stream->framed == 2)
+                stream->frame_len += 2;
+            continue;
+        }
+
+        need = stream->frame_len - stream->framed;
+
+        if (stream->framed == 2 && need <= (uint32_t)length) {
+            dns_tcp_message(pkt, packet, need, verbose);
+        } else {
+            if (stream->framed == 2 && streams != NULL)
+                stream->message = pool_get(&streams->messages);
+            if (need > (uint32_t)length)
+                need = length;
+            if (stream->message != NULL)
+                memcpy(stream->message + stream->framed - 2, packet,
+                       need);
+            stream->framed += need;
+
+            if (stream->framed < stream->frame_len)
+                return messages;
+
+            if (stream->message != NULL) {
+                dns_tcp_message(pkt, stream->message,
+                                stream->frame_len - 2, verbose);
+                pool_put(&streams->messages, stream->message);
+                stream->message = NULL;
+            } else {
+                PRV3(output_printf("\n" GRN "DNS Protocol" NC "\n"
+                                   "Message not kept : %u bytes\n",
+                                   stream->frame_len - 2),
+                     verbose);
+            }
+        }
+
+        packet += need;
+        length -= need;
+        stream->framed = 0;
+        stream->frame_len = 0;
+        messages++;
+    }
+
+    return messages;
+}
+
+/**
+ * @brief Match and print a whole message of a TCP stream
+ */
+void dns_tcp_message(packet_t *pkt, const u_char *packet, int length,
+                     int verbose) {
+
+    resolver_message(pkt, packet, length);
+    dns_message(packet, DNS_TCP, length, verbose);
+}
+
+/**
+ * @brief Print informations contained in DNS header and print
+ * queries, answers and authorities which can be found in the message.
+ * The length of a message of a TCP stream is printed first.
+ */
+void dns_message(const u_char *packet, int transport, int length,
+                 int verbose) {
+
+    dns_names_t names;
+
+    if (length < (int)sizeof(struct dns_hdr)) {
+        PRV2(output_printf(CYN1 "DNS" NC "\t\tMessage of %d bytes\n",
+                           length),
+             verbose);
+        PRV3(output_printf("\n" GRN "DNS Protocol" NC "\n"
+                           "Length : %d\n",
+                           length),
+             verbose);
+        return;
+    }
+
+    struct dns_hdr *dns_header = (struct dns_hdr *)packet;
 
     // One line from the dns packet
-    PRV2(printf(CYN1 "DNS" NC "\t\t"), verbose);
+    PRV2(output_str(CYN1 "DNS" NC "\t\t"), verbose);
 
     // Multiple lines from the dns packet
-    PRV3(printf("\n" GRN "DNS Protocol" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "DNS Protocol" NC "\n"), verbose);
 
     if (transport == DNS_TCP)
-        PRV3(printf("Length : %d\n", dns_length), verbose);
+        PRV3(output_printf("Length : %d\n", length), verbose);
 
-    PRV3(printf("Transaction ID : 0x%0x\n"
-                "Flags : 0x%0x",
-                ntohs(dns_header->id), ntohs(dns_header->flags)),
+    PRV3(output_printf("Transaction ID : 0x%0x\n"
+                       "Flags : 0x%0x",
+                       ntohs(dns_header->id), ntohs(dns_header->flags)),
          verbose);
 
-    if (ntohs(dns_header->flags) & 0x8000) {
-        PRV2(printf("Standard query response "), verbose);
-        PRV3(printf(" (Response)\n"), verbose);
+    if (ntohs(dns_header->flags) & DNS_RESPONSE) {
+        PRV2(output_str("Standard query response "), verbose);
+        PRV3(output_str(" (Response)\n"), verbose);
     } else {
-        PRV2(printf("Standard query "), verbose);
-        PRV3(printf(" (Query)\n"), verbose);
+        PRV2(output_str("Standard query "), verbose);
+        PRV3(output_str(" (Query)\n"), verbose);
     }
 
     int qdcount = ntohs(dns_header->qdcount),
@@ -59,59 +195,70 @@ void dns_analyzer(const u_char *packet, int transport, int length,
         nscount = ntohs(dns_header->nscount),
         arcount = ntohs(dns_header->arcount);
 
-    PRV2(printf(
+    PRV2(output_printf(
              "(Questions : %d, Answer RRs : %d, Authority RRs : %d, "
              "Additional RRs : %d)\n",
              qdcount, ancount, nscount, arcount),
          verbose);
 
-    PRV3(printf("Questions : %d\n"
-                "Answer RRs : %d\n"
-                "Authority RRs : %d\n"
-                "Additional RRs : %d\n",
-                qdcount, ancount, nscount, arcount),
+    PRV3(output_printf("Questions : %d\n"
+                       "Answer RRs : %d\n"
+                       "Authority RRs : %d\n"
+                       "Additional RRs : %d\n",
+                       qdcount, ancount, nscount, arcount),
          verbose);
 
+    // the records are only walked to print them
+    if (verbose < 3)
+        return;
+
     int i, offset = sizeof(struct dns_hdr);
 
-    for (i = 0; i < qdcount; i++) {
+    dns_names_init(&names, packet, length);
+
+    for (i = 0; i < qdcount && offset != -1; i++) {
 
-        PRV3(printf(CYN1 "Query %d" NC "\n", i + 1), verbose);
-        offset = query_parsing(packet, offset, length, verbose);
+        PRV3(output_printf(CYN1 "Query %d" NC "\n", i + 1), verbose);
+        offset = query_parsing(&names, offset, verbose);
     }
 
-    for (i = 0; i < ancount; i++) {
+    for (i = 0; i < ancount && offset != -1; i++) {
 
-        PRV3(printf(CYN1 "Answer %d" NC "\n", i + 1), verbose);
-        offset = response_parsing(packet, offset, length, verbose);
+        PRV3(output_printf(CYN1 "Answer %d" NC "\n", i + 1), verbose);
+        offset = response_parsing(&names, offset, verbose);
     }
 
-    for (i = 0; i < nscount; i++) {
+    for (i = 0; i < nscount && offset != -1; i++) {
 
-        PRV3(printf(CYN1 "Authority %d" NC "\n", i + 1), verbose);
-        offset = response_parsing(packet, offset, length, verbose);
+        PRV3(output_printf(CYN1 "Authority %d" NC "\n", i + 1),
+             verbose);
+        offset = response_parsing(&names, offset, verbose);
     }
 
-    for (i = 0; i < arcount; i++) {
+    for (i = 0; i < arcount && offset != -1; i++) {
 
-        PRV3(printf(CYN1 "Additional %d" NC "\n", i + 1), verbose);
-        offset = response_parsing(packet, offset, length, verbose);
+        PRV3(output_printf(CYN1 "Additional %d" NC "\n", i + 1),
+             verbose);
+        offset = response_parsing(&names, offset, verbose);
     }
 }
 
 /**
  * @brief Print informations contained in DNS query and return the new
  * offset after reading the query
- * @return int
+ * @return the offset of the next record, -1 if the query is truncated
  */
-int query_parsing(const u_char *packet, int offset, int length,
-                  int verbose) {
+int query_parsing(dns_names_t *names, int offset, int verbose) {
+
+    const u_char *packet = names->packet;
 
-    if (offset + 4 >= length)
-        return offset;
+    if (offset + 4 >= names->length)
+        return -1;
 
-    PRV3(printf("- Name : "), verbose);
-    offset = domain_name_print(packet, offset, length, verbose);
+    PRV3(output_str("- Name : "), verbose);
+    offset = domain_name_print(names, offset, verbose);
+    if (offset == -1 || offset + 4 > names->length)
+        return -1;
 
     uint16_t type = ntohs(*(uint16_t *)(packet + offset));
     type_print(type, verbose);
@@ -125,16 +272,20 @@ int query_parsing(const u_char *packet, int offset, int length,
 /**
  * @brief Print informations contained in DNS answer / authority /
  * additional and return the new offset after reading the answer
- * @return int
+ * @return the offset of the next record, -1 if the record is
+ * truncated
  */
-int response_parsing(const u_char *packet, int offset, int length,
-                     int verbose) {
+int response_parsing(dns_names_t *names, int offset, int verbose) {
+
+    const u_char *packet = names->packet;
 
-    if (offset + 10 >= length)
-        return offset;
+    if (offset + 10 >= names->length)
+        return -1;
 
-    PRV3(printf("- Name : "), verbose);
-    offset = domain_name_print(packet, offset, length, verbose);
+    PRV3(output_str("- Name : "), verbose);
+    offset = domain_name_print(names, offset, verbose);
+    if (offset == -1 || offset + 10 > names->length)
+        return -1;
 
     uint16_t type = ntohs(*(uint16_t *)(packet + offset));
     type_print(type, verbose);
@@ -143,116 +294,128 @@ int response_parsing(const u_char *packet, int offset, int length,
     class_print(class, verbose);
 
     uint32_t ttl = ntohl(*(uint32_t *)(packet + offset + 4));
-    PRV3(printf("- TTL : %d\n", ttl), verbose);
+    PRV3(output_printf("- TTL : %d\n", ttl), verbose);
 
     uint16_t rdlength = ntohs(*(uint16_t *)(packet + offset + 8));
-    PRV3(printf("- RD Length : %d\n", rdlength), verbose);
+    PRV3(output_printf("- RD Length : %d\n", rdlength), verbose);
 
-    data_reader(type, packet, offset + 10, offset + 10 + rdlength,
-                length, verbose);
+    offset += 10 + rdlength;
+    if (offset > names->length) {
+        data_reader(names, type, offset - rdlength, names->length,
+                    verbose);
+        return -1;
+    }
 
-    return offset + 10 + rdlength;
+    data_reader(names, type, offset - rdlength, offset, verbose);
+
+    return offset;
 }
 
 /**
  * @brief Print data blocks contained in answers or authorities. Data
  * blocks is differentiated by answer and authority type, and print
- * informations in function of this type
+ * informations in function of this type. The data ends at end, the
+ * names it holds may point anywhere before.
  */
-void data_reader(uint16_t type, const u_char *packet, int i,
-                 uint16_t rdlength, int length, int verbose) {
+void data_reader(dns_names_t *names, uint16_t type, int i, int end,
+                 int verbose) {
 
+    const u_char *packet = names->packet;
     int j;
 
     switch (type) {
 
     case 1:
-        PRV3(printf("- IPv4 Address : "), verbose);
-        if (i + 4 > length)
+        PRV3(output_str("- IPv4 Address : "), verbose);
+        if (i + 4 > end)
             return;
         for (j = 0; j < 4; j++) {
-            PRV3(printf("%d", packet[i + j]), verbose);
+            PRV3(output_printf("%d", packet[i + j]), verbose);
             if (j != 3)
-                PRV3(printf("."), verbose);
+                PRV3(output_str("."), verbose);
         }
-        PRV3(printf("\n"), verbose);
+        PRV3(output_str("\n"), verbose);
         break;
 
     case 2:
-        PRV3(printf("- Name Server : "), verbose);
-        domain_name_print(packet, i, length, verbose);
+        PRV3(output_str("- Name Server : "), verbose);
+        domain_name_print(names, i, verbose);
         break;
 
     case 5:
-        PRV3(printf("- Canonical Name : "), verbose);
-        domain_name_print(packet, i, length, verbose);
+        PRV3(output_str("- Canonical Name : "), verbose);
+        domain_name_print(names, i, verbose);
         break;
 
     case 6:
-        PRV3(printf("- Primary Name Server : "), verbose);
-        i = name_print(packet, i, length, verbose);
+        PRV3(output_str("- Primary Name Server : "), verbose);
+        if ((i = domain_name_print(names, i, verbose)) == -1)
+            return;
 
-        PRV3(printf("- Responsible Authority's Mailbox : "), verbose);
-        i = name_print(packet, i, length, verbose);
+        PRV3(output_str("- Responsible Authority's Mailbox : "),
+             verbose);
+        if ((i = domain_name_print(names, i, verbose)) == -1)
+            return;
 
-        if (i + 20 > length)
+        if (i + 20 > end)
             return;
 
         uint32_t serial_nb = ntohl(*(uint32_t *)(packet + i));
-        PRV3(printf("- Serial Number : %d\n", serial_nb), verbose);
+        PRV3(output_printf("- Serial Number : %d\n", serial_nb),
+             verbose);
 
         uint32_t refresh = ntohl(*(uint32_t *)(packet + i + 4));
-        PRV3(printf("- Refresh : %d\n", refresh), verbose);
+        PRV3(output_printf("- Refresh : %d\n", refresh), verbose);
 
         uint32_t retry = ntohl(*(uint32_t *)(packet + i + 8));
-        PRV3(printf("- Retry : %d\n", retry), verbose);
+        PRV3(output_printf("- Retry : %d\n", retry), verbose);
 
         uint32_t expire = ntohl(*(uint32_t *)(packet + i + 12));
-        PRV3(printf("- Expire : %d\n", expire), verbose);
+        PRV3(output_printf("- Expire : %d\n", expire), verbose);
 
         uint32_t minimum = ntohl(*(uint32_t *)(packet + i + 16));
-        PRV3(printf("- Minimum : %d\n", minimum), verbose);
+        PRV3(output_printf("- Minimum : %d\n", minimum), verbose);
         break;
 
     case 12:
-        PRV3(printf("- Pointer : "), verbose);
-        domain_name_print(packet, i, length, verbose);
+        PRV3(output_str("- Pointer : "), verbose);
+        domain_name_print(names, i, verbose);
         break;
 
     case 15:
-        PRV3(printf("- Mail Exchange : "), verbose);
+        PRV3(output_str("- Mail Exchange : "), verbose);
 
-        if (i + 2 > length)
+        if (i + 2 > end)
             return;
 
-        domain_name_print(packet, i + 2, length, verbose);
+        domain_name_print(names, i + 2, verbose);
         break;
 
     case 16:
-        PRV3(printf("- Text : "), verbose);
+        PRV3(output_str("- Text : "), verbose);
 
-        if (i + 1 + packet[i] > length)
+        if (i >= end || i + 1 + packet[i] > end)
             return;
 
         for (j = 0; j < packet[i]; j++) {
-            PRV3(printf("%c", packet[i + j + 1]), verbose);
+            PRV3(output_printf("%c", packet[i + j + 1]), verbose);
         }
-        PRV3(printf("\n"), verbose);
+        PRV3(output_str("\n"), verbose);
         break;
 
     case 28:
-        PRV3(printf("- IPv6 Address : "), verbose);
+        PRV3(output_str("- IPv6 Address : "), verbose);
 
-        if (i + 16 > length)
+        if (i + 16 > end)
             return;
 
         for (j = 0; j < 16; j++) {
-            PRV3(printf("%x", packet[i + j]), verbose);
+            PRV3(output_printf("%x", packet[i + j]), verbose);
             if (j != 15) {
-                PRV3(printf(":"), verbose);
+                PRV3(output_str(":"), verbose);
             }
         }
-        PRV3(printf("\n"), verbose);
+        PRV3(output_str("\n"), verbose);
         break;
 
     default:
@@ -261,75 +424,174 @@ void data_reader(uint16_t type, const u_char *packet, int i,
 }
 
 /**
- * @brief Print domain name contained in queries, answers and
- * authorities
+ * @brief Start the names of a message, the memo is cleared by the
+ * first name decoded
  */
-int domain_name_print(const u_char *packet, int i, int length,
-                      int verbose) {
+void dns_names_init(dns_names_t *names, const u_char *packet,
+                    int length) {
 
-    int j, start = i;
-    while (i <= length && packet[i] != 0) {
+    names->packet = packet;
+    names->length = length;
+    names->used = DNS_ARENA;
+}
 
-        if (packet[i] == 0xc0) {
-            if (i != start)
-                PRV3(printf("."), verbose);
-            domain_name_print(packet, packet[i + 1], length, verbose);
-            return i + 2;
-        }
+/**
+ * @brief Name already decoded from an offset
+ * @return its entry of the memo, NULL if it was not decoded or if an
+ * other offset took its place
+ */
+const dns_memo_t *dns_memo_find(const dns_names_t *names,
+                                int offset) {
 
-        // "c1" represent a position in the packet for additional
-        // response
-        if (packet[i] == 0xc1) {
-            int nameserver = packet[i + 1] / 18;
-            PRV3(printf("Authority name server n°%d\n",
-                        nameserver + 2),
-                 verbose);
-            return i + 2;
-        }
+    const dns_memo_t *memo = &names->memo[offset & (DNS_MEMO - 1)];
 
-        if (packet[i] != 0 && i != start)
-            PRV3(printf("."), verbose);
+    if (memo->offset != offset || memo->length == 0)
+        return NULL;
 
-        for (j = 0; j < packet[i]; j++)
-            PRV3(printf("%c", packet[i + j + 1]), verbose);
+    return memo;
+}
 
-        i += packet[i] + 1;
+/**
+ * @brief Walk over a name without decoding it, a pointer ends it
+ * @return the offset after the name, -1 if it is truncated
+ */
+int dns_name_skip(const dns_names_t *names, int offset) {
+
+    int size;
+
+    while (offset < names->length) {
+
+        size = names->packet[offset];
+        if (size == 0)
+            return offset + 1;
+        if ((size & DNS_POINTER) == DNS_POINTER)
+            return offset + 2 <= names->length ? offset + 2 : -1;
+        if (size & DNS_POINTER)
+            return -1;
+
+        offset += size + 1;
     }
 
-    PRV3(printf("\n"), verbose);
-    return i + 1;
+    return -1;
 }
 
 /**
- * @brief Print name contained in SOA records
+ * @brief Decode the name at an offset of the message into the arena,
+ * without recursion. A pointer must go before the labels already
+ * walked, which ends every loop, and the name stops at the first
+ * offset already decoded. Every label walked is then remembered with
+ * the end of the name starting there.
+ * @return the offset after the name in the record, -1 if the name is
+ * truncated, too long or loops. name is valid until the next call.
  */
-int name_print(const u_char *packet, int i, int length, int verbose) {
+int dns_name(dns_names_t *names, int offset, const char **name) {
+
+    const u_char *packet = names->packet;
+    const dns_memo_t *memo = NULL;
+    int labels[DNS_LABELS], starts[DNS_LABELS];
+    int nb = 0, len = 0, end = -1, limit = offset, size, k;
+    dns_memo_t *entry;
+    char *out;
+
+    // room for the longest name, the arena starts over when full
+    if (names->used + DNS_NAME_MAX + 1 > DNS_ARENA) {
+        names->used = 0;
+        memset(names->memo, 0, sizeof(names->memo));
+    }
+    out = names->arena + names->used;
+
+    while (offset < names->length) {
+
+        size = packet[offset];
+        if (size == 0)
+            break;
+
+        if ((size & DNS_POINTER) == DNS_POINTER) {
+            if (offset + 2 > names->length)
+                return -1;
+            if (end == -1)
+                end = offset + 2;
+            offset = (size & ~DNS_POINTER) << 8 | packet[offset + 1];
+            if (offset >= limit)
+                return -1;
+            limit = offset;
+            if ((memo = dns_memo_find(names, offset)) != NULL)
+                break;
+            continue;
+        }
+
+        // extended label types are not used
+        if ((size & DNS_POINTER) != 0 ||
+            offset + 1 + size > names->length ||
+            len + (len > 0) + size > DNS_NAME_MAX)
+            return -1;
+
+        if (len > 0)
+            out[len++] = '.';
+        labels[nb] = offset;
+        starts[nb++] = len;
+
+        for (k = 0; k < size; k++) {
+            out[len] = packet[offset + 1 + k];
+            if (!isprint((u_char)out[len]))
+                out[len] = '?';
+            len++;
+        }
+
+        offset += size + 1;
+    }
 
-    int j, position;
+    if (offset >= names->length)
+        return -1;
+
+    if (memo != NULL) {
+        if (len + (len > 0) + memo->length > DNS_NAME_MAX)
+            return -1;
+        if (len > 0)
+            out[len++] = '.';
+        memcpy(out + len, names->arena + memo->name, memo->length);
+        len += memo->length;
+    } else if (end == -1) {
+        end = offset + 1;
+    }
+    out[len] = '\0';
+
+    // a pointer to one of the labels now copies the end of the name
+    for (k = 0; k < nb; k++) {
+        entry = &names->memo[labels[k] & (DNS_MEMO - 1)];
+        entry->offset = labels[k];
+        entry->name = names->used + starts[k];
+        entry->length = len - starts[k];
+    }
 
-    if (packet[i] == 0xc0)
-        j = packet[i + 1];
-    else
-        j = i;
+    *name = out;
+    names->used += len + 1;
 
-    position = j;
-    while (j < packet[position] + position && j < length) {
-        j++;
+    return end;
+}
 
-        if (packet[j] == 0xc0) {
-            name_print(packet, j, length, verbose);
-            j += 2;
-        }
+/**
+ * @brief Print domain name contained in queries, answers and
+ * authorities
+ * @return the offset after the name, -1 if it is truncated
+ */
+int domain_name_print(dns_names_t *names, int offset, int verbose) {
+
+    const char *name;
+    int end;
+
+    if (verbose < 3)
+        return dns_name_skip(names, offset);
 
-        PRV3(printf("%c", packet[j]), verbose);
+    // the record may still be walked past a name it cannot decode
+    if ((end = dns_name(names, offset, &name)) == -1) {
+        PRV3(output_str("Malformed\n"), verbose);
+        return dns_name_skip(names, offset);
     }
 
-    PRV3(printf("\n"), verbose);
+    PRV3(output_printf("%s\n", name), verbose);
 
-    if (packet[i] == 0xc0)
-        return i + 2;
-    else
-        return i + packet[i] + 2;
+    return end;
 }
 
 /**
@@ -337,41 +599,43 @@ int name_print(const u_char *packet, int i, int length, int verbose) {
  */
 void type_print(u_int16_t type, int verbose) {
 
-    PRV3(printf("- Type : "), verbose);
+    PRV3(output_str("- Type : "), verbose);
 
     switch (type) {
     case 1:
-        PRV3(printf("A (Host Address)\n"), verbose);
+        PRV3(output_str("A (Host Address)\n"), verbose);
         break;
     case 2:
-        PRV3(printf("NS (Authoritative Name Server)\n"), verbose);
+        PRV3(output_str("NS (Authoritative Name Server)\n"),
+             verbose);
         break;
     case 5:
-        PRV3(printf("CNAME (Canonical Name)\n"), verbose);
+        PRV3(output_str("CNAME (Canonical Name)\n"), verbose);
         break;
     case 6:
-        PRV3(printf("SOA (Start of Authority)\n"), verbose);
+        PRV3(output_str("SOA (Start of Authority)\n"), verbose);
         break;
     case 12:
-        PRV3(printf("PTR (Domain Name Pointer)\n"), verbose);
+        PRV3(output_str("PTR (Domain Name Pointer)\n"), verbose);
         break;
     case 15:
-        PRV3(printf("MX (Mail Exchange)\n"), verbose);
+        PRV3(output_str("MX (Mail Exchange)\n"), verbose);
         break;
     case 16:
-        PRV3(printf("TXT (Text Strings)\n"), verbose);
+        PRV3(output_str("TXT (Text Strings)\n"), verbose);
         break;
     case 28:
-        PRV3(printf("AAAA (IPv6 Address)\n"), verbose);
+        PRV3(output_str("AAAA (IPv6 Address)\n"), verbose);
         break;
     case 251:
-        PRV3(printf("IXFR (Incremental Zone Transfer)\n"), verbose);
+        PRV3(output_str("IXFR (Incremental Zone Transfer)\n"),
+             verbose);
         break;
     case 252:
-        PRV3(printf("AXFR (Zone Transfer)\n"), verbose);
+        PRV3(output_str("AXFR (Zone Transfer)\n"), verbose);
         break;
     default:
-        PRV3(printf("Unknown\n"), verbose);
+        PRV3(output_str("Unknown\n"), verbose);
         break;
     }
 }
@@ -381,23 +645,23 @@ void type_print(u_int16_t type, int verbose) {
  */
 void class_print(u_int16_t class, int verbose) {
 
-    PRV3(printf("- Class : "), verbose);
+    PRV3(output_str("- Class : "), verbose);
 
     switch (class) {
     case 1:
-        PRV3(printf("IN (Internet)\n"), verbose);
+        PRV3(output_str("IN (Internet)\n"), verbose);
         break;
     case 2:
-        PRV3(printf("CS (CSNET)\n"), verbose);
+        PRV3(output_str("CS (CSNET)\n"), verbose);
         break;
     case 3:
-        PRV3(printf("CH (Chaos)\n"), verbose);
+        PRV3(output_str("CH (Chaos)\n"), verbose);
         break;
     case 4:
-        PRV3(printf("HS (Hesiod)\n"), verbose);
+        PRV3(output_str("HS (Hesiod)\n"), verbose);
         break;
     default:
-        PRV3(printf("Unknown\n"), verbose);
+        PRV3(output_str("Unknown\n"), verbose);
         break;
     }
 }
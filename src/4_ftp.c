@@ -8,37 +8,39 @@ int ftp_analyzer(const u_char *packet, int length, int verbose) {
     // if there is no data left of a padding empty, it is just a
     // tcp/udp packet
     if (length < 1 || packet[0] == 0) {
-        PRV1(printf("TCP"), verbose);
+        PRV1(output_str("TCP"), verbose);
         return 0;
     }
 
     // One line by frame
-    PRV1(printf("FTP"), verbose);
+    PRV1(output_str("FTP"), verbose);
 
     // One line from the ftp packet
-    PRV2(printf(CYN1 "FTP" NC "\t\t"
-                     "Length : %d bits\n",
-                length),
+    PRV2(output_printf(CYN1 "FTP" NC "\t\t"
+                            "Length : %d bits\n",
+                       length),
          verbose);
 
     // Multiple lines from the ftp packet
-    PRV3(printf("\n" GRN "FTP" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "FTP" NC "\n"), verbose);
 
-    int i;
-    for (i = 0; i < length; i++) {
-        if (i % BANNER_LENGTH == 0 && i != 0)
-            PRV3(printf("\n"), verbose);
+    PRV3(output_dump(packet, length, BANNER_LENGTH), verbose);
+    PRV3(output_str("\n"), verbose);
 
-        if (isprint(packet[i]))
-            PRV3(printf("%c", packet[i]), verbose);
-        else
-            PRV3(printf("."), verbose);
-    }
+    // if a new port is established, it is returned
+    return ftp_data_port(packet, length);
+}
 
-    PRV3(printf("\n"), verbose);
+/**
+ * @brief Find the port of the data connection announced by a reply,
+ * without printing anything
+ * @return the port, 0 if the reply does not announce one
+ */
+int ftp_data_port(const u_char *packet, int length) {
 
     char port_ftp[6];
-    int j = 0;
+    int i, j = 0;
+
     // if the message begins by "150 Data connection ..." there is
     // a new port for the data connection
     if (length > 40 && packet[0] == '1' && packet[1] == '5' &&
@@ -52,7 +54,7 @@ int ftp_analyzer(const u_char *packet, int length, int verbose) {
 
         // get back to the port
         i++;
-        while (i < length && packet[i] != ';') {
+        while (i < length && packet[i] != ';' && j < 5) {
             port_ftp[j] = packet[i];
             i++;
             j++;
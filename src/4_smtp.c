@@ -8,17 +8,17 @@ void smtp_analyzer(const u_char *packet, int length, int verbose) {
     // if there is no data left of a padding empty, it is just a
     // tcp/udp packet
     if (length < 1 || packet[0] == 0) {
-        PRV1(printf("TCP"), verbose);
+        PRV1(output_str("TCP"), verbose);
         return;
     }
 
     // One line by frame
-    PRV1(printf("SMTP"), verbose);
+    PRV1(output_str("SMTP"), verbose);
 
     // One line from the smtp packet
-    PRV2(printf(CYN1 "SMTP" NC "\t\t"
-                     "Length : %d bits",
-                length),
+    PRV2(output_printf(CYN1 "SMTP" NC "\t\t"
+                            "Length : %d bits",
+                       length),
          verbose);
 
     // get the code of the request
@@ -31,21 +31,21 @@ void smtp_analyzer(const u_char *packet, int length, int verbose) {
         if (code < 0 || code > 999) {
             if ((packet[0] == 0x0d && packet[1] == 0x0a) ||
                 packet[0] == '\n') {
-                PRV2(printf(", Response : "), verbose);
+                PRV2(output_str(", Response : "), verbose);
                 for (i = 0; i < length; i++)
-                    PRV2(printf("%c", packet[i]), verbose);
+                    PRV2(output_char(packet[i]), verbose);
             }
-            PRV2(printf("\n"), verbose);
+            PRV2(output_str("\n"), verbose);
         } else
-            PRV2(printf(", Code : %d\n", code), verbose);
+            PRV2(output_printf(", Code : %d\n", code), verbose);
     } else
-        PRV2(printf("\n"), verbose);
+        PRV2(output_str("\n"), verbose);
 
     // Multiple lines from the smtp packet
-    PRV3(printf("\n" GRN "SMTP protocol" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "SMTP protocol" NC "\n"), verbose);
 
     if (packet[0] == '\r' || packet[0] == '\n') {
-        PRV3(printf("\\r\\n\n"), verbose);
+        PRV3(output_str("\\r\\n\n"), verbose);
         return;
     }
 
@@ -53,20 +53,20 @@ void smtp_analyzer(const u_char *packet, int length, int verbose) {
     while (i < length) {
 
         if (j % BANNER_LENGTH == 0 && j != 0)
-            PRV3(printf("\n"), verbose);
+            PRV3(output_str("\n"), verbose);
 
         if (i != length && packet[i] == 0x0d &&
             packet[i + 1] == 0x0a) {
             i += 2;
             j = 0;
-            PRV3(printf("\n"), verbose);
+            PRV3(output_str("\n"), verbose);
         }
 
         if (i < length && isprint(packet[i]))
-            PRV3(printf("%c", packet[i]), verbose);
+            PRV3(output_char(packet[i]), verbose);
         else {
             if (i < length - 1)
-                PRV3(printf("."), verbose);
+                PRV3(output_char('.'), verbose);
         }
 
         i++;
@@ -8,24 +8,24 @@ void telnet_analyzer(const u_char *packet, int length, int verbose) {
     // if there is no data left of a padding empty, it is just a
     // tcp/udp packet
     if (length < 1 || packet[0] == 0) {
-        PRV1(printf("TCP"), verbose);
+        PRV1(output_str("TCP"), verbose);
         return;
     }
 
     // One line by frame
-    PRV1(printf("Telnet"), verbose);
+    PRV1(output_str("Telnet"), verbose);
 
     // One line from the telnet packet
-    PRV2(printf(CYN1 "Telnet" NC "\t\t"
-                     "Length : %d bits\n",
-                length),
+    PRV2(output_printf(CYN1 "Telnet" NC "\t\t"
+                            "Length : %d bits\n",
+                       length),
          verbose);
 
     // Multiple lines from the telnet packet
-    PRV3(printf("\n" GRN "Telnet" NC "\n"), verbose);
+    PRV3(output_str("\n" GRN "Telnet" NC "\n"), verbose);
 
     if (packet[0] == '\r' || packet[0] == '\n') {
-        PRV3(printf("\\r\\n\n"), verbose);
+        PRV3(output_str("\\r\\n\n"), verbose);
         return;
     }
 
@@ -35,10 +35,10 @@ void telnet_analyzer(const u_char *packet, int length, int verbose) {
 
         if (i != length - 2 && packet[i] == IAC &&
             packet[i + 1] != SE) {
-            PRV3(printf("- "), verbose);
+            PRV3(output_str("- "), verbose);
             telnet_cmd(packet[i + 1], verbose);
             telnet_opt(packet[i + 2], verbose);
-            PRV3(printf("\n"), verbose);
+            PRV3(output_str("\n"), verbose);
             opt = 1;
         }
 
@@ -47,19 +47,8 @@ void telnet_analyzer(const u_char *packet, int length, int verbose) {
 
     // if there is no telnet option, print the frame's content
     if (opt == 0) {
-        i = 0;
-        while (i < length) {
-            if (i % BANNER_LENGTH == 0 && i != 0)
-                PRV3(printf("\n"), verbose);
-
-            if (isprint(packet[i]))
-                PRV3(printf("%c", packet[i]), verbose);
-            else
-                PRV3(printf("."), verbose);
-            i++;
-        }
-
-        PRV3(printf("\n"), verbose);
+        PRV3(output_dump(packet, length, BANNER_LENGTH), verbose);
+        PRV3(output_str("\n"), verbose);
     }
 }
 
@@ -70,49 +59,49 @@ void telnet_cmd(const u_char cmd, int verbose) {
 
     switch (cmd) {
     case NOP:
-        PRV3(printf("NOP"), verbose);
+        PRV3(output_str("NOP"), verbose);
         break;
     case DM:
-        PRV3(printf("DM"), verbose);
+        PRV3(output_str("DM"), verbose);
         break;
     case BRK:
-        PRV3(printf("BRK"), verbose);
+        PRV3(output_str("BRK"), verbose);
         break;
     case IPRO:
-        PRV3(printf("IP"), verbose);
+        PRV3(output_str("IP"), verbose);
         break;
     case AO:
-        PRV3(printf("AO"), verbose);
+        PRV3(output_str("AO"), verbose);
         break;
     case AYT:
-        PRV3(printf("AYT"), verbose);
+        PRV3(output_str("AYT"), verbose);
         break;
     case EC:
-        PRV3(printf("EC"), verbose);
+        PRV3(output_str("EC"), verbose);
         break;
     case EL:
-        PRV3(printf("EL"), verbose);
+        PRV3(output_str("EL"), verbose);
         break;
     case GA:
-        PRV3(printf("GA"), verbose);
+        PRV3(output_str("GA"), verbose);
         break;
     case SB:
-        PRV3(printf("SB"), verbose);
+        PRV3(output_str("SB"), verbose);
         break;
     case WILL:
-        PRV3(printf("WILL"), verbose);
+        PRV3(output_str("WILL"), verbose);
         break;
     case WONT:
-        PRV3(printf("WONT"), verbose);
+        PRV3(output_str("WONT"), verbose);
         break;
     case DO:
-        PRV3(printf("DO"), verbose);
+        PRV3(output_str("DO"), verbose);
         break;
     case DONT:
-        PRV3(printf("DONT"), verbose);
+        PRV3(output_str("DONT"), verbose);
         break;
     case IAC:
-        PRV3(printf("IAC"), verbose);
+        PRV3(output_str("IAC"), verbose);
         break;
     }
 }
@@ -124,166 +113,170 @@ void telnet_opt(const u_char opt, int verbose) {
 
     switch (opt) {
     case 0x00:
-        PRV3(printf(" Binary"), verbose);
+        PRV3(output_str(" Binary"), verbose);
         break;
     case 0x01:
-        PRV3(printf(" Echo"), verbose);
+        PRV3(output_str(" Echo"), verbose);
         break;
     case 0x02:
-        PRV3(printf(" Reconnection"), verbose);
+        PRV3(output_str(" Reconnection"), verbose);
         break;
     case 0x03:
-        PRV3(printf(" Suppress Go Ahead"), verbose);
+        PRV3(output_str(" Suppress Go Ahead"), verbose);
         break;
     case 0x04:
-        PRV3(printf(" Approx Message Size Negotiation"), verbose);
+        PRV3(output_str(" Approx Message Size Negotiation"),
+             verbose);
         break;
     case 0x05:
-        PRV3(printf(" Status"), verbose);
+        PRV3(output_str(" Status"), verbose);
         break;
     case 0x06:
-        PRV3(printf(" Timing Mark"), verbose);
+        PRV3(output_str(" Timing Mark"), verbose);
         break;
     case 0x07:
-        PRV3(printf(" Remote Controlled"), verbose);
+        PRV3(output_str(" Remote Controlled"), verbose);
         break;
     case 0x08:
-        PRV3(printf(" Output Line Width"), verbose);
+        PRV3(output_str(" Output Line Width"), verbose);
         break;
     case 0x09:
-        PRV3(printf(" Output Page Size"), verbose);
+        PRV3(output_str(" Output Page Size"), verbose);
         break;
     case 0x0a:
-        PRV3(printf(" Output Carriage-Return Disposition"), verbose);
+        PRV3(output_str(" Output Carriage-Return Disposition"),
+             verbose);
         break;
     case 0x0b:
-        PRV3(printf(" Output Horizontal Tab Stops"), verbose);
+        PRV3(output_str(" Output Horizontal Tab Stops"), verbose);
         break;
     case 0x0c:
-        PRV3(printf(" Output Horizontal Tab Disposition"), verbose);
+        PRV3(output_str(" Output Horizontal Tab Disposition"),
+             verbose);
         break;
     case 0x0d:
-        PRV3(printf(" Output Formfeed Disposition"), verbose);
+        PRV3(output_str(" Output Formfeed Disposition"), verbose);
         break;
     case 0x0e:
-        PRV3(printf(" Output Vertical Tabstops"), verbose);
+        PRV3(output_str(" Output Vertical Tabstops"), verbose);
         break;
     case 0x0f:
-        PRV3(printf(" Output Vertical Tab Disposition"), verbose);
+        PRV3(output_str(" Output Vertical Tab Disposition"),
+             verbose);
         break;
     case 0x10:
-        PRV3(printf(" Output Linefeed Disposition"), verbose);
+        PRV3(output_str(" Output Linefeed Disposition"), verbose);
         break;
     case 0x11:
-        PRV3(printf(" Extended ASCII"), verbose);
+        PRV3(output_str(" Extended ASCII"), verbose);
         break;
     case 0x12:
-        PRV3(printf(" Logout"), verbose);
+        PRV3(output_str(" Logout"), verbose);
         break;
     case 0x13:
-        PRV3(printf(" Byte Macro"), verbose);
+        PRV3(output_str(" Byte Macro"), verbose);
         break;
     case 0x14:
-        PRV3(printf(" Data Entry Terminal"), verbose);
+        PRV3(output_str(" Data Entry Terminal"), verbose);
         break;
     case 0x15:
-        PRV3(printf(" SUPDUP"), verbose);
+        PRV3(output_str(" SUPDUP"), verbose);
         break;
     case 0x16:
-        PRV3(printf(" SUPDUP Output"), verbose);
+        PRV3(output_str(" SUPDUP Output"), verbose);
         break;
     case 0x17:
-        PRV3(printf(" Send Location"), verbose);
+        PRV3(output_str(" Send Location"), verbose);
         break;
     case 0x18:
-        PRV3(printf(" Terminal Type"), verbose);
+        PRV3(output_str(" Terminal Type"), verbose);
         break;
     case 0x19:
-        PRV3(printf(" End of Record"), verbose);
+        PRV3(output_str(" End of Record"), verbose);
         break;
     case 0x1a:
-        PRV3(printf(" TACACS User Identification"), verbose);
+        PRV3(output_str(" TACACS User Identification"), verbose);
         break;
     case 0x1b:
-        PRV3(printf(" Output Marking"), verbose);
+        PRV3(output_str(" Output Marking"), verbose);
         break;
     case 0x1c:
-        PRV3(printf(" Terminal Location Number"), verbose);
+        PRV3(output_str(" Terminal Location Number"), verbose);
         break;
     case 0x1d:
-        PRV3(printf(" Telnet 3270 Regime"), verbose);
+        PRV3(output_str(" Telnet 3270 Regime"), verbose);
         break;
     case 0x1e:
-        PRV3(printf(" X.3 PAD"), verbose);
+        PRV3(output_str(" X.3 PAD"), verbose);
         break;
     case 0x1f:
-        PRV3(printf(" Negotiate About Window Size"), verbose);
+        PRV3(output_str(" Negotiate About Window Size"), verbose);
         break;
     case 0x20:
-        PRV3(printf(" Terminal Speed"), verbose);
+        PRV3(output_str(" Terminal Speed"), verbose);
         break;
     case 0x21:
-        PRV3(printf(" Remote Flow Control"), verbose);
+        PRV3(output_str(" Remote Flow Control"), verbose);
         break;
     case 0x22:
-        PRV3(printf(" Linemode"), verbose);
+        PRV3(output_str(" Linemode"), verbose);
         break;
     case 0x23:
-        PRV3(printf(" X Display Location"), verbose);
+        PRV3(output_str(" X Display Location"), verbose);
         break;
     case 0x24:
-        PRV3(printf(" Environment Option"), verbose);
+        PRV3(output_str(" Environment Option"), verbose);
         break;
     case 0x25:
-        PRV3(printf(" Authentication Option"), verbose);
+        PRV3(output_str(" Authentication Option"), verbose);
         break;
     case 0x26:
-        PRV3(printf(" Encryption Option"), verbose);
+        PRV3(output_str(" Encryption Option"), verbose);
         break;
     case 0x27:
-        PRV3(printf(" New Environment Option"), verbose);
+        PRV3(output_str(" New Environment Option"), verbose);
         break;
     case 0x28:
-        PRV3(printf(" TN3270E"), verbose);
+        PRV3(output_str(" TN3270E"), verbose);
         break;
     case 0x29:
-        PRV3(printf(" X Auth"), verbose);
+        PRV3(output_str(" X Auth"), verbose);
         break;
     case 0x2a:
-        PRV3(printf(" Charset"), verbose);
+        PRV3(output_str(" Charset"), verbose);
         break;
     case 0x2b:
-        PRV3(printf(" Telnet Remote Serial Port"), verbose);
+        PRV3(output_str(" Telnet Remote Serial Port"), verbose);
         break;
     case 0x2c:
-        PRV3(printf(" Com Port Control Option"), verbose);
+        PRV3(output_str(" Com Port Control Option"), verbose);
         break;
     case 0x2d:
-        PRV3(printf(" Telnet Suppress Local Echo"), verbose);
+        PRV3(output_str(" Telnet Suppress Local Echo"), verbose);
         break;
     case 0x2e:
-        PRV3(printf(" Telnet Start TLS"), verbose);
+        PRV3(output_str(" Telnet Start TLS"), verbose);
         break;
     case 0x2f:
-        PRV3(printf(" Kermit"), verbose);
+        PRV3(output_str(" Kermit"), verbose);
         break;
     case 0x30:
-        PRV3(printf(" Send-URL"), verbose);
+        PRV3(output_str(" Send-URL"), verbose);
         break;
     case 0x31:
-        PRV3(printf(" Forward X"), verbose);
+        PRV3(output_str(" Forward X"), verbose);
         break;
     case 0x8a:
-        PRV3(printf(" Telopt-Pragma-Logon"), verbose);
+        PRV3(output_str(" Telopt-Pragma-Logon"), verbose);
         break;
     case 0x8b:
-        PRV3(printf(" Telopt-SSPI-Logon"), verbose);
+        PRV3(output_str(" Telopt-SSPI-Logon"), verbose);
         break;
     case 0x8c:
-        PRV3(printf(" Telopt-Pragma-Heartbeat"), verbose);
+        PRV3(output_str(" Telopt-Pragma-Heartbeat"), verbose);
         break;
     case 0xff:
-        PRV3(printf(" Extended-Options-List"), verbose);
+        PRV3(output_str(" Extended-Options-List"), verbose);
         break;
     }
 }
\ No newline at end of file
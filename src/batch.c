@@ -0,0 +1,115 @@
+#include "../include/batch.h"
+
+void batch_open(batch_t *batch, flow_table_t *flows) {
+
+    batch->flows = flows;
+    batch->nb = 0;
+}
+
+/**
+ * @brief Keep a frame until the batch is decoded
+ * @return 1 if the batch is full, 0 otherwise
+ */
+int batch_add(batch_t *batch, const struct pcap_pkthdr *header,
+              const u_char *packet) {
+
+    batch->headers[batch->nb] = *header;
+    batch->packets[batch->nb] = packet;
+    batch->nb++;
+
+    return batch->nb == BATCH_SIZE;
+}
+
+/**
+ * @brief First stage, start loading the headers of a frame, up to
+ * its captured length
+ */
+void batch_headers(const batch_t *batch, int i) {
+
+    uint32_t offset;
+
+    for (offset = 0; offset < BATCH_LINES * BATCH_LINE &&
+                     offset < batch->headers[i].caplen;
+         offset += BATCH_LINE)
+        __builtin_prefetch(batch->packets[i] + offset, 0, 3);
+}
+
+/**
+ * @brief Second stage, hash the flow of a frame from its headers and
+ * start loading the tags of its slot
+ */
+void batch_tags(batch_t *batch, int i) {
+
+    batch->hinted[i] =
+        flow_hint(batch->packets[i], batch->headers[i].caplen,
+                  &batch->hashes[i]);
+
+    if (batch->hinted[i])
+        flow_prefetch_tags(batch->flows, batch->hashes[i]);
+}
+
+/**
+ * @brief Third stage, start loading the flow of a frame
+ */
+void batch_flows(const batch_t *batch, int i) {
+
+    if (batch->hinted[i])
+        flow_prefetch_flows(batch->flows, batch->hashes[i]);
+}
+
+/**
+ * @brief Give the frames of the batch to the callback in order, the
+ * next frames going through the stages meanwhile. The batch is empty
+ * afterwards.
+ */
+void batch_run(batch_t *batch, pcap_handler callback, u_char *args) {
+
+    int i;
+
+    // the slots of a small table stay in the cache
+    int hint = batch->flows != NULL &&
+               batch->flows->count >= BATCH_FLOWS_MIN;
+
+    // the first frames of the batch skip the stages of their distance
+    for (i = 0; hint && i < BATCH_HEADERS && i < batch->nb; i++)
+        batch_headers(batch, i);
+    for (i = 0; hint && i < BATCH_TAGS && i < batch->nb; i++)
+        batch_tags(batch, i);
+    for (i = 0; hint && i < BATCH_FLOWS && i < batch->nb; i++)
+        batch_flows(batch, i);
+
+    for (i = 0; i < batch->nb; i++) {
+        if (hint && i + BATCH_HEADERS < batch->nb)
+            batch_headers(batch, i + BATCH_HEADERS);
+        if (hint && i + BATCH_TAGS < batch->nb)
+            batch_tags(batch, i + BATCH_TAGS);
+        if (hint && i + BATCH_FLOWS < batch->nb)
+            batch_flows(batch, i + BATCH_FLOWS);
+        callback(args, &batch->headers[i], batch->packets[i]);
+    }
+
+    batch->nb = 0;
+}
+
+/**
+ * @brief Give every frame of the file to the callback, equivalent of
+ * pcap_loop with a count of -1. The frames stay in the mapping, so
+ * they are decoded by batches.
+ * @return 0 at the end of file, -1 if the file is truncated
+ */
+int batch_loop(reader_t *reader, flow_table_t *flows,
+               pcap_handler callback, u_char *args) {
+
+    batch_t batch;
+    int ret;
+
+    // the records are read straight into the batch
+    batch_open(&batch, flows);
+    while ((ret = reader_next(reader, &batch.headers[batch.nb],
+                              &batch.packets[batch.nb])) == 1)
+        if (++batch.nb == BATCH_SIZE)
+            batch_run(&batch, callback, args);
+    batch_run(&batch, callback, args);
+
+    return ret;
+}
@@ -0,0 +1,106 @@
+#include "../include/classify.h"
+
+/*
+ * Headless dissection of verbose level 0: the same decoders as the
+ * analyzers fill the packet_t, but nothing is converted to a string
+ * and no payload is walked byte by byte.
+ */
+
+/**
+ * @brief Decode the TCP or UDP header and find the application
+ * protocol
+ */
+void classify_transport(packet_t *pkt, const u_char *packet,
+                        int length) {
+
+    switch (pkt->ip_proto) {
+
+    case IPPROTO_TCP:
+        tcp_decode(pkt, packet);
+        flow_packet(pkt);
+        packet += pkt->tcp_off * 4;
+        length -= pkt->tcp_off * 4;
+        tcp_classify(pkt, packet, length);
+        break;
+
+    case IPPROTO_UDP:
+        udp_decode(pkt, packet);
+        flow_packet(pkt);
+        pkt->app = udp_app(pkt);
+        if (pkt->app == APP_DNS)
+            resolver_packet(pkt, packet + sizeof(struct udphdr),
+                            length - sizeof(struct udphdr));
+        break;
+    }
+}
+
+/**
+ * @brief Decode the IPv4 header and the protocols it carries
+ */
+void classify_ip(packet_t *pkt, const u_char *packet, int length) {
+
+    ip_decode(pkt, packet);
+    packet += pkt->ip_hdr_len;
+    length -= pkt->ip_hdr_len;
+
+    // fragments wait for the whole datagram
+    if ((packet = ip_payload(pkt, packet, &length)) == NULL)
+        return;
+
+    classify_transport(pkt, packet, length);
+}
+
+/**
+ * @brief Decode the IPv6 header, walk its extension headers and
+ * classify the protocol they carry
+ */
+void classify_ipv6(packet_t *pkt, const u_char *packet, int length) {
+
+    int offset;
+
+    ipv6_decode(pkt, packet);
+    packet += sizeof(struct ip6_hdr);
+    length -= sizeof(struct ip6_hdr);
+
+    if ((offset = ipv6_walk(pkt, packet, length)) < 0)
+        return;
+    packet += offset;
+    length -= offset;
+
+    // fragments wait for the whole datagram
+    if (pkt->ip_frag_off != 0) {
+        if ((packet = frag_ip(pkt, packet, &length)) == NULL ||
+            (offset = ipv6_walk(pkt, packet, length)) < 0 ||
+            pkt->ip_frag_off != 0)
+            return;
+        packet += offset;
+        length -= offset;
+    }
+
+    classify_transport(pkt, packet, length);
+}
+
+/**
+ * @brief Decode the frame down to the application protocol, behind
+ * its tunnels
+ */
+void classify_packet(packet_t *pkt, const u_char *packet, int length) {
+
+    ethernet_decode(pkt, packet);
+    packet += sizeof(struct ether_header);
+    length -= sizeof(struct ether_header);
+
+    if ((packet = tunnel_decap(pkt, packet, &length, 0)) == NULL)
+        return;
+
+    switch (pkt->ether_type) {
+
+    case ETHERTYPE_IP:
+        classify_ip(pkt, packet, length);
+        break;
+
+    case ETHERTYPE_IPV6:
+        classify_ipv6(pkt, packet, length);
+        break;
+    }
+}
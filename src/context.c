@@ -0,0 +1,157 @@
+#include "../include/context.h"
+#include "../include/resolver.h"
+#include "../include/stream.h"
+
+void init_context(context_t *ctx, int verbose) {
+
+    memset(ctx, 0, sizeof(context_t));
+    ctx->verbose = verbose;
+}
+
+/**
+ * @brief Add the counters of a worker to the total
+ */
+void merge_context(context_t *dst, const context_t *src) {
+
+    dst->count += src->count;
+    dst->bytes += src->bytes;
+    dst->received += src->received;
+    dst->dropped += src->dropped;
+    dst->ipv4 += src->ipv4;
+    dst->ipv6 += src->ipv6;
+    dst->arp += src->arp;
+    dst->tcp += src->tcp;
+    dst->udp += src->udp;
+    dst->icmp += src->icmp;
+
+    int i;
+    for (i = 0; i < APP_MAX; i++)
+        dst->apps[i] += src->apps[i];
+
+    dst->flow_count += src->flow_count;
+    dst->flow_untracked += src->flow_untracked;
+    dst->frag_count += src->frag_count;
+    dst->frag_lost += src->frag_lost;
+}
+
+/**
+ * @brief Keep the counters of the flow table and free it, then the
+ * reassembly whose connections were released with the flows
+ */
+void close_flows(context_t *ctx) {
+
+    if (ctx->flows == NULL)
+        return;
+
+    ctx->flow_count += ctx->flows->created;
+    ctx->flow_untracked += ctx->flows->dropped;
+    flow_close(ctx->flows);
+    ctx->flows = NULL;
+
+    if (ctx->streams != NULL)
+        stream_close(ctx->streams);
+    ctx->streams = NULL;
+}
+
+/**
+ * @brief Keep the counters of the fragments and free the datagrams
+ * still waiting, which are lost
+ */
+void close_frags(context_t *ctx) {
+
+    if (ctx->frags == NULL)
+        return;
+
+    ctx->frag_count += ctx->frags->reassembled;
+    ctx->frag_lost += ctx->frags->lost + ctx->frags->datagrams.used -
+                      (ctx->frags->done != NULL);
+    frag_close(ctx->frags);
+    ctx->frags = NULL;
+}
+
+/**
+ * @brief Print the last counters of the DNS transactions and free the
+ * queries still waiting
+ */
+void close_resolvers(context_t *ctx) {
+
+    if (ctx->resolvers == NULL)
+        return;
+
+    resolver_close(ctx->resolvers);
+    ctx->resolvers = NULL;
+}
+
+/**
+ * @brief Count a classified frame by network, transport and
+ * application protocol
+ */
+void count_protocols(context_t *ctx, const packet_t *pkt) {
+
+    switch (pkt->ether_type) {
+    case ETHERTYPE_IP:
+        ctx->ipv4++;
+        break;
+    case ETHERTYPE_IPV6:
+        ctx->ipv6++;
+        break;
+    case ETHERTYPE_ARP:
+        ctx->arp++;
+        break;
+    }
+
+    if (pkt->ip_version != 0) {
+        switch (pkt->ip_proto) {
+        case IPPROTO_TCP:
+            ctx->tcp++;
+            break;
+        case IPPROTO_UDP:
+            ctx->udp++;
+            break;
+        case IPPROTO_ICMP:
+        case IPPROTO_ICMPV6:
+            ctx->icmp++;
+            break;
+        }
+    }
+
+    ctx->apps[pkt->app]++;
+}
+
+/**
+ * @brief Print the counters on stderr, so they do not mix with the
+ * frames
+ */
+void print_context(const context_t *ctx, const char *name) {
+
+    fprintf(stderr,
+            "%s : %lu frames, %lu bytes, %lu received, %lu dropped\n",
+            name, ctx->count, ctx->bytes, ctx->received,
+            ctx->dropped);
+}
+
+/**
+ * @brief Print the frames counted by protocol on stderr
+ */
+void print_summary(const context_t *ctx) {
+
+    unsigned long ip = ctx->ipv4 + ctx->ipv6;
+
+    fprintf(stderr,
+            "Network : %lu IPv4, %lu IPv6, %lu ARP, %lu other\n"
+            "Transport : %lu TCP, %lu UDP, %lu ICMP, %lu other\n"
+            "Application :",
+            ctx->ipv4, ctx->ipv6, ctx->arp,
+            ctx->count - ip - ctx->arp, ctx->tcp, ctx->udp, ctx->icmp,
+            ip - ctx->tcp - ctx->udp - ctx->icmp);
+
+    int i;
+    for (i = 1; i < APP_MAX; i++)
+        fprintf(stderr, " %lu %s,", ctx->apps[i], app_name(i));
+    fprintf(stderr, " %lu other\n", ctx->apps[APP_NONE]);
+
+    fprintf(stderr, "Flows : %lu flows, %lu not tracked\n",
+            ctx->flow_count, ctx->flow_untracked);
+    fprintf(stderr, "Fragments : %lu datagrams, %lu lost\n",
+            ctx->frag_count, ctx->frag_lost);
+}
@@ -0,0 +1,188 @@
+#include "../include/dump.h"
+
+/**
+ * @brief Create the capture file and write its header. Frames are
+ * then written as classic pcap records with timestamps in
+ * microseconds.
+ * @return 0 on success, -1 on error with errno set
+ */
+int dump_open(dump_t *dump, const char *file, uint32_t snaplen) {
+
+    struct pcap_file_hdr hdr;
+
+    dump->nb = 0;
+    dump->dumper = NULL;
+    dump->buffer = NULL;
+
+    if ((dump->fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+                         0644)) == -1)
+        return -1;
+
+    hdr.magic = PCAP_MAGIC;
+    hdr.version_major = 2;
+    hdr.version_minor = 4;
+    hdr.thiszone = 0;
+    hdr.sigfigs = 0;
+    hdr.snaplen = snaplen;
+    hdr.linktype = DUMP_LINKTYPE;
+
+    if (write(dump->fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        close(dump->fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Create the capture file with libpcap, for the frames which
+ * do not stay in memory after the callback. They are copied in a
+ * large buffer so the file is written by big pieces.
+ * @return 0 on success, -1 on error
+ */
+int dump_open_pcap(dump_t *dump, pcap_t *handle, const char *file) {
+
+    FILE *stream;
+
+    dump->fd = -1;
+    dump->nb = 0;
+
+    if ((stream = fopen(file, "w")) == NULL)
+        return -1;
+
+    // the buffer must be set before the header is written
+    if ((dump->buffer = malloc(DUMP_BUFFER)) == NULL ||
+        setvbuf(stream, dump->buffer, _IOFBF, DUMP_BUFFER) != 0 ||
+        (dump->dumper = pcap_dump_fopen(handle, stream)) == NULL) {
+        fclose(stream);
+        free(dump->buffer);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Write with a batch of its own in a file already opened, by
+ * another thread or for the frames of a chunk
+ */
+void dump_share(dump_t *dump, int fd) {
+
+    dump->fd = fd;
+    dump->nb = 0;
+    dump->dumper = NULL;
+    dump->buffer = NULL;
+}
+
+/**
+ * @brief Write the frames of the batch with as few calls as possible
+ * @return 0 on success, -1 on error with errno set
+ */
+int dump_flush(dump_t *dump) {
+
+    if (dump->dumper != NULL)
+        return pcap_dump_flush(dump->dumper);
+
+    struct iovec *iov = dump->iov;
+    int nb = 2 * dump->nb;
+    ssize_t n;
+
+    dump->nb = 0;
+
+    while (nb > 0) {
+
+        if ((n = writev(dump->fd, iov, nb)) == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        // a write can stop in the middle of a piece
+        while (nb > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            nb--;
+        }
+        if (nb > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Add the frame to the batch, without copying it
+ */
+void dump_packet(dump_t *dump, const struct pcap_pkthdr *header,
+                 const u_char *packet) {
+
+    if (dump->dumper != NULL) {
+        pcap_dump((u_char *)dump->dumper, header, packet);
+        return;
+    }
+
+    struct pcap_record_hdr *hdr = &dump->hdrs[dump->nb];
+    struct iovec *iov = &dump->iov[2 * dump->nb];
+
+    hdr->ts_sec = header->ts.tv_sec;
+    hdr->ts_usec = header->ts.tv_usec;
+    hdr->caplen = header->caplen;
+    hdr->len = header->len;
+
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = sizeof(struct pcap_record_hdr);
+    iov[1].iov_base = (void *)packet;
+    iov[1].iov_len = header->caplen;
+
+    if (++dump->nb == DUMP_BATCH)
+        CHK(dump_flush(dump));
+}
+
+/**
+ * @brief Append the records written in another file, such as the
+ * frames of a chunk
+ * @return 0 on success, -1 on error
+ */
+int dump_append(dump_t *dump, FILE *file) {
+
+    char buf[1 << 16];
+    size_t n;
+
+    if (dump_flush(dump) == -1)
+        return -1;
+
+    rewind(file);
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        if (write(dump->fd, buf, n) != (ssize_t)n)
+            return -1;
+
+    return ferror(file) ? -1 : 0;
+}
+
+/**
+ * @brief Write the frames left and close the file
+ * @return 0 on success, -1 on error
+ */
+int dump_close(dump_t *dump) {
+
+    int ret = 0;
+
+    if (dump->dumper != NULL) {
+        if (pcap_dump_flush(dump->dumper) == -1)
+            ret = -1;
+        pcap_dump_close(dump->dumper);
+        free(dump->buffer);
+        dump->dumper = NULL;
+        return ret;
+    }
+
+    if (dump_flush(dump) == -1)
+        ret = -1;
+    if (close(dump->fd) == -1)
+        ret = -1;
+    dump->fd = -1;
+
+    return ret;
+}
@@ -0,0 +1,275 @@
+#include "../include/filter.h"
+
+// Keywords of a protocol and the primitive they stand for
+static const struct {
+    const char *name;
+    uint8_t kind;
+    uint16_t value;
+    uint8_t ipv4;
+} filter_protos[] = {
+    {"ip", FILTER_ETHER, ETHERTYPE_IP, 0},
+    {"ip6", FILTER_ETHER, ETHERTYPE_IPV6, 0},
+    {"arp", FILTER_ETHER, ETHERTYPE_ARP, 0},
+    {"rarp", FILTER_ETHER, ETHERTYPE_REVARP, 0},
+    {"tcp", FILTER_PROTO, IPPROTO_TCP, 0},
+    {"udp", FILTER_PROTO, IPPROTO_UDP, 0},
+    {"sctp", FILTER_PROTO, IPPROTO_SCTP, 0},
+    {"icmp", FILTER_PROTO, IPPROTO_ICMP, 1},
+};
+
+/**
+ * @brief Translate the expression into primitives joined by "and",
+ * such as "tcp", "udp port 53", "src host 10.0.0.1" or
+ * "ip and dst port 80". The expression is already known to be valid.
+ * @return number of primitives, -1 if the expression is not that
+ * simple
+ */
+int filter_parse(filter_t *filter, const char *expression) {
+
+    size_t nb_protos = sizeof(filter_protos) / sizeof(*filter_protos);
+    char copy[256], *save, *word;
+    int nb = 0, expect = 1;
+
+    if (strlen(expression) >= sizeof(copy))
+        return -1;
+    strcpy(copy, expression);
+
+    word = strtok_r(copy, " \t\n", &save);
+    while (word != NULL) {
+
+        if (!expect) {
+            // only a conjunction can follow a primitive
+            if (strcmp(word, "and") != 0 && strcmp(word, "&&") != 0)
+                return -1;
+            expect = 1;
+            word = strtok_r(NULL, " \t\n", &save);
+            continue;
+        }
+
+        size_t i;
+        for (i = 0; i < nb_protos; i++)
+            if (strcmp(word, filter_protos[i].name) == 0)
+                break;
+
+        // protocol, alone or qualifying a port or a host
+        if (i < nb_protos) {
+            if (nb == FILTER_MAX_TERMS)
+                return -1;
+            filter->terms[nb].kind = filter_protos[i].kind;
+            filter->terms[nb].value = filter_protos[i].value;
+            filter->terms[nb].ipv4 = filter_protos[i].ipv4;
+            nb++;
+            expect = 0;
+            if ((word = strtok_r(NULL, " \t\n", &save)) == NULL)
+                break;
+        }
+
+        uint8_t dir = FILTER_ANY;
+        if (strcmp(word, "src") == 0)
+            dir = FILTER_SRC;
+        else if (strcmp(word, "dst") == 0)
+            dir = FILTER_DST;
+        if (dir != FILTER_ANY &&
+            (word = strtok_r(NULL, " \t\n", &save)) == NULL)
+            return -1;
+
+        if (strcmp(word, "port") == 0 || strcmp(word, "host") == 0) {
+
+            char *arg = strtok_r(NULL, " \t\n", &save);
+            char *end;
+            if (arg == NULL || nb == FILTER_MAX_TERMS)
+                return -1;
+
+            filter_term_t *term = &filter->terms[nb++];
+            term->dir = dir;
+
+            if (word[0] == 'p') {
+                // service names are left to libpcap
+                unsigned long port = strtoul(arg, &end, 10);
+                if (!isdigit(arg[0]) || *end != '\0' || port > 0xffff)
+                    return -1;
+                term->kind = FILTER_PORT;
+                term->value = port;
+            } else {
+                struct in_addr addr;
+                if (inet_pton(AF_INET, arg, &addr) != 1)
+                    return -1;
+                term->kind = FILTER_HOST;
+                term->addr = addr.s_addr;
+            }
+
+            word = strtok_r(NULL, " \t\n", &save);
+        } else if (dir != FILTER_ANY) {
+            return -1;
+        } else if (i == nb_protos) {
+            return -1;
+        }
+
+        expect = 0;
+    }
+
+    return expect ? -1 : nb;
+}
+
+/**
+ * @brief Compile the filter once for every frame of a file. The bpf
+ * program checks the expression, and the simple expressions are also
+ * translated into primitives tested without it.
+ * @return 0 on success, -1 on error with its message in errbuf, of
+ * PCAP_ERRBUF_SIZE bytes
+ */
+int filter_compile(filter_t *filter, const char *expression,
+                   int snaplen, char *errbuf) {
+
+    pcap_t *dead = pcap_open_dead(DLT_EN10MB, snaplen);
+    if (dead == NULL) {
+        snprintf(errbuf, PCAP_ERRBUF_SIZE, "%s", strerror(errno));
+        return -1;
+    }
+
+    if (pcap_compile(dead, &filter->prog, expression, 1,
+                     PCAP_NETMASK_UNKNOWN) == -1) {
+        snprintf(errbuf, PCAP_ERRBUF_SIZE, "%s", pcap_geterr(dead));
+        pcap_close(dead);
+        return -1;
+    }
+    pcap_close(dead);
+
+    filter->nb_terms = filter_parse(filter, expression);
+
+    return 0;
+}
+
+/**
+ * @brief Match the port of a TCP, UDP or SCTP segment. As libpcap
+ * does, IPv4 fragments other than the first one never match and IPv6
+ * extension headers are not skipped.
+ * @return 1 if the frame matches, 0 otherwise
+ */
+int filter_port(const filter_term_t *term, const u_char *l3,
+                uint32_t length, uint16_t type) {
+
+    uint32_t off;
+    uint8_t proto;
+
+    if (type == ETHERTYPE_IP) {
+        if (length < 10)
+            return 0;
+        proto = l3[9];
+        if (((l3[6] << 8 | l3[7]) & IP_OFFMASK) != 0)
+            return 0;
+        off = (l3[0] & 0xf) * 4;
+    } else if (type == ETHERTYPE_IPV6) {
+        if (length < 7)
+            return 0;
+        proto = l3[6];
+        off = sizeof(struct ip6_hdr);
+    } else
+        return 0;
+
+    if (proto != IPPROTO_TCP && proto != IPPROTO_UDP &&
+        proto != IPPROTO_SCTP)
+        return 0;
+
+    // source first, the destination is not read if it matches
+    if (term->dir != FILTER_DST && length >= off + 2 &&
+        (l3[off] << 8 | l3[off + 1]) == term->value)
+        return 1;
+
+    return term->dir != FILTER_SRC && length >= off + 4 &&
+           (l3[off + 2] << 8 | l3[off + 3]) == term->value;
+}
+
+/**
+ * @brief Match an IPv4 address of the IP header, or the protocol
+ * addresses of ARP and RARP as libpcap does for "host"
+ * @return 1 if the frame matches, 0 otherwise
+ */
+int filter_host(const filter_term_t *term, const u_char *l3,
+                uint32_t length, uint16_t type) {
+
+    uint32_t src, dst;
+
+    if (type == ETHERTYPE_IP) {
+        src = 12;
+        dst = 16;
+    } else if (type == ETHERTYPE_ARP || type == ETHERTYPE_REVARP) {
+        src = 14;
+        dst = 24;
+    } else
+        return 0;
+
+    if (term->dir != FILTER_DST && length >= src + 4 &&
+        memcmp(l3 + src, &term->addr, 4) == 0)
+        return 1;
+
+    return term->dir != FILTER_SRC && length >= dst + 4 &&
+           memcmp(l3 + dst, &term->addr, 4) == 0;
+}
+
+/**
+ * @brief Test one primitive on the frame, reading past the captured
+ * bytes never matches
+ * @return 1 if the frame matches, 0 otherwise
+ */
+int filter_term(const filter_term_t *term, const u_char *packet,
+                uint32_t caplen) {
+
+    if (caplen < ETHER_HDR_LEN)
+        return 0;
+
+    uint16_t type = packet[12] << 8 | packet[13];
+    const u_char *l3 = packet + ETHER_HDR_LEN;
+    uint32_t length = caplen - ETHER_HDR_LEN;
+
+    switch (term->kind) {
+
+    case FILTER_ETHER:
+        return type == term->value;
+
+    case FILTER_PROTO:
+        if (type == ETHERTYPE_IP)
+            return length > 9 && l3[9] == term->value;
+        if (type != ETHERTYPE_IPV6 || term->ipv4 || length <= 6)
+            return 0;
+        // libpcap also looks behind a fragment header
+        if (l3[6] == term->value)
+            return 1;
+        return l3[6] == IPPROTO_FRAGMENT &&
+               length > sizeof(struct ip6_hdr) &&
+               l3[sizeof(struct ip6_hdr)] == term->value;
+
+    case FILTER_PORT:
+        return filter_port(term, l3, length, type);
+
+    case FILTER_HOST:
+        return filter_host(term, l3, length, type);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Tell if the frame is kept by the filter, with the primitives
+ * when there are and with the bpf program otherwise
+ * @return 1 if the frame matches, 0 otherwise
+ */
+int filter_match(const filter_t *filter,
+                 const struct pcap_pkthdr *header,
+                 const u_char *packet) {
+
+    if (filter->nb_terms < 0)
+        return pcap_offline_filter(&filter->prog, header, packet) != 0;
+
+    int i;
+    for (i = 0; i < filter->nb_terms; i++)
+        if (!filter_term(&filter->terms[i], packet, header->caplen))
+            return 0;
+
+    return 1;
+}
+
+/**
+ * @brief Free the bpf program
+ */
+void filter_free(filter_t *filter) { pcap_freecode(&filter->prog); }
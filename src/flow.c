@@ -0,0 +1,534 @@
+#include "../include/flow.h"
+
+_Static_assert(sizeof(flow_key_t) == 40, "flow key hashed by words");
+_Static_assert(sizeof(flow_t) == 64, "flow on one cache line");
+
+/**
+ * @brief Allocate the slots of the table, all empty
+ * @return 0 on success, -1 on error with errno set
+ */
+int flow_alloc(flow_table_t *table, size_t capacity) {
+
+    table->tags = aligned_alloc(FLOW_GROUP, capacity);
+    table->flows =
+        aligned_alloc(sizeof(flow_t), capacity * sizeof(flow_t));
+    if (table->tags == NULL || table->flows == NULL) {
+        free(table->tags);
+        free(table->flows);
+        return -1;
+    }
+
+    memset(table->tags, FLOW_EMPTY, capacity);
+    table->mask = capacity - 1;
+    table->count = 0;
+    table->deleted = 0;
+    table->hand = 0;
+
+    return 0;
+}
+
+/**
+ * @brief Allocate a table of at least the given number of flows, the
+ * flows are preallocated and only touched once used
+ * @return 0 on success, -1 on error with errno set
+ */
+int flow_open(flow_table_t *table, size_t capacity, uint32_t timeout) {
+
+    size_t size = FLOW_GROUP;
+    while (size < capacity)
+        size <<= 1;
+
+    table->timeout = timeout;
+    table->expects = 0;
+    table->generation = 0;
+    table->created = 0;
+    table->dropped = 0;
+    table->release = NULL;
+    table->args = NULL;
+
+    return flow_alloc(table, size);
+}
+
+/**
+ * @brief Hash the key word by word
+ */
+uint64_t flow_hash(const flow_key_t *key) {
+
+    uint64_t words[sizeof(flow_key_t) / sizeof(uint64_t)];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    memcpy(words, key, sizeof(words));
+    for (i = 0; i < sizeof(words) / sizeof(*words); i++) {
+        hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compare two keys word by word
+ * @return 1 if they are equal, 0 otherwise
+ */
+int flow_equal(const flow_key_t *a, const flow_key_t *b) {
+
+    uint64_t x[sizeof(flow_key_t) / sizeof(uint64_t)];
+    uint64_t y[sizeof(flow_key_t) / sizeof(uint64_t)];
+    uint64_t diff = 0;
+    size_t i;
+
+    memcpy(x, a, sizeof(x));
+    memcpy(y, b, sizeof(y));
+    for (i = 0; i < sizeof(x) / sizeof(*x); i++)
+        diff |= x[i] ^ y[i];
+
+    return diff == 0;
+}
+
+/**
+ * @brief Compare every tag of a group to the tag
+ * @return one bit by slot whose tag is equal
+ */
+uint32_t flow_group_match(const int8_t *group, int8_t tag) {
+
+#ifdef __SSE2__
+    __m128i tags = _mm_load_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < FLOW_GROUP; i++)
+        if (group[i] == tag)
+            mask |= 1U << i;
+    return mask;
+#endif
+}
+
+/**
+ * @brief Find the slots of a group which are empty or deleted, the
+ * only tags with their highest bit set
+ * @return one bit by free slot
+ */
+uint32_t flow_group_free(const int8_t *group) {
+
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+#else
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < FLOW_GROUP; i++)
+        if (group[i] < 0)
+            mask |= 1U << i;
+    return mask;
+#endif
+}
+
+/**
+ * @brief Look for the key group after group. The search ends at the
+ * first group with an empty slot, the key cannot be after it.
+ * @return the slot of the flow if found, otherwise the first free
+ * slot where it can be added
+ */
+size_t flow_probe(const flow_table_t *table, const flow_key_t *key,
+                  uint64_t hash, int *found) {
+
+    int8_t tag = hash & 0x7f;
+    size_t pos = (hash >> 7) & table->mask & ~(size_t)(FLOW_GROUP - 1);
+    size_t step = 0, slot = SIZE_MAX;
+    uint32_t match, free;
+
+    for (;;) {
+
+        const int8_t *group = table->tags + pos;
+
+        match = flow_group_match(group, tag);
+        while (match != 0) {
+            size_t i = pos + __builtin_ctz(match);
+            if (flow_equal(&table->flows[i].key, key)) {
+                *found = 1;
+                return i;
+            }
+            match &= match - 1;
+        }
+
+        free = flow_group_free(group);
+        if (slot == SIZE_MAX && free != 0)
+            slot = pos + __builtin_ctz(free);
+        if (flow_group_match(group, FLOW_EMPTY) != 0)
+            break;
+
+        // triangular steps visit every group once
+        step += FLOW_GROUP;
+        pos = (pos + step) & table->mask;
+    }
+
+    *found = 0;
+    return slot;
+}
+
+/**
+ * @brief Remove the flow of a slot. The slot is empty again if no
+ * search went past its group, deleted otherwise.
+ */
+void flow_remove(flow_table_t *table, size_t slot) {
+
+    flow_t *flow = &table->flows[slot];
+    size_t group = slot & ~(size_t)(FLOW_GROUP - 1);
+
+    if (flow->data != NULL && table->release != NULL)
+        table->release(flow, table->args);
+    flow->data = NULL;
+
+    if (flow->key.expect)
+        table->expects--;
+
+    if (flow_group_match(table->tags + group, FLOW_EMPTY) != 0)
+        table->tags[slot] = FLOW_EMPTY;
+    else {
+        table->tags[slot] = FLOW_DELETED;
+        table->deleted++;
+    }
+    table->count--;
+}
+
+/**
+ * @brief Check the next slots and remove their flow if it is idle.
+ * Frames of a file can go back in time a little, a flow seen after
+ * now is not idle.
+ */
+void flow_expire(flow_table_t *table, uint32_t now, size_t budget) {
+
+    while (budget-- > 0) {
+
+        size_t slot = table->hand;
+        table->hand = (table->hand + 1) & table->mask;
+
+        if (table->tags[slot] >= 0 && now > table->flows[slot].last &&
+            now - table->flows[slot].last > table->timeout)
+            flow_remove(table, slot);
+    }
+}
+
+/**
+ * @brief Add again every flow to new slots, so the deleted slots are
+ * empty again
+ * @return 0 on success, -1 on error with errno set
+ */
+int flow_rebuild(flow_table_t *table) {
+
+    flow_table_t old = *table;
+    size_t i, slot;
+    int found;
+
+    if (flow_alloc(table, old.mask + 1) == -1) {
+        *table = old;
+        return -1;
+    }
+
+    for (i = 0; i <= old.mask; i++) {
+        if (old.tags[i] < 0)
+            continue;
+        slot = flow_probe(table, &old.flows[i].key,
+                          flow_hash(&old.flows[i].key), &found);
+        table->tags[slot] = old.tags[i];
+        table->flows[slot] = old.flows[i];
+        table->count++;
+    }
+    table->hand = old.hand;
+
+    free(old.tags);
+    free(old.flows);
+
+    return 0;
+}
+
+/**
+ * @brief Add a flow, after removing some idle ones. The flows already
+ * found stay where they are.
+ * @return the flow, NULL if the table is full
+ */
+flow_t *flow_insert(flow_table_t *table, const flow_key_t *key,
+                    uint32_t now) {
+
+    uint64_t hash = flow_hash(key);
+    size_t slot;
+    int found;
+
+    flow_expire(table, now, FLOW_SWEEP);
+
+    if (table->count + table->deleted + 1 >
+        (table->mask + 1) / 8 * FLOW_LOAD)
+        return NULL;
+
+    slot = flow_probe(table, key, hash, &found);
+    if (table->tags[slot] == FLOW_DELETED)
+        table->deleted--;
+    table->tags[slot] = hash & 0x7f;
+    table->count++;
+    table->created++;
+
+    flow_t *flow = &table->flows[slot];
+    memset(flow, 0, sizeof(flow_t));
+    flow->key = *key;
+    flow->first = now;
+    flow->last = now;
+    flow->generation = table->generation;
+
+    return flow;
+}
+
+/**
+ * @brief Build the key of the flow of a TCP or UDP segment
+ * @return the endpoint of the key which sent the segment
+ */
+int flow_key(flow_key_t *key, const packet_t *pkt) {
+
+    uint64_t src[2], dst[2];
+
+    if (pkt->ip_version == 4) {
+        // ::ffff:a.b.c.d
+        uint32_t mapped[4] = {0, 0, htonl(0xffff), 0};
+        mapped[3] = pkt->ip_src.v4.s_addr;
+        memcpy(src, mapped, sizeof(src));
+        mapped[3] = pkt->ip_dst.v4.s_addr;
+        memcpy(dst, mapped, sizeof(dst));
+    } else {
+        memcpy(src, &pkt->ip_src.v6, sizeof(src));
+        memcpy(dst, &pkt->ip_dst.v6, sizeof(dst));
+    }
+
+    // any order works as long as it is always the same
+    int side = src[0] != dst[0]   ? src[0] > dst[0]
+               : src[1] != dst[1] ? src[1] > dst[1]
+                                  : pkt->sport > pkt->dport;
+
+    memcpy(&key->addr[side], src, sizeof(src));
+    memcpy(&key->addr[!side], dst, sizeof(dst));
+    // the bytes after the protocol are hashed too
+    memset(key->port, 0, sizeof(flow_key_t) - 2 * sizeof(src));
+    key->port[side] = pkt->sport;
+    key->port[!side] = pkt->dport;
+    key->proto = pkt->ip_proto;
+
+    return side;
+}
+
+/**
+ * @brief Give the flow the application announced for it by another
+ * flow, such as the data connection of FTP. It is only looked for
+ * once by expectation added.
+ */
+void flow_expected(flow_table_t *table, flow_t *flow) {
+
+    flow_key_t key;
+    size_t slot;
+    int side, found;
+
+    flow->generation = table->generation;
+    if (table->expects == 0 || flow->app != APP_NONE ||
+        flow->key.expect)
+        return;
+
+    for (side = 0; side < 2; side++) {
+
+        key = flow->key;
+        key.port[0] = flow->key.port[side];
+        key.port[1] = 0;
+        key.expect = 1;
+
+        slot = flow_probe(table, &key, flow_hash(&key), &found);
+        if (found) {
+            flow->app = table->flows[slot].app;
+            flow_remove(table, slot);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Find the flow of a TCP or UDP segment, or add it
+ */
+void flow_packet(packet_t *pkt) {
+
+    flow_table_t *table = pkt->ctx->flows;
+    flow_key_t key;
+    flow_t *flow;
+    size_t slot;
+    int side, found;
+
+    if (table == NULL)
+        return;
+
+    side = flow_key(&key, pkt);
+    slot = flow_probe(table, &key, flow_hash(&key), &found);
+
+    if (found)
+        flow = &table->flows[slot];
+    else {
+        // too many deleted slots, they are cleaned up once
+        if ((flow = flow_insert(table, &key, pkt->ts)) == NULL &&
+            table->deleted > (table->mask + 1) / 16 &&
+            flow_rebuild(table) == 0)
+            flow = flow_insert(table, &key, pkt->ts);
+        if (flow == NULL) {
+            table->dropped++;
+            return;
+        }
+        flow->opener = side;
+    }
+
+    flow->last = pkt->ts;
+    flow->packets++;
+    if (flow->generation != table->generation)
+        flow_expected(table, flow);
+
+    pkt->flow = flow;
+    pkt->flow_dir = side != flow->opener;
+}
+
+/**
+ * @brief Hash the flow of a plain Ethernet frame carrying TCP or UDP
+ * over IPv4 or IPv6, before the frame is decoded. Tunnels, extension
+ * headers and fragments are left to the decoders, the hash is only
+ * used to load the slots early.
+ * @return 1 if the frame has a flow, 0 otherwise
+ */
+int flow_hint(const u_char *packet, uint32_t caplen, uint64_t *hash) {
+
+    const struct ether_header *eth;
+    const struct iphdr *ip;
+    const struct ip6_hdr *ip6;
+    flow_key_t key;
+    packet_t pkt;
+    uint32_t offset = sizeof(struct ether_header);
+    uint16_t ports[2];
+
+    if (caplen < offset + sizeof(struct ip6_hdr))
+        return 0;
+
+    eth = (const struct ether_header *)packet;
+    switch (ntohs(eth->ether_type)) {
+
+    case ETHERTYPE_IP:
+        ip = (const struct iphdr *)(packet + offset);
+        if (ip->version != 4 ||
+            (ntohs(ip->frag_off) & (IP_MF | IP_OFFMASK)) != 0)
+            return 0;
+        pkt.ip_version = 4;
+        pkt.ip_proto = ip->protocol;
+        pkt.ip_src.v4.s_addr = ip->saddr;
+        pkt.ip_dst.v4.s_addr = ip->daddr;
+        offset += ip->ihl * 4;
+        break;
+
+    case ETHERTYPE_IPV6:
+        ip6 = (const struct ip6_hdr *)(packet + offset);
+        pkt.ip_version = 6;
+        pkt.ip_proto = ip6->ip6_nxt;
+        memcpy(&pkt.ip_src.v6, &ip6->ip6_src, sizeof(struct in6_addr));
+        memcpy(&pkt.ip_dst.v6, &ip6->ip6_dst, sizeof(struct in6_addr));
+        offset += sizeof(struct ip6_hdr);
+        break;
+
+    default:
+        return 0;
+    }
+
+    if ((pkt.ip_proto != IPPROTO_TCP && pkt.ip_proto != IPPROTO_UDP) ||
+        caplen < offset + sizeof(ports))
+        return 0;
+
+    memcpy(ports, packet + offset, sizeof(ports));
+    pkt.sport = ntohs(ports[0]);
+    pkt.dport = ntohs(ports[1]);
+
+    flow_key(&key, &pkt);
+    *hash = flow_hash(&key);
+
+    return 1;
+}
+
+/**
+ * @brief Start loading the tags of the first group probed for the hash
+ */
+void flow_prefetch_tags(const flow_table_t *table, uint64_t hash) {
+
+    size_t pos = (hash >> 7) & table->mask & ~(size_t)(FLOW_GROUP - 1);
+
+    __builtin_prefetch(table->tags + pos, 0, 3);
+}
+
+/**
+ * @brief Start loading the flows of the first group whose tag is the
+ * one of the hash, or its first free slot for a new flow. The tags
+ * should be loaded already.
+ */
+void flow_prefetch_flows(const flow_table_t *table, uint64_t hash) {
+
+    size_t pos = (hash >> 7) & table->mask & ~(size_t)(FLOW_GROUP - 1);
+    uint32_t match = flow_group_match(table->tags + pos, hash & 0x7f);
+
+    // a new flow takes the first free slot
+    if (match == 0) {
+        match = flow_group_free(table->tags + pos);
+        match &= 0U - match;
+    }
+
+    while (match != 0) {
+        __builtin_prefetch(&table->flows[pos + __builtin_ctz(match)],
+                           1, 3);
+        match &= match - 1;
+    }
+}
+
+/**
+ * @brief Announce a flow between the same hosts as the segment, with
+ * one of its ports known, which belongs to the application
+ */
+void flow_expect(const packet_t *pkt, uint16_t port, uint8_t app) {
+
+    flow_table_t *table = pkt->ctx->flows;
+    flow_key_t key;
+    flow_t *flow;
+    size_t slot;
+    int found;
+
+    if (table == NULL || pkt->flow == NULL)
+        return;
+
+    key = pkt->flow->key;
+    key.port[0] = port;
+    key.port[1] = 0;
+    key.expect = 1;
+
+    slot = flow_probe(table, &key, flow_hash(&key), &found);
+    if (found)
+        flow = &table->flows[slot];
+    else if ((flow = flow_insert(table, &key, pkt->ts)) != NULL)
+        table->expects++;
+    else
+        return;
+
+    flow->app = app;
+    flow->last = pkt->ts;
+    table->generation++;
+}
+
+/**
+ * @brief Release the state of the flows left and free the table
+ */
+void flow_close(flow_table_t *table) {
+
+    size_t i;
+
+    for (i = 0; i <= table->mask; i++)
+        if (table->tags[i] >= 0 && table->flows[i].data != NULL &&
+            table->release != NULL)
+            table->release(&table->flows[i], table->args);
+
+    free(table->tags);
+    free(table->flows);
+    table->tags = NULL;
+    table->flows = NULL;
+}
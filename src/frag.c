@@ -0,0 +1,358 @@
+#include "../include/frag.h"
+
+_Static_assert(sizeof(frag_key_t) == 40, "key hashed by words");
+
+/**
+ * @brief Prepare an empty reassembly, nothing is allocated until the
+ * first fragment
+ */
+void frag_open(frags_t *frags, size_t max) {
+
+    memset(frags, 0, sizeof(frags_t));
+    pool_open(&frags->datagrams, sizeof(datagram_t),
+              max / sizeof(datagram_t));
+}
+
+/**
+ * @brief Build the key of the datagram of a fragment
+ */
+void frag_key(frag_key_t *key, const packet_t *pkt, uint32_t id) {
+
+    memset(key, 0, sizeof(frag_key_t));
+
+    if (pkt->ip_version == 4) {
+        // ::ffff:a.b.c.d
+        key->addr[0].s6_addr[10] = 0xff;
+        key->addr[0].s6_addr[11] = 0xff;
+        key->addr[1] = key->addr[0];
+        memcpy(&key->addr[0].s6_addr[12], &pkt->ip_src.v4, 4);
+        memcpy(&key->addr[1].s6_addr[12], &pkt->ip_dst.v4, 4);
+    } else {
+        key->addr[0] = pkt->ip_src.v6;
+        key->addr[1] = pkt->ip_dst.v6;
+    }
+
+    key->id = id;
+    key->proto = pkt->ip_proto;
+    key->version = pkt->ip_version;
+}
+
+/**
+ * @brief Hash the key word by word
+ */
+uint64_t frag_hash(const frag_key_t *key) {
+
+    uint64_t words[sizeof(frag_key_t) / sizeof(uint64_t)];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    memcpy(words, key, sizeof(words));
+    for (i = 0; i < sizeof(words) / sizeof(*words); i++) {
+        hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Remove a datagram from its bucket and from the wheel, and
+ * give it back to the pool
+ */
+void frag_free(frags_t *frags, datagram_t *datagram) {
+
+    if ((*datagram->prev = datagram->next) != NULL)
+        datagram->next->prev = datagram->prev;
+    if ((*datagram->tick_prev = datagram->tick_next) != NULL)
+        datagram->tick_next->tick_prev = datagram->tick_prev;
+
+    pool_put(&frags->datagrams, datagram);
+}
+
+/**
+ * @brief Turn the wheel up to now, the datagrams of the slots passed
+ * are lost if they expired. A slot also holds datagrams expiring one
+ * turn later, they stay. Frames of a file can go back in time a
+ * little, the wheel never turns back.
+ */
+void frag_expire(frags_t *frags, uint32_t now) {
+
+    datagram_t *datagram, *next;
+
+    if (frags->clock == 0)
+        frags->clock = now;
+    else if ((int32_t)(now - frags->clock) > FRAG_WHEEL)
+        frags->clock = now - FRAG_WHEEL;
+
+    while ((int32_t)(now - frags->clock) > 0) {
+
+        frags->clock++;
+        datagram = frags->wheel[frags->clock % FRAG_WHEEL];
+
+        while (datagram != NULL) {
+            next = datagram->tick_next;
+            if ((int32_t)(datagram->expire - now) <= 0) {
+                frag_free(frags, datagram);
+                frags->lost++;
+            }
+            datagram = next;
+        }
+    }
+}
+
+/**
+ * @brief Give up the datagram expiring first to make room
+ */
+void frag_evict(frags_t *frags) {
+
+    uint32_t i;
+
+    for (i = 1; i <= FRAG_WHEEL; i++) {
+        datagram_t *datagram =
+            frags->wheel[(frags->clock + i) % FRAG_WHEEL];
+        if (datagram != NULL) {
+            frag_free(frags, datagram);
+            frags->lost++;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Find the datagram of the key, or start a new one whose whole
+ * payload is a hole
+ * @return the datagram, NULL if no room is left
+ */
+datagram_t *frag_find(frags_t *frags, const frag_key_t *key,
+                      uint32_t now) {
+
+    datagram_t **bucket, **tick, *datagram;
+    frag_hole_t hole = {FRAG_NONE, FRAG_NONE};
+
+    bucket = &frags->buckets[frag_hash(key) % FRAG_BUCKETS];
+    for (datagram = *bucket; datagram != NULL;
+         datagram = datagram->next)
+        if (memcmp(&datagram->key, key, sizeof(frag_key_t)) == 0)
+            return datagram;
+
+    if ((datagram = pool_get(&frags->datagrams)) == NULL) {
+        frag_evict(frags);
+        if ((datagram = pool_get(&frags->datagrams)) == NULL)
+            return NULL;
+    }
+
+    datagram->key = *key;
+    datagram->expire = now + FRAG_TIMEOUT;
+    datagram->holes = 0;
+    datagram->hdr_len = 0;
+    datagram->total = 0;
+    memcpy(datagram->buffer + FRAG_HEADER, &hole, sizeof(hole));
+
+    if ((datagram->next = *bucket) != NULL)
+        datagram->next->prev = &datagram->next;
+    datagram->prev = bucket;
+    *bucket = datagram;
+
+    tick = &frags->wheel[datagram->expire % FRAG_WHEEL];
+    if ((datagram->tick_next = *tick) != NULL)
+        datagram->tick_next->tick_prev = &datagram->tick_next;
+    datagram->tick_prev = tick;
+    *tick = datagram;
+
+    return datagram;
+}
+
+/**
+ * @brief Make the hole follow the previous one, or be the first one
+ * if there is no previous one
+ */
+void frag_link(datagram_t *datagram, uint16_t prev, uint16_t hole) {
+
+    if (prev == FRAG_NONE)
+        datagram->holes = hole;
+    else
+        memcpy(datagram->buffer + FRAG_HEADER + prev +
+                   offsetof(frag_hole_t, next),
+               &hole, sizeof(hole));
+}
+
+/**
+ * @brief Put a fragment in its datagram. Each hole it covers is
+ * removed, and the parts of the hole before and after the fragment
+ * become holes. Bytes received twice are overwritten.
+ * @return the datagram once complete, NULL otherwise
+ */
+datagram_t *frag_add(frags_t *frags, const packet_t *pkt, uint32_t id,
+                     const u_char *header, uint16_t hdr_len,
+                     uint16_t offset, int more, const u_char *payload,
+                     uint16_t len) {
+
+    u_char *data;
+    datagram_t *datagram;
+    frag_key_t key;
+    frag_hole_t hole;
+    uint16_t first = offset, last = offset + len - 1, prev, cur, end;
+
+    if (frags->done != NULL) {
+        pool_put(&frags->datagrams, frags->done);
+        frags->done = NULL;
+    }
+    frag_expire(frags, pkt->ts);
+
+    // only the last fragment may end between two blocks of 8 bytes,
+    // and no datagram is longer than the largest IP packet
+    if (len == 0 || (more && len % 8 != 0) ||
+        hdr_len > FRAG_HEADER || offset + len > IP_MAXPACKET - hdr_len)
+        return NULL;
+
+    frag_key(&key, pkt, id);
+    if ((datagram = frag_find(frags, &key, pkt->ts)) == NULL) {
+        frags->lost++;
+        return NULL;
+    }
+    data = datagram->buffer + FRAG_HEADER;
+
+    prev = FRAG_NONE;
+    cur = datagram->holes;
+    while (cur != FRAG_NONE) {
+
+        memcpy(&hole, data + cur, sizeof(hole));
+
+        if (first > hole.last || last < cur) {
+            prev = cur;
+            cur = hole.next;
+            continue;
+        }
+
+        frag_link(datagram, prev, hole.next);
+        end = hole.last;
+
+        if (first > cur) {
+            hole.last = first - 1;
+            memcpy(data + cur, &hole, sizeof(hole));
+            frag_link(datagram, prev, cur);
+            prev = cur;
+        }
+
+        if (last < end && more) {
+            hole.last = end;
+            memcpy(data + last + 1, &hole, sizeof(hole));
+            frag_link(datagram, prev, last + 1);
+            prev = last + 1;
+        }
+
+        cur = hole.next;
+    }
+
+    memcpy(data + offset, payload, len);
+    if (offset == 0) {
+        memcpy(data - hdr_len, header, hdr_len);
+        datagram->hdr_len = hdr_len;
+    }
+    if (!more)
+        datagram->total = last + 1;
+
+    if (datagram->holes != FRAG_NONE)
+        return NULL;
+
+    // out of the table, but kept until the analyzers are done
+    if ((*datagram->prev = datagram->next) != NULL)
+        datagram->next->prev = datagram->prev;
+    if ((*datagram->tick_prev = datagram->tick_next) != NULL)
+        datagram->tick_next->tick_prev = datagram->tick_prev;
+    frags->done = datagram;
+    frags->reassembled++;
+
+    return datagram;
+}
+
+/**
+ * @brief Bytes of payload carried by a fragment. The IPv6 header
+ * length counts the extension headers, the fragment header included.
+ */
+int frag_len(const packet_t *pkt) {
+
+    if (pkt->ip_version == 4)
+        return pkt->ip_len - pkt->ip_hdr_len;
+
+    return pkt->ip_len + (int)sizeof(struct ip6_hdr) - pkt->ip_hdr_len;
+}
+
+/**
+ * @brief Keep an IPv4 or IPv6 fragment until its datagram is
+ * complete. The dissection then describes the whole datagram, as if
+ * it was received in one piece, without the IPv6 fragment header.
+ * Without reassembly, the first fragment is analyzed alone.
+ * @return the payload of the datagram, its length in length, NULL if
+ * fragments are missing
+ */
+const u_char *frag_ip(packet_t *pkt, const u_char *packet,
+                      int *length) {
+
+    uint16_t offset = (pkt->ip_frag_off & IP_OFFMASK) * 8;
+    uint16_t hdr_len = pkt->ip_hdr_len;
+    int more = (pkt->ip_frag_off & IP_MF) != 0;
+    int len = frag_len(pkt);
+    datagram_t *datagram, *done;
+
+    // a tunnel fragmented inside a datagram just reassembled is not
+    // reassembled again, that datagram would be freed under it
+    done = pkt->ctx->frags != NULL ? pkt->ctx->frags->done : NULL;
+    if (pkt->ctx->frags == NULL ||
+        (done != NULL && pkt->data >= done->buffer &&
+         pkt->data < done->buffer + sizeof(done->buffer)))
+        return offset == 0 ? packet : NULL;
+
+    // a fragment truncated by the capture is missing
+    if (len < 0 || len > *length ||
+        packet + len > pkt->data + pkt->caplen)
+        return NULL;
+
+    if (pkt->ip_version == 6)
+        hdr_len -= sizeof(struct ip6_frag);
+
+    datagram = frag_add(pkt->ctx->frags, pkt, pkt->ip_id,
+                        pkt->data + pkt->l3_offset, hdr_len, offset,
+                        more, packet, len);
+    if (datagram == NULL)
+        return NULL;
+
+    pkt->data = datagram->buffer + FRAG_HEADER - datagram->hdr_len;
+    pkt->caplen = datagram->hdr_len + datagram->total;
+    pkt->ip_hdr_len = datagram->hdr_len;
+    pkt->ip_len = pkt->caplen;
+    if (pkt->ip_version == 6)
+        pkt->ip_len -= sizeof(struct ip6_hdr);
+    pkt->ip_frag_off = 0;
+    pkt->l3_offset = 0;
+    pkt->l4_offset = datagram->hdr_len;
+
+    *length = datagram->total;
+    return datagram->buffer + FRAG_HEADER;
+}
+
+/**
+ * @brief Print a fragment whose datagram is not complete
+ */
+void frag_print(const packet_t *pkt, int verbose) {
+
+    int offset = (pkt->ip_frag_off & IP_OFFMASK) * 8;
+
+    PRV1(output_str("-\t\t\tFragment"), verbose);
+    PRV2(output_printf(YEL "Fragment" NC "\t%d bytes at offset %d\n",
+                       frag_len(pkt), offset),
+         verbose);
+    PRV3(output_printf("\nFragment of %d bytes at offset %d, the "
+                       "datagram is not complete\n",
+                       frag_len(pkt), offset),
+         verbose);
+}
+
+/**
+ * @brief Free every datagram left
+ */
+void frag_close(frags_t *frags) {
+
+    pool_close(&frags->datagrams);
+    frags->done = NULL;
+}
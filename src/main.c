@@ -1,113 +1,143 @@
 #include "../include/1_ethernet.h"
-#include "../include/2_arp.h"
-#include "../include/2_ip.h"
-#include "../include/2_ipv6.h"
+#include "../include/classify.h"
+#include "../include/context.h"
+#include "../include/dump.h"
+#include "../include/filter.h"
 #include "../include/include.h"
 #include "../include/option.h"
-
-// frame number
-volatile sig_atomic_t count = 0;
+#include "../include/packet.h"
+#include "../include/reader.h"
+#include "../include/ring.h"
+#include "../include/worker.h"
 
 /**
  * @brief Take the packet read by pcap_loop and print each header with
  * calling Physical, Network and Transport layer analyzers. Transport
  * layers call Application layer analyzers.
- * @param args - contain the verbose verbose
+ * @param args - contain the analyzer context
  * @param header - contain the timestamp and the length of the packet
  * @param packet
  */
 void got_packet(u_char *args, const struct pcap_pkthdr *header,
                 const u_char *packet) {
 
-    int verbose = (int)args[0] - 48;
+    context_t *ctx = (context_t *)args;
+    int verbose = ctx->verbose;
     int length = header->len;
 
+    // Text of the frame, in the sink of the context
+    output_select(ctx->output);
+
     // One line by frame
-    count++;
-    PRV1(printf("%d\t", count), verbose);
-    PRV1(printf("%d\t\t", length), verbose);
+    ctx->count++;
+    ctx->bytes += length;
+    if (verbose == 1) {
+        output_uint(ctx->count);
+        output_char('\t');
+        output_uint(length);
+        output_str("\t\t");
+    }
+
+    // Dissection of the frame, filled by each layer
+    packet_t pkt;
+    init_packet(&pkt, header, packet);
+    pkt.ctx = ctx;
+    const u_char *frame = packet;
+
+    // the intervals of the DNS counters follow the capture time
+    if (ctx->resolvers != NULL)
+        resolver_clock(ctx->resolvers, pkt.ts);
 
     // Ethernet Header
-    struct ether_header *eth_header =
-        ethernet_analyzer(packet, verbose);
+    ethernet_analyzer(&pkt, packet, verbose);
     packet += sizeof(struct ether_header);
     length -= sizeof(struct ether_header);
 
-    // Network Layer
-    struct iphdr *ip_header;
-    struct ip6_hdr *ipv6_header;
-
     // Get the network protocol
-    switch (htons(eth_header->ether_type)) {
-
-    // IPv4 protocol
-    case ETHERTYPE_IP:
-        ip_header = ip_analyzer(packet, verbose);
-        packet += ip_header->ihl * 4;
-        length -= ip_header->ihl * 4;
-        // Get the transport layer protocol and the application layer
-        get_protocol_ip(packet, ip_header, length, verbose);
-        break;
-
-    // IPv6 protocol
-    case ETHERTYPE_IPV6:
-        ipv6_header = ipv6_analyzer(packet, verbose);
-        packet += sizeof(struct ip6_hdr);
-        length -= sizeof(struct ip6_hdr);
-        // Get the transport layer protocol and the application layer
-        get_protocol_ipv6(packet, ipv6_header, length, verbose);
-        break;
-
-    // ARP protocol
-    case ETHERTYPE_ARP:
-        arp_analyzer(packet, verbose);
-        packet += sizeof(struct ether_arp);
-        PRV1(printf("-\t\t\tARP"), verbose);
-        break;
-
-    // other cases
-    case ETHERTYPE_REVARP:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tRARP"), verbose);
-        break;
-    case ETHERTYPE_PUP:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tPUP"), verbose);
-        break;
-    case ETHERTYPE_SPRITE:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tSPRITE"), verbose);
-        break;
-    case ETHERTYPE_AT:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tAT"), verbose);
-        break;
-    case ETHERTYPE_AARP:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tAARP"), verbose);
-        break;
-    case ETHERTYPE_VLAN:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tVLAN"), verbose);
-        break;
-    case ETHERTYPE_IPX:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tIPX"), verbose);
-        break;
-    case ETHERTYPE_LOOPBACK:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\tLOOPBACK"), verbose);
-        break;
-
-    default:
-        PRV1(add_mac_print_lvl1(eth_header), verbose);
-        PRV1(printf("-\t\t\t" RED "Unknown" NC), verbose);
-        break;
-    }
+    get_protocol_ethernet(&pkt, packet, length, verbose);
+
+    PRV1(output_str("\n"), verbose);
+    PRV2(output_str(SIMPLE_BANNER "\n"), verbose);
+    PRV3(output_str(COLOR_BANNER "\n"), verbose);
+
+    // Frames kept by the filter are saved as they were captured, the
+    // dissection may point at a datagram reassembled since
+    if (ctx->dump != NULL)
+        dump_packet(ctx->dump, header, frame);
+
+    // The text of the frame is written in one piece
+    output_frame();
+}
+
+/**
+ * @brief Print the header of the output, before the first frame
+ */
+void print_banner(int verbose) {
+
+    // One line by frame
+    PRV1(output_str(GRN "No.\tLength (bits)\t"
+                        "Source\t\t\t\t\t\t"
+                        "Destination\t\t\t\t\tPort"
+                        "\t\t\tProtocol" NC "\n"),
+         verbose);
+    // One line by protocol
+    PRV2(output_str(SIMPLE_BANNER "\n"), verbose);
+    // Multiple lines by frame
+    PRV3(output_str(COLOR_BANNER "\n"), verbose);
+
+    // written before the threads print their frames
+    output_flush();
+}
+
+/**
+ * @brief Start the writer thread, with a ring for the main thread and
+ * one by capture thread
+ */
+void start_writer(writer_t *writer, int nb_threads, int policy) {
+
+    CHK(writer_open(writer, nb_threads + 1, policy));
+    PCHK(writer_start(writer));
+    output_attach(&writer->rings[0]);
+}
+
+/**
+ * @brief Take the packet read at verbose level 0, classify it and count
+ * it. No verbose level is checked and nothing is formatted.
+ * @param args - contain the analyzer context
+ * @param header - contain the timestamp and the length of the packet
+ * @param packet
+ */
+void count_packet(u_char *args, const struct pcap_pkthdr *header,
+                  const u_char *packet) {
+
+    context_t *ctx = (context_t *)args;
+    packet_t pkt;
+
+    ctx->count++;
+    ctx->bytes += header->len;
+
+    init_packet(&pkt, header, packet);
+    pkt.ctx = ctx;
+    if (ctx->resolvers != NULL)
+        resolver_clock(ctx->resolvers, pkt.ts);
+    classify_packet(&pkt, packet, header->len);
+    count_protocols(ctx, &pkt);
+
+    if (ctx->dump != NULL)
+        dump_packet(ctx->dump, header, packet);
+}
+
+// libpcap handle of the live capture, stopped by stop_capture
+pcap_t *live_handle = NULL;
+
+/**
+ * @brief Stop the capture threads on SIGINT / SIGTERM
+ */
+void stop_capture(int sig) {
 
-    PRV1(printf("\n"), verbose);
-    PRV2(printf(SIMPLE_BANNER "\n"), verbose);
-    PRV3(printf(COLOR_BANNER "\n"), verbose);
+    ring_breakloop();
+    if (live_handle != NULL)
+        pcap_breakloop(live_handle);
 }
 
 /**
@@ -133,11 +163,160 @@ int main(int argc, char **argv) {
         exit(EXIT_FAILURE);
     }
 
-    pcap_t *handle;
+    // Check ring geometry
+    if (usage->ring &&
+        (usage->block_nr == 0 || usage->block_size == 0 ||
+         usage->block_size % getpagesize() != 0 ||
+         usage->block_size % RING_FRAME_SIZE != 0)) {
+        fprintf(stderr, RED "Error : Ring block size must be a "
+                            "multiple of the page size and the block "
+                            "number positive" NC "\n");
+        print_option();
+        exit(EXIT_FAILURE);
+    }
+
+    // Check number of threads
+    if (usage->jobs < 1) {
+        fprintf(stderr, RED "Error : Number of threads must be "
+                            "positive" NC "\n");
+        print_option();
+        exit(EXIT_FAILURE);
+    }
+
+    // Check interval of the DNS summaries
+    if (usage->dns_interval < -1) {
+        fprintf(stderr, RED "Error : Interval of the DNS summaries "
+                            "must not be negative" NC "\n");
+        print_option();
+        exit(EXIT_FAILURE);
+    }
+
+    // Check names and clients of the DNS summaries, printed once at
+    // the end without interval
+    if (usage->dns_top < 0 || usage->dns_top > TOPK_MAX) {
+        fprintf(stderr, RED "Error : Names of the DNS summaries must "
+                            "be between 0 and %d" NC "\n",
+                TOPK_MAX);
+        print_option();
+        exit(EXIT_FAILURE);
+    }
+    if (usage->dns_top > 0 && usage->dns_interval == -1)
+        usage->dns_interval = 0;
+
+    // Check depth of the tunnels
+    if (usage->tunnel_max < 0 || usage->tunnel_max > TUNNEL_MAX) {
+        fprintf(stderr, RED "Error : Depth of the tunnels must be "
+                            "between 0 and %d" NC "\n",
+                TUNNEL_MAX);
+        print_option();
+        exit(EXIT_FAILURE);
+    }
+
+    pcap_t *handle = NULL;
     char errbuf[PCAP_ERRBUF_SIZE];
 
+    // analyzer context of the main thread
+    context_t ctx;
+    init_context(&ctx, verbose);
+    ctx.registry = &usage->registry;
+    ctx.tunnel_max = usage->tunnel_max;
+
+    // frames written one by one or by batches, the capture threads
+    // have their own sink
+    output_t sink;
+    output_open(&sink, usage->output_batch);
+    ctx.output = &sink;
+    output_select(&sink);
+
+    // without display the frames are only classified and counted
+    pcap_handler callback = verbose == 0 ? count_packet : got_packet;
+
+    // frames written by another thread, started after the banner
+    writer_t writer;
+    int async = 0;
+
+    // frames given to the analyzers saved with -w
+    dump_t dump;
+
+    // flows of the main thread, the capture threads have their own
+    flow_table_t flows;
+    streams_t streams;
+    if (usage->flows != 0 &&
+        (usage->interface == NULL || !usage->ring)) {
+        CHK(flow_open(&flows, usage->flows, FLOW_TIMEOUT));
+        ctx.flows = &flows;
+        if (usage->stream_max != 0) {
+            CHK(stream_open(&streams, &flows, usage->stream_flow_max,
+                            usage->stream_max));
+            ctx.streams = &streams;
+        }
+    }
+
+    // fragments of the main thread, the ring gives whole datagrams
+    frags_t frags;
+    if (usage->frag_max != 0 &&
+        (usage->interface == NULL || !usage->ring)) {
+        frag_open(&frags, usage->frag_max);
+        ctx.frags = &frags;
+    }
+
+    // DNS transactions of the main thread, the capture threads have
+    // their own and merge their top names and clients in it
+    resolvers_t resolvers;
+    if (usage->dns_interval >= 0) {
+        CHK(resolver_open(&resolvers, usage->dns_interval,
+                          RESOLVER_QUERIES, usage->dns_top));
+        ctx.resolvers = &resolvers;
+    }
+
+    // a live capture is stopped cleanly, so the counters are printed
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_capture;
+
+    // Port listening with the memory-mapped ring, one by thread
+    if (usage->interface != NULL && usage->ring) {
+
+        worker_t *workers;
+        SCHK(workers = malloc(usage->jobs * sizeof(worker_t)));
+        CHK(open_workers(workers, usage->jobs, usage, verbose,
+                         callback));
+
+        // every worker writes its batches in the same file
+        if (usage->dump != NULL) {
+            CHK(dump_open(&dump, usage->dump, READER_MAX_SNAPLEN));
+            int i;
+            for (i = 0; i < usage->jobs; i++) {
+                dump_share(&workers[i].dump, dump.fd);
+                workers[i].ctx.dump = &workers[i].dump;
+            }
+        }
+
+        CHK(sigaction(SIGINT, &sa, NULL));
+        CHK(sigaction(SIGTERM, &sa, NULL));
+
+        print_banner(verbose);
+
+        if (usage->async != WRITER_SYNC) {
+            start_writer(&writer, usage->jobs, usage->async);
+            async = 1;
+            int i;
+            for (i = 0; i < usage->jobs; i++)
+                workers[i].output = &writer.rings[i + 1];
+        }
+
+        // Capture packets until interrupted
+        PCHK(start_workers(workers, usage->jobs));
+        join_workers(workers, usage->jobs, &ctx);
+        if (usage->dump != NULL)
+            CHK(dump_close(&dump));
+
+        fflush(stdout);
+        print_context(&ctx, "Total");
+        free(workers);
+    }
     // Port listening
-    if (usage->interface != NULL) {
+    else if (usage->interface != NULL) {
 
         // online mode
         SCHK(handle = pcap_open_live(usage->interface, BUFSIZ,
@@ -152,18 +331,28 @@ int main(int argc, char **argv) {
             CHK(pcap_setfilter(handle, &fp));
         }
 
-        // One line by frame
-        PRV1(printf(GRN "No.\tLength (bits)\t"
-                        "Source\t\t\t\t\t\tDestination\t\t\t\t\tPort"
-                        "\t\t\tProtocol" NC "\n"),
-             verbose);
-        // One line by protocol
-        PRV2(printf(SIMPLE_BANNER "\n"), verbose);
-        // Multiple lines by frame
-        PRV3(printf(COLOR_BANNER "\n"), verbose);
+        // frames do not stay in the buffer of libpcap, they are copied
+        if (usage->dump != NULL) {
+            CHK(dump_open_pcap(&dump, handle, usage->dump));
+            ctx.dump = &dump;
+        }
+
+        print_banner(verbose);
+
+        if (usage->async != WRITER_SYNC) {
+            start_writer(&writer, 0, usage->async);
+            async = 1;
+        }
+
+        // Capture packets until interrupted
+        live_handle = handle;
+        CHK(sigaction(SIGINT, &sa, NULL));
+        CHK(sigaction(SIGTERM, &sa, NULL));
+        pcap_loop(handle, -1, callback, (u_char *)&ctx);
+        live_handle = NULL;
 
-        // Capture packets
-        pcap_loop(handle, -1, got_packet, (u_char *)usage->verbose);
+        if (ctx.dump != NULL)
+            CHK(dump_close(ctx.dump));
 
         // Free pcap handle
         pcap_close(handle);
@@ -171,24 +360,84 @@ int main(int argc, char **argv) {
     // File analyzing
     else if (usage->file != NULL) {
 
-        // offline mode
-        SCHK(handle = pcap_open_offline(usage->file, errbuf));
+        // offline mode, read in place from the mapped file
+        reader_t reader;
+        int ret;
+        CHK(ret = reader_open(&reader, usage->file));
 
-        // One line by frame
-        PRV1(printf(GRN "No.\tLength (bits)\t"
-                        "Source\t\t\t\t\t\tDestination\t\t\t\t\tPort"
-                        "\t\t\tProtocol" NC "\n"),
-             verbose);
-        // One line by protocol
-        PRV2(printf(SIMPLE_BANNER "\n"), verbose);
-        // Multiple lines by frame
-        PRV3(printf(COLOR_BANNER "\n"), verbose);
+        // or with libpcap for the formats we do not know
+        if (ret == 1)
+            SCHK(handle = pcap_open_offline(usage->file, errbuf));
+
+        uint32_t snaplen = READER_MAX_SNAPLEN;
+        if (ret == 0 && reader.snaplen != 0)
+            snaplen = reader.snaplen;
+
+        // Filter, run before the analyzers by libpcap or the reader
+        filter_t filter;
+        if (usage->filter != NULL && ret == 1) {
+
+            struct bpf_program fp;
+            CHK(pcap_compile(handle, &fp, usage->filter, 1,
+                             PCAP_NETMASK_UNKNOWN));
+            CHK(pcap_setfilter(handle, &fp));
+            pcap_freecode(&fp);
+        } else if (usage->filter != NULL) {
+            int compiled = filter_compile(&filter, usage->filter,
+                                          snaplen, errbuf);
+            if (compiled == -1)
+                fprintf(stderr, RED "Error : %s" NC "\n", errbuf);
+            CHK(compiled);
+            reader.filter = &filter;
+        }
+
+        // frames of the mapping are written from it, until unmapped
+        if (usage->dump != NULL) {
+            if (ret == 1)
+                CHK(dump_open_pcap(&dump, handle, usage->dump));
+            else
+                CHK(dump_open(&dump, usage->dump, snaplen));
+            ctx.dump = &dump;
+        }
+
+        print_banner(verbose);
+
+        // the processes of the chunks write their own output
+        int chunks = ret == 0 && usage->jobs > 1 &&
+                     reader.format == READER_PCAP;
+
+        if (usage->async != WRITER_SYNC && !chunks) {
+            start_writer(&writer, 0, usage->async);
+            async = 1;
+        }
 
         // Analyze packets
-        pcap_loop(handle, -1, got_packet, (u_char *)usage->verbose);
+        if (ret == 1) {
+            pcap_loop(handle, -1, callback, (u_char *)&ctx);
+            if (ctx.dump != NULL)
+                CHK(dump_close(ctx.dump));
+
+            // Free pcap handle
+            pcap_close(handle);
+        } else if (chunks) {
+            // one chunk of the file by worker
+            CHK(analyze_chunks(&reader, usage->jobs, &ctx, callback));
+            if (ctx.dump != NULL)
+                CHK(dump_close(ctx.dump));
+
+            // Unmap the file
+            reader_close(&reader);
+        } else {
+            batch_loop(&reader, ctx.flows, callback, (u_char *)&ctx);
+            if (ctx.dump != NULL)
+                CHK(dump_close(ctx.dump));
+
+            // Unmap the file
+            reader_close(&reader);
+        }
 
-        // Free pcap handle
-        pcap_close(handle);
+        if (ret == 0 && usage->filter != NULL)
+            filter_free(&filter);
 
     } else {
 
@@ -197,6 +446,23 @@ int main(int argc, char **argv) {
         exit(EXIT_FAILURE);
     }
 
+    // Frames still buffered
+    output_flush();
+    if (async) {
+        unsigned long dropped = writer_close(&writer);
+        output_attach(NULL);
+        fprintf(stderr, "Output : %lu frames dropped\n", dropped);
+    }
+    output_free();
+    fflush(stdout);
+    close_flows(&ctx);
+    close_frags(&ctx);
+    close_resolvers(&ctx);
+
+    // Frames by protocol
+    if (verbose == 0)
+        print_summary(&ctx);
+
     // free usage structure
     free(usage);
 
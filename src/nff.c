@@ -0,0 +1,276 @@
+#include "../include/nff.h"
+
+/**
+ * @brief Empty analyzer with the default ports and tunnel depth, and
+ * no callback
+ */
+void nff_init(nff_t *nff) {
+
+    memset(nff, 0, sizeof(nff_t));
+    registry_init(&nff->registry);
+    init_context(&nff->ctx, 0);
+    nff->ctx.registry = &nff->registry;
+    nff->ctx.tunnel_max = TUNNEL_DEPTH;
+}
+
+/**
+ * @brief Keep the frames of a libpcap handle matching the filter
+ * @return 0 on success, -1 on error
+ */
+int nff_filter_pcap(nff_t *nff, const char *filter, int optimize) {
+
+    struct bpf_program fp;
+    int ret;
+
+    if (filter == NULL)
+        return 0;
+
+    ret = pcap_compile(nff->handle, &fp, filter, optimize,
+                       PCAP_NETMASK_UNKNOWN);
+    if (ret == 0) {
+        ret = pcap_setfilter(nff->handle, &fp);
+        pcap_freecode(&fp);
+    }
+
+    if (ret == -1)
+        snprintf(nff->error, PCAP_ERRBUF_SIZE, "%s",
+                 pcap_geterr(nff->handle));
+
+    return ret;
+}
+
+/**
+ * @brief Open a capture file, read in place or by libpcap for the
+ * formats the reader does not know, and the tables of the decoders.
+ * Only the frames matching the filter are decoded, NULL for all.
+ * @return 0 on success, -1 on error, nothing is left open
+ */
+int nff_open_file(nff_t *nff, const char *file, const char *filter) {
+
+    uint32_t snaplen = READER_MAX_SNAPLEN;
+    int ret;
+
+    nff_init(nff);
+
+    if ((ret = reader_open(&nff->reader, file)) == -1) {
+        snprintf(nff->error, PCAP_ERRBUF_SIZE, "%s : %s", file,
+                 strerror(errno));
+        return -1;
+    }
+
+    if (ret == 1) {
+        nff->source = NFF_PCAP;
+        nff->handle = pcap_open_offline(file, nff->error);
+        if (nff->handle == NULL)
+            return -1;
+        if (nff_filter_pcap(nff, filter, 1) == -1) {
+            pcap_close(nff->handle);
+            return -1;
+        }
+    } else if (filter != NULL) {
+        if (nff->reader.snaplen != 0)
+            snaplen = nff->reader.snaplen;
+        if (filter_compile(&nff->filter, filter, snaplen,
+                           nff->error) == -1) {
+            reader_close(&nff->reader);
+            return -1;
+        }
+        nff->reader.filter = &nff->filter;
+        nff->filtered = 1;
+    }
+
+    if (nff_tables(nff) == -1) {
+        nff_close(nff);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Capture on an interface with libpcap, then open the tables
+ * of the decoders. Only the frames matching the filter are decoded,
+ * NULL for all.
+ * @return 0 on success, -1 on error, nothing is left open
+ */
+int nff_open_live(nff_t *nff, const char *interface,
+                  const char *filter) {
+
+    nff_init(nff);
+    nff->source = NFF_PCAP;
+
+    nff->handle =
+        pcap_open_live(interface, BUFSIZ, PROMISC, TO_MS, nff->error);
+    if (nff->handle == NULL)
+        return -1;
+
+    if (nff_filter_pcap(nff, filter, 0) == -1 ||
+        nff_tables(nff) == -1) {
+        nff_close(nff);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Open the flow table, the TCP reassembly and the fragments
+ * with the default sizes of the command line
+ * @return 0 on success, -1 on error, the tables opened are closed by
+ * nff_close
+ */
+int nff_tables(nff_t *nff) {
+
+    if (flow_open(&nff->flows, FLOW_CAPACITY, FLOW_TIMEOUT) == -1) {
+        snprintf(nff->error, PCAP_ERRBUF_SIZE, "flows : %s",
+                 strerror(errno));
+        return -1;
+    }
+    nff->ctx.flows = &nff->flows;
+
+    if (stream_open(&nff->streams, &nff->flows, STREAM_FLOW_MAX,
+                    STREAM_MAX) == -1) {
+        snprintf(nff->error, PCAP_ERRBUF_SIZE, "streams : %s",
+                 strerror(errno));
+        return -1;
+    }
+    nff->ctx.streams = &nff->streams;
+
+    frag_open(&nff->frags, FRAG_MAX);
+    nff->ctx.frags = &nff->frags;
+
+    return 0;
+}
+
+/**
+ * @brief Give the frames reaching a layer to the callback, with user
+ * as its last argument. NULL removes the callback of the layer.
+ */
+void nff_on(nff_t *nff, int layer, nff_callback_t callback,
+            void *user) {
+
+    if (layer < 0 || layer >= NFF_MAX)
+        return;
+
+    nff->callbacks[layer] = callback;
+    nff->users[layer] = user;
+}
+
+void nff_call(const nff_t *nff, int layer, const packet_t *pkt) {
+
+    if (nff->callbacks[layer] != NULL)
+        nff->callbacks[layer](pkt, nff->users[layer]);
+}
+
+/**
+ * @brief Decode a frame as the verbose level 0 does, then give it to
+ * the callbacks of the layers it reached. A fragment reaches the
+ * transport once its datagram is complete.
+ */
+void nff_packet(u_char *args, const struct pcap_pkthdr *header,
+                const u_char *packet) {
+
+    nff_t *nff = (nff_t *)args;
+    packet_t pkt;
+
+    nff->ctx.count++;
+    nff->ctx.bytes += header->len;
+
+    init_packet(&pkt, header, packet);
+    pkt.ctx = &nff->ctx;
+    classify_packet(&pkt, packet, header->len);
+    count_protocols(&nff->ctx, &pkt);
+
+    nff_call(nff, NFF_FRAME, &pkt);
+
+    if (pkt.ip_version == 4)
+        nff_call(nff, NFF_IPV4, &pkt);
+    else if (pkt.ip_version == 6)
+        nff_call(nff, NFF_IPV6, &pkt);
+    else
+        return;
+
+    if ((pkt.ip_frag_off & (IP_MF | IP_OFFMASK)) != 0)
+        return;
+
+    switch (pkt.ip_proto) {
+    case IPPROTO_TCP:
+        nff_call(nff, NFF_TCP, &pkt);
+        break;
+    case IPPROTO_UDP:
+        nff_call(nff, NFF_UDP, &pkt);
+        break;
+    case IPPROTO_ICMP:
+    case IPPROTO_ICMPV6:
+        nff_call(nff, NFF_ICMP, &pkt);
+        break;
+    }
+
+    if (pkt.app != APP_NONE)
+        nff_call(nff, NFF_APP, &pkt);
+}
+
+/**
+ * @brief Decode the next frames, at most max of them, or all the
+ * ones of the file or of the buffer of libpcap when max is not
+ * positive. A live capture returns at the latest after its timeout.
+ * @return frames decoded, 0 at the end of the file, -1 on error
+ */
+int nff_next_batch(nff_t *nff, int max) {
+
+    batch_t batch;
+    int n, ret = 1;
+
+    if (nff->source == NFF_PCAP) {
+        n = pcap_dispatch(nff->handle, max, nff_packet, (u_char *)nff);
+        if (n == PCAP_ERROR) {
+            snprintf(nff->error, PCAP_ERRBUF_SIZE, "%s",
+                     pcap_geterr(nff->handle));
+            return -1;
+        }
+        return n == PCAP_ERROR_BREAK ? 0 : n;
+    }
+
+    // the frames stay in the mapping, they are decoded by batches
+    batch_open(&batch, nff->ctx.flows);
+    for (n = 0; max <= 0 || n < max; n++) {
+        ret = reader_next(&nff->reader, &batch.headers[batch.nb],
+                          &batch.packets[batch.nb]);
+        if (ret != 1)
+            break;
+        if (++batch.nb == BATCH_SIZE)
+            batch_run(&batch, nff_packet, (u_char *)nff);
+    }
+    batch_run(&batch, nff_packet, (u_char *)nff);
+
+    // the frames before a corrupted record are given first
+    if (ret == -1 && n == 0) {
+        snprintf(nff->error, PCAP_ERRBUF_SIZE,
+                 "capture file truncated or corrupted");
+        return -1;
+    }
+
+    return n;
+}
+
+/**
+ * @brief Free the tables and close the capture, the counters stay in
+ * the context
+ */
+void nff_close(nff_t *nff) {
+
+    close_flows(&nff->ctx);
+    close_frags(&nff->ctx);
+
+    if (nff->source == NFF_PCAP) {
+        if (nff->handle != NULL)
+            pcap_close(nff->handle);
+        nff->handle = NULL;
+        return;
+    }
+
+    if (nff->filtered)
+        filter_free(&nff->filter);
+    nff->filtered = 0;
+    reader_close(&nff->reader);
+}
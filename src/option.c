@@ -5,14 +5,32 @@ void init_usage(usage_t *usage) {
     usage->interface = NULL;
     usage->file = NULL;
     usage->filter = NULL;
+    usage->dump = NULL;
     usage->verbose = "1";
+    usage->ring = 0;
+    usage->block_size = RING_BLOCK_SIZE;
+    usage->block_nr = RING_BLOCK_NR;
+    usage->block_timeout = RING_TIMEOUT;
+    usage->jobs = 1;
+    usage->output_batch = 0;
+    usage->async = WRITER_SYNC;
+    usage->flows = FLOW_CAPACITY;
+    usage->stream_flow_max = STREAM_FLOW_MAX;
+    usage->stream_max = STREAM_MAX;
+    usage->frag_max = FRAG_MAX;
+    registry_init(&usage->registry);
+    usage->tunnel_max = TUNNEL_DEPTH;
+    usage->dns_interval = -1;
+    usage->dns_top = 0;
 }
 
 int option(int argc, char **argv, usage_t *usage) {
 
     char c;
 
-    while ((c = getopt(argc, argv, "hi:o:v:f:")) != -1) {
+    while ((c = getopt(argc, argv,
+                       "hi:o:v:f:w:rB:N:T:j:b:a:F:m:M:R:p:e:s:k:")) !=
+           -1) {
 
         switch (c) {
 
@@ -36,6 +54,86 @@ int option(int argc, char **argv, usage_t *usage) {
             usage->filter = optarg;
             break;
 
+        case 'w':
+            usage->dump = optarg;
+            break;
+
+        case 'r':
+            usage->ring = 1;
+            break;
+
+        case 'B':
+            usage->block_size = atoi(optarg);
+            break;
+
+        case 'N':
+            usage->block_nr = atoi(optarg);
+            break;
+
+        case 'T':
+            usage->block_timeout = atoi(optarg);
+            break;
+
+        case 'j':
+            usage->jobs = atoi(optarg);
+            // several sockets are only possible with the ring
+            usage->ring = 1;
+            break;
+
+        case 'b':
+            usage->output_batch = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'F':
+            usage->flows = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'm':
+            usage->stream_flow_max = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'M':
+            usage->stream_max = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'R':
+            usage->frag_max = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'e':
+            usage->tunnel_max = atoi(optarg);
+            break;
+
+        case 's':
+            usage->dns_interval = atoi(optarg);
+            break;
+
+        case 'k':
+            usage->dns_top = atoi(optarg);
+            break;
+
+        case 'p':
+            if (registry_parse(&usage->registry, optarg) == -1) {
+                fprintf(stderr, RED "Error : Option -p must be "
+                                    "port=protocol" NC "\n");
+                print_option();
+                exit(EXIT_FAILURE);
+            }
+            break;
+
+        case 'a':
+            if (strcmp(optarg, "block") == 0)
+                usage->async = WRITER_BLOCK;
+            else if (strcmp(optarg, "drop") == 0)
+                usage->async = WRITER_DROP;
+            else {
+                fprintf(stderr, RED "Error : Policy of -a must be "
+                                    "block or drop" NC "\n");
+                print_option();
+                exit(EXIT_FAILURE);
+            }
+            break;
+
         case '?':
             if (optopt == 'i') {
                 fprintf(stderr,
@@ -69,6 +167,21 @@ int option(int argc, char **argv, usage_t *usage) {
                         optopt);
                 print_option();
                 exit(EXIT_FAILURE);
+            } else if (optopt == 'B' || optopt == 'N' ||
+                       optopt == 'T' || optopt == 'j' ||
+                       optopt == 'b' || optopt == 'a' ||
+                       optopt == 'w' || optopt == 'F' ||
+                       optopt == 'm' || optopt == 'M' ||
+                       optopt == 'R' || optopt == 'p' ||
+                       optopt == 'e' || optopt == 's' ||
+                       optopt == 'k') {
+                fprintf(stderr,
+                        RED "Error"
+                            " : Option -%c requires an argument" NC
+                            "\n",
+                        optopt);
+                print_option();
+                exit(EXIT_FAILURE);
             } else if (isprint(optopt)) {
                 fprintf(stderr,
                         RED "Error"
@@ -98,15 +211,6 @@ int option(int argc, char **argv, usage_t *usage) {
                         "offline listening" NC "\n");
             print_option();
             exit(EXIT_FAILURE);
-        } else if ((usage->filter != NULL &&
-                    usage->interface == NULL) ||
-                   (usage->filter != NULL && usage->file != NULL)) {
-            fprintf(stderr, RED
-                    "Error"
-                    " : Filter must be used on online listening" NC
-                    "\n");
-            print_option();
-            exit(EXIT_FAILURE);
         }
     }
 
@@ -119,5 +223,34 @@ void print_option(void) {
                     "\t-i <file>         interface\n"
                     "\t-o <file>         output\n"
                     "\t-f <nb>           filter\n"
-                    "\t-v <nb>           verbose of verbocity\n");
+                    "\t-v <nb>           verbose of verbocity\n"
+                    "\t-w <file>         save the frames analyzed in "
+                    "a pcap file\n"
+                    "\t-r                capture with a TPACKET_V3 "
+                    "ring (online)\n"
+                    "\t-B <bytes>        size of a ring block\n"
+                    "\t-N <nb>           number of ring blocks\n"
+                    "\t-T <ms>           ring block timeout\n"
+                    "\t-j <nb>           number of capture threads\n"
+                    "\t-b <bytes>        output written by batches of "
+                    "this size\n"
+                    "\t-a <policy>       output written by a thread, "
+                    "block or drop when late\n"
+                    "\t-F <nb>           flows tracked by thread, 0 "
+                    "to track none\n"
+                    "\t-m <bytes>        bytes held by a TCP flow "
+                    "waiting for missing segments, in 2 KiB "
+                    "buffers\n"
+                    "\t-M <bytes>        bytes held by a thread for "
+                    "all its TCP flows, 0 to not reassemble\n"
+                    "\t-R <bytes>        bytes of IP fragments held by "
+                    "thread, 0 to not reassemble\n"
+                    "\t-p <port=proto>   analyze a port with a "
+                    "protocol, none to not analyze it\n"
+                    "\t-e <nb>           tunnels peeled at most in "
+                    "front of the network protocol\n"
+                    "\t-s <seconds>      DNS response times by server "
+                    "every this interval, 0 once at the end\n"
+                    "\t-k <nb>           names asked, names not found "
+                    "and clients the most seen in the DNS summaries\n");
 }
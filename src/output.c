@@ -0,0 +1,240 @@
+#include "../include/output.h"
+
+// sink selected by the thread, so the frames of two threads are not
+// mixed
+__thread output_t *output = NULL;
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief Make room for at least needed more bytes in the buffer of the
+ * selected sink
+ * @return 0 on success, -1 if memory is missing, the buffer is kept
+ */
+int output_grow(size_t needed) {
+
+    size_t size = output->size == 0 ? OUTPUT_SIZE : output->size;
+    char *buf;
+
+    while (size - output->len < needed)
+        size *= 2;
+
+    if ((buf = realloc(output->buf, size)) == NULL) {
+        perror("realloc");
+        return -1;
+    }
+    output->buf = buf;
+    output->size = size;
+
+    return 0;
+}
+
+// Room for n more bytes, the text is dropped without it
+#define OUTPUT_RESERVE(n)                        \
+    do {                                         \
+        if (output->size - output->len < (n) &&  \
+            output_grow(n) == -1)                \
+            return;                              \
+    } while (0)
+
+/**
+ * @brief Append formatted text, as printf does
+ */
+void output_printf(const char *format, ...) {
+
+    va_list ap;
+    int n;
+
+    OUTPUT_RESERVE(1);
+
+    va_start(ap, format);
+    n = vsnprintf(output->buf + output->len, output->size - output->len,
+                  format, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+
+    // too long for what is left, the text is formatted again
+    if ((size_t)n >= output->size - output->len) {
+        if (output_grow(n + 1) == -1)
+            return;
+        va_start(ap, format);
+        vsnprintf(output->buf + output->len, output->size - output->len,
+                  format, ap);
+        va_end(ap);
+    }
+
+    output->len += n;
+}
+
+void output_char(char c) {
+
+    OUTPUT_RESERVE(1);
+    output->buf[output->len++] = c;
+}
+
+void output_str(const char *str) {
+
+    size_t n = strlen(str);
+
+    OUTPUT_RESERVE(n);
+    memcpy(output->buf + output->len, str, n);
+    output->len += n;
+}
+
+/**
+ * @brief Add spaces after the text appended since start, up to width
+ * characters as "%-*s" does
+ */
+void output_pad(size_t start, size_t width) {
+
+    size_t written = output->len - start;
+
+    if (written >= width)
+        return;
+
+    OUTPUT_RESERVE(width - written);
+    memset(output->buf + output->len, ' ', width - written);
+    output->len += width - written;
+}
+
+void output_uint(unsigned long value) {
+
+    char digits[20];
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    OUTPUT_RESERVE(n);
+    while (n > 0)
+        output->buf[output->len++] = digits[--n];
+}
+
+/**
+ * @brief Append an IPv4 address in dotted decimal notation
+ */
+void output_ip4(const struct in_addr *addr) {
+
+    const uint8_t *bytes = (const uint8_t *)&addr->s_addr;
+
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (i != 0)
+            output_char('.');
+        output_uint(bytes[i]);
+    }
+}
+
+void output_ip6(const struct in6_addr *addr) {
+
+    OUTPUT_RESERVE(INET6_ADDRSTRLEN);
+    inet_ntop(AF_INET6, addr, output->buf + output->len,
+              INET6_ADDRSTRLEN);
+    output->len += strlen(output->buf + output->len);
+}
+
+/**
+ * @brief Append a MAC address as six hexadecimal bytes separated by
+ * colons
+ */
+void output_mac(const struct ether_addr *addr) {
+
+    OUTPUT_RESERVE(17);
+
+    int i;
+    for (i = 0; i < ETH_ALEN; i++) {
+        if (i != 0)
+            output->buf[output->len++] = ':';
+        output->buf[output->len++] =
+            hex_digits[addr->ether_addr_octet[i] >> 4];
+        output->buf[output->len++] =
+            hex_digits[addr->ether_addr_octet[i] & 0xf];
+    }
+}
+
+/**
+ * @brief Append a payload with its non printable bytes replaced by
+ * dots, in lines of width characters
+ */
+void output_dump(const u_char *data, int length, int width) {
+
+    if (length <= 0)
+        return;
+
+    OUTPUT_RESERVE(length + length / width);
+
+    int i;
+    for (i = 0; i < length; i++) {
+        if (i % width == 0 && i != 0)
+            output->buf[output->len++] = '\n';
+
+        // isprint of the C locale
+        output->buf[output->len++] =
+            data[i] >= 0x20 && data[i] < 0x7f ? data[i] : '.';
+    }
+}
+
+/**
+ * @brief Prepare an empty sink which keeps the frames until batch
+ * bytes are buffered, to write them with a single call
+ */
+void output_open(output_t *sink, size_t batch) {
+
+    sink->buf = NULL;
+    sink->len = 0;
+    sink->size = 0;
+    sink->batch = batch;
+    sink->ring = NULL;
+}
+
+/**
+ * @brief Make sink the one the output functions of the calling thread
+ * append to, its analyzer context owns it
+ */
+void output_select(output_t *sink) { output = sink; }
+
+/**
+ * @brief Give the text of the sink to the writer thread through its
+ * ring instead of writing it on stdout
+ */
+void output_attach(writer_ring_t *ring) { output->ring = ring; }
+
+/**
+ * @brief End of a frame, the buffer is written if the batch is full
+ */
+void output_frame(void) {
+
+    if (output->len != 0 && output->len >= output->batch)
+        output_flush();
+}
+
+/**
+ * @brief Write everything buffered by the sink on stdout, or queue
+ * it for the writer thread
+ */
+void output_flush(void) {
+
+    if (output->len == 0)
+        return;
+
+    if (output->ring != NULL)
+        writer_push(output->ring, output->buf, output->len);
+    else if (fwrite(output->buf, 1, output->len, stdout) != output->len)
+        perror("fwrite");
+    output->len = 0;
+}
+
+/**
+ * @brief Write what is left and release the buffer of the sink
+ */
+void output_free(void) {
+
+    output_flush();
+    free(output->buf);
+    output->buf = NULL;
+    output->size = 0;
+    output->ring = NULL;
+}
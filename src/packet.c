@@ -0,0 +1,22 @@
+#include "../include/packet.h"
+
+// Names of the application protocols, indexed by their id
+static const char *app_names[APP_MAX] = {
+    "Other", "DNS", "SMTP", "HTTP", "HTTPS",
+    "FTP",   "POP3", "IMAP", "TELNET", "BOOTP"};
+
+void init_packet(packet_t *pkt, const struct pcap_pkthdr *header,
+                 const u_char *packet) {
+
+    memset(pkt, 0, sizeof(packet_t));
+    pkt->data = packet;
+    pkt->caplen = header->caplen;
+    pkt->len = header->len;
+    pkt->ts = header->ts.tv_sec;
+    pkt->ts_usec = header->ts.tv_usec;
+}
+
+const char *app_name(uint8_t app) {
+
+    return app < APP_MAX ? app_names[app] : app_names[APP_NONE];
+}
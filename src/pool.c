@@ -0,0 +1,90 @@
+#include "../include/pool.h"
+
+// Header of a slab, keeps the objects aligned
+typedef union slab_t {
+    union slab_t *next;
+    max_align_t align;
+} slab_t;
+
+/**
+ * @brief Prepare an empty pool, nothing is allocated yet
+ */
+void pool_open(pool_t *pool, size_t size, size_t max) {
+
+    // an object is big enough to link it while free
+    if (size < sizeof(void *))
+        size = sizeof(void *);
+    size = (size + sizeof(max_align_t) - 1) &
+           ~(sizeof(max_align_t) - 1);
+
+    pool->size = size;
+    pool->max = max;
+    pool->used = 0;
+    pool->allocated = 0;
+    pool->free = NULL;
+    pool->slabs = NULL;
+}
+
+/**
+ * @brief Take an object, a slab is allocated if none is free
+ * @return the object, NULL if the pool is full or out of memory
+ */
+void *pool_get(pool_t *pool) {
+
+    if (pool->free == NULL) {
+
+        size_t nb = POOL_SLAB, i;
+        if (pool->max != 0 && pool->allocated + nb > pool->max)
+            nb = pool->max - pool->allocated;
+        if (nb == 0)
+            return NULL;
+
+        slab_t *slab = malloc(sizeof(slab_t) + nb * pool->size);
+        if (slab == NULL)
+            return NULL;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->allocated += nb;
+
+        char *objects = (char *)(slab + 1);
+        for (i = 0; i < nb; i++) {
+            *(void **)(objects + i * pool->size) = pool->free;
+            pool->free = objects + i * pool->size;
+        }
+    }
+
+    void *object = pool->free;
+    pool->free = *(void **)object;
+    pool->used++;
+
+    return object;
+}
+
+/**
+ * @brief Give an object back to the pool
+ */
+void pool_put(pool_t *pool, void *object) {
+
+    *(void **)object = pool->free;
+    pool->free = object;
+    pool->used--;
+}
+
+/**
+ * @brief Free every slab, the objects must not be used anymore
+ */
+void pool_close(pool_t *pool) {
+
+    slab_t *slab = pool->slabs, *next;
+
+    while (slab != NULL) {
+        next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    pool->slabs = NULL;
+    pool->free = NULL;
+    pool->used = 0;
+    pool->allocated = 0;
+}
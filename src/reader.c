@@ -0,0 +1,439 @@
+#include "../include/reader.h"
+
+/**
+ * @brief Read a 16 bits field of the file in the host byte order
+ */
+uint16_t reader_u16(const reader_t *reader, const uint8_t *field) {
+
+    uint16_t value;
+    memcpy(&value, field, sizeof(value));
+
+    return reader->swap ? __builtin_bswap16(value) : value;
+}
+
+/**
+ * @brief Read a 32 bits field of the file in the host byte order
+ */
+uint32_t reader_u32(const reader_t *reader, const uint8_t *field) {
+
+    uint32_t value;
+    memcpy(&value, field, sizeof(value));
+
+    return reader->swap ? __builtin_bswap32(value) : value;
+}
+
+/**
+ * @brief Ask the kernel to read the next window of the file before
+ * we reach it
+ */
+void reader_advise(reader_t *reader) {
+
+    if (reader->offset + READER_WINDOW / 2 < reader->advised ||
+        reader->advised >= reader->size)
+        return;
+
+    size_t length = READER_WINDOW;
+    if (reader->advised + length > reader->size)
+        length = reader->size - reader->advised;
+
+    madvise((void *)(reader->map + reader->advised), length,
+            MADV_WILLNEED);
+    reader->advised += length;
+}
+
+/**
+ * @brief Map the capture file in memory. The mapping is followed by
+ * zeroed pages, so an analyzer reading past the last frame does not
+ * fault.
+ * @return 0 on success, -1 on error with errno set, 1 if the format
+ * must be read by libpcap
+ */
+int reader_open(reader_t *reader, const char *file) {
+
+    memset(reader, 0, sizeof(reader_t));
+    reader->map = MAP_FAILED;
+
+    if ((reader->fd = open(file, O_RDONLY)) == -1)
+        return -1;
+
+    struct stat st;
+    if (fstat(reader->fd, &st) == -1) {
+        reader_close(reader);
+        return -1;
+    }
+
+    reader->size = st.st_size;
+    if (reader->size < sizeof(struct pcap_file_hdr)) {
+        reader_close(reader);
+        return 1;
+    }
+
+    size_t page = getpagesize();
+    reader->map_size =
+        (reader->size + page - 1) / page * page + READER_PADDING;
+
+    // Reserve the whole area, then put the file at its beginning
+    void *area = mmap(NULL, reader->map_size, PROT_READ,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED) {
+        reader_close(reader);
+        return -1;
+    }
+    reader->map = area;
+
+    if (mmap(area, reader->size, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+             reader->fd, 0) == MAP_FAILED) {
+        reader_close(reader);
+        return -1;
+    }
+
+    // The file is read once from the beginning to the end
+    madvise(area, reader->size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(area, reader->size, MADV_HUGEPAGE);
+#endif
+    posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    reader_advise(reader);
+
+    uint32_t magic;
+    memcpy(&magic, reader->map, sizeof(magic));
+
+    if (magic == PCAPNG_SHB) {
+        reader->format = READER_PCAPNG;
+        return 0;
+    }
+
+    reader->format = READER_PCAP;
+    if (magic == PCAP_MAGIC) {
+    } else if (magic == __builtin_bswap32(PCAP_MAGIC))
+        reader->swap = 1;
+    else if (magic == PCAP_MAGIC_NSEC)
+        reader->nsec = 1;
+    else if (magic == __builtin_bswap32(PCAP_MAGIC_NSEC))
+        reader->swap = reader->nsec = 1;
+    else {
+        // unknown format, libpcap may know it
+        reader_close(reader);
+        return 1;
+    }
+
+    struct pcap_file_hdr *file_header =
+        (struct pcap_file_hdr *)reader->map;
+    reader->snaplen =
+        reader_u32(reader, (uint8_t *)&file_header->snaplen);
+    reader->offset = sizeof(struct pcap_file_hdr);
+
+    if (reader->size >= reader->offset + sizeof(struct pcap_record_hdr))
+        reader->first_sec =
+            reader_u32(reader, reader->map + reader->offset);
+
+    return 0;
+}
+
+/**
+ * @brief Get the next record of a classic pcap file
+ * @return 1 if a frame is read, 0 at the end of file, -1 if the file
+ * is truncated or corrupted
+ */
+int reader_next_pcap(reader_t *reader, struct pcap_pkthdr *header,
+                     const u_char **packet) {
+
+    if (reader->offset + sizeof(struct pcap_record_hdr) >
+        reader->size)
+        return 0;
+
+    const uint8_t *record = reader->map + reader->offset;
+    uint32_t caplen = reader_u32(reader, record + 8);
+
+    if (caplen > READER_MAX_SNAPLEN ||
+        caplen > reader->size - reader->offset -
+                     sizeof(struct pcap_record_hdr))
+        return -1;
+
+    header->ts.tv_sec = reader_u32(reader, record);
+    header->ts.tv_usec = reader_u32(reader, record + 4);
+    if (reader->nsec)
+        header->ts.tv_usec /= 1000;
+    header->caplen = caplen;
+    header->len = reader_u32(reader, record + 12);
+
+    *packet = record + sizeof(struct pcap_record_hdr);
+    reader->offset += sizeof(struct pcap_record_hdr) + caplen;
+
+    return 1;
+}
+
+/**
+ * @brief Keep the timestamp resolution of a pcapng interface
+ */
+void reader_interface(reader_t *reader, const uint8_t *block,
+                      uint32_t length, int nb_if) {
+
+    if (nb_if >= READER_MAX_IF)
+        return;
+
+    // microseconds unless the interface says otherwise
+    reader->ts_units[nb_if] = 1000000;
+
+    // options follow the link type, the reserved field and snaplen
+    uint32_t i = 16;
+    while (i + 4 <= length - 4) {
+
+        uint16_t code = reader_u16(reader, block + i);
+        uint16_t opt_length = reader_u16(reader, block + i + 2);
+
+        if (code == 0)
+            break;
+
+        // if_tsresol : power of 10 or of 2 if the high bit is set
+        if (code == 9 && opt_length == 1) {
+            uint8_t resol = block[i + 4];
+            uint64_t units = 1;
+            int j;
+            if (resol & 0x80)
+                units <<= resol & 0x7f;
+            else
+                for (j = 0; j < resol; j++)
+                    units *= 10;
+            reader->ts_units[nb_if] = units;
+        }
+
+        i += 4 + ((opt_length + 3) & ~3);
+    }
+}
+
+/**
+ * @brief Get the next packet block of a pcapng file, other blocks are
+ * skipped
+ * @return 1 if a frame is read, 0 at the end of file, -1 if the file
+ * is truncated or corrupted
+ */
+int reader_next_pcapng(reader_t *reader, struct pcap_pkthdr *header,
+                       const u_char **packet) {
+
+    while (reader->offset + 12 <= reader->size) {
+
+        const uint8_t *block = reader->map + reader->offset;
+        uint32_t type, length, id = 0, caplen, len;
+        uint64_t ts = 0;
+
+        // a section header sets the byte order of its blocks
+        memcpy(&type, block, sizeof(type));
+        if (type == PCAPNG_SHB) {
+            uint32_t order;
+            memcpy(&order, block + 8, sizeof(order));
+            if (order == PCAPNG_BYTE_ORDER)
+                reader->swap = 0;
+            else if (order == __builtin_bswap32(PCAPNG_BYTE_ORDER))
+                reader->swap = 1;
+            else
+                return -1;
+        }
+
+        type = reader_u32(reader, block);
+        length = reader_u32(reader, block + 4);
+        if (length < 12 || length % 4 != 0 ||
+            length > reader->size - reader->offset)
+            return -1;
+
+        reader->offset += length;
+
+        switch (type) {
+
+        case PCAPNG_SHB:
+            reader->nb_if = 0;
+            continue;
+
+        case PCAPNG_IDB:
+            reader_interface(reader, block, length, reader->nb_if);
+            reader->nb_if++;
+            continue;
+
+        case PCAPNG_EPB:
+            if (length < 32)
+                return -1;
+            id = reader_u32(reader, block + 8);
+            ts = ((uint64_t)reader_u32(reader, block + 12) << 32) |
+                 reader_u32(reader, block + 16);
+            caplen = reader_u32(reader, block + 20);
+            len = reader_u32(reader, block + 24);
+            *packet = block + 28;
+            if (caplen > length - 32)
+                return -1;
+            break;
+
+        case PCAPNG_OPB:
+            if (length < 32)
+                return -1;
+            id = reader_u16(reader, block + 8);
+            ts = ((uint64_t)reader_u32(reader, block + 12) << 32) |
+                 reader_u32(reader, block + 16);
+            caplen = reader_u32(reader, block + 20);
+            len = reader_u32(reader, block + 24);
+            *packet = block + 28;
+            if (caplen > length - 32)
+                return -1;
+            break;
+
+        case PCAPNG_SPB:
+            if (length < 16)
+                return -1;
+            len = reader_u32(reader, block + 8);
+            caplen = len < length - 16 ? len : length - 16;
+            *packet = block + 12;
+            break;
+
+        default:
+            continue;
+        }
+
+        if (caplen > READER_MAX_SNAPLEN)
+            return -1;
+
+        uint64_t units =
+            id < (uint32_t)reader->nb_if && id < READER_MAX_IF
+                ? reader->ts_units[id]
+                : 1000000;
+        header->ts.tv_sec = ts / units;
+        header->ts.tv_usec = (ts % units) * 1000000 / units;
+        header->caplen = caplen;
+        header->len = len;
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get the next frame of the file kept by the filter. The
+ * packet points into the mapping and stays valid until reader_close.
+ * @return 1 if a frame is read, 0 at the end of file, -1 if the file
+ * is truncated or corrupted
+ */
+int reader_next(reader_t *reader, struct pcap_pkthdr *header,
+                const u_char **packet) {
+
+    int ret;
+
+    do {
+        reader_advise(reader);
+
+        if (reader->format == READER_PCAPNG)
+            ret = reader_next_pcapng(reader, header, packet);
+        else
+            ret = reader_next_pcap(reader, header, packet);
+
+    } while (ret == 1 && reader->filter != NULL &&
+             !filter_match(reader->filter, header, *packet));
+
+    return ret;
+}
+
+/**
+ * @brief Check if a record header of a classic pcap file starts at
+ * the offset. The following headers must be valid too, up to
+ * READER_CHECK of them or the end of the file.
+ * @return 1 if it is a record boundary, 0 otherwise
+ */
+int reader_is_record(const reader_t *reader, size_t offset) {
+
+    uint32_t limit = reader->snaplen != 0 &&
+                             reader->snaplen < READER_MAX_SNAPLEN
+                         ? reader->snaplen
+                         : READER_MAX_SNAPLEN;
+    uint32_t max_usec = reader->nsec ? 1000000000 : 1000000;
+    uint32_t previous = 0;
+
+    int i;
+    for (i = 0; i < READER_CHECK; i++) {
+
+        if (offset == reader->size)
+            return 1;
+        if (offset + sizeof(struct pcap_record_hdr) > reader->size)
+            return 0;
+
+        const uint8_t *record = reader->map + offset;
+        uint32_t sec = reader_u32(reader, record);
+        uint32_t usec = reader_u32(reader, record + 4);
+        uint32_t caplen = reader_u32(reader, record + 8);
+        uint32_t len = reader_u32(reader, record + 12);
+
+        if (caplen == 0 || caplen > limit || caplen > len ||
+            usec >= max_usec ||
+            sec + READER_MAX_GAP < reader->first_sec ||
+            caplen > reader->size - offset -
+                         sizeof(struct pcap_record_hdr))
+            return 0;
+
+        if (i != 0 && (sec > previous + READER_MAX_GAP ||
+                       previous > sec + READER_MAX_GAP))
+            return 0;
+
+        previous = sec;
+        offset += sizeof(struct pcap_record_hdr) + caplen;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Cut the records of a classic pcap file in chunks of about the
+ * same size. The boundary of a chunk is the first valid record header
+ * found from its offset.
+ * @return 0 on success, -1 if the file is not a classic pcap file
+ */
+int reader_split(const reader_t *reader, size_t *bounds,
+                 int nb_chunks) {
+
+    if (reader->format != READER_PCAP)
+        return -1;
+
+    size_t start = reader->offset;
+    bounds[0] = start;
+    bounds[nb_chunks] = reader->size;
+
+    int i;
+    for (i = 1; i < nb_chunks; i++) {
+
+        size_t offset = start + (reader->size - start) / nb_chunks * i;
+        if (offset < bounds[i - 1])
+            offset = bounds[i - 1];
+
+        while (offset < reader->size &&
+               !reader_is_record(reader, offset))
+            offset++;
+
+        bounds[i] = offset;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Make a reader limited to the records between start and end.
+ * The chunk shares the mapping of the reader and must not be closed.
+ */
+void reader_chunk(const reader_t *reader, reader_t *chunk,
+                  size_t start, size_t end) {
+
+    memcpy(chunk, reader, sizeof(reader_t));
+    chunk->fd = -1;
+    chunk->offset = start;
+    chunk->advised = start;
+    chunk->size = end;
+}
+
+/**
+ * @brief Unmap the file and close it
+ */
+void reader_close(reader_t *reader) {
+
+    if (reader->map != MAP_FAILED)
+        munmap((void *)reader->map, reader->map_size);
+    if (reader->fd != -1)
+        close(reader->fd);
+
+    reader->map = MAP_FAILED;
+    reader->fd = -1;
+}
@@ -0,0 +1,75 @@
+#include "../include/registry.h"
+
+/**
+ * @brief Register the ports of the built-in analyzers
+ */
+void registry_init(registry_t *registry) {
+
+    memset(registry, APP_NONE, sizeof(registry_t));
+
+    registry->apps[REGISTRY_TCP][DNS_PORT] = APP_DNS;
+    registry->apps[REGISTRY_TCP][SMTP_PORT] = APP_SMTP;
+    registry->apps[REGISTRY_TCP][HTTP_PORT] = APP_HTTP;
+    registry->apps[REGISTRY_TCP][HTTPS_PORT] = APP_HTTPS;
+    registry->apps[REGISTRY_TCP][FTP_PORT] = APP_FTP;
+    registry->apps[REGISTRY_TCP][DATA_FTP_PORT] = APP_FTP;
+    registry->apps[REGISTRY_TCP][POP3_PORT] = APP_POP3;
+    registry->apps[REGISTRY_TCP][IMAP_PORT] = APP_IMAP;
+    registry->apps[REGISTRY_TCP][TELNET_PORT] = APP_TELNET;
+
+    registry->apps[REGISTRY_UDP][BOOTP_PORT] = APP_BOOTP;
+    registry->apps[REGISTRY_UDP][DNS_PORT] = APP_DNS;
+}
+
+/**
+ * @brief Register a port given as port=proto, such as 8080=http. The
+ * port is registered for the transports the analyzer reads: DNS on
+ * both, BOOTP (or DHCP) on UDP, the others on TCP. The protocol none
+ * removes the port from both.
+ * @return 0 on success, -1 if the override is not valid
+ */
+int registry_parse(registry_t *registry, const char *override) {
+
+    char *end;
+    const char *name;
+    unsigned long port = strtoul(override, &end, 10);
+    uint8_t app;
+
+    if (end == override || *end != '=' || port >= REGISTRY_PORTS)
+        return -1;
+    name = end + 1;
+
+    if (strcasecmp(name, "none") == 0) {
+        registry->apps[REGISTRY_TCP][port] = APP_NONE;
+        registry->apps[REGISTRY_UDP][port] = APP_NONE;
+        return 0;
+    }
+
+    if (strcasecmp(name, "dhcp") == 0)
+        name = app_name(APP_BOOTP);
+
+    for (app = APP_NONE + 1; app < APP_MAX; app++)
+        if (strcasecmp(name, app_name(app)) == 0)
+            break;
+    if (app == APP_MAX)
+        return -1;
+
+    if (app != APP_BOOTP)
+        registry->apps[REGISTRY_TCP][port] = app;
+    if (app == APP_BOOTP || app == APP_DNS)
+        registry->apps[REGISTRY_UDP][port] = app;
+
+    return 0;
+}
+
+/**
+ * @brief Choose between the applications of both ports, the one with
+ * the lowest id when both are registered
+ * @return APP_NONE if neither port is registered
+ */
+uint8_t registry_pick(uint8_t src, uint8_t dst) {
+
+    if (src == APP_NONE || (dst != APP_NONE && dst < src))
+        return dst;
+    return src;
+}
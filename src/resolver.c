@@ -0,0 +1,675 @@
+#include "../include/resolver.h"
+
+_Static_assert(sizeof(query_key_t) == 40, "key hashed by words");
+
+// Names of the response codes counted apart
+static const char *rcode_names[RESOLVER_RCODES] = {
+    "NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED"};
+
+// Types of the names asked printed by their mnemonic
+static const struct {
+    uint16_t type;
+    const char *name;
+} type_names[] = {{1, "A"},      {2, "NS"},     {5, "CNAME"},
+                  {6, "SOA"},    {12, "PTR"},   {15, "MX"},
+                  {16, "TXT"},   {28, "AAAA"},  {33, "SRV"},
+                  {35, "NAPTR"}, {43, "DS"},    {48, "DNSKEY"},
+                  {64, "SVCB"},  {65, "HTTPS"}, {251, "IXFR"},
+                  {252, "AXFR"}, {255, "ANY"}};
+
+/**
+ * @brief Prepare an empty table, the queries are allocated with the
+ * first ones. The counters are printed every interval seconds, or
+ * only once closed if interval is 0, with the top names and clients
+ * when top is not 0.
+ * @return 0 on success, -1 on error with errno set, nothing is left
+ * allocated
+ */
+int resolver_open(resolvers_t *resolvers, uint32_t interval,
+                  size_t max, uint32_t top) {
+
+    memset(resolvers, 0, sizeof(resolvers_t));
+    pool_open(&resolvers->queries, sizeof(query_t), max);
+    resolvers->interval = interval;
+
+    if (top == 0)
+        return 0;
+
+    // a key seen often keeps its counter among the ones kept
+    if (topk_open(&resolvers->names, top * TOPK_FACTOR) == -1 ||
+        topk_open(&resolvers->nxdomains, top * TOPK_FACTOR) == -1 ||
+        topk_open(&resolvers->clients, top * TOPK_FACTOR) == -1) {
+        topk_close(&resolvers->names);
+        topk_close(&resolvers->nxdomains);
+        return -1;
+    }
+    resolvers->top = top;
+
+    return 0;
+}
+
+/**
+ * @brief Source or destination address of the frame, an IPv4 one
+ * mapped in an IPv6 one
+ */
+void resolver_addr(struct in6_addr *addr, const packet_t *pkt,
+                   int dst) {
+
+    memset(addr, 0, sizeof(struct in6_addr));
+
+    if (pkt->ip_version == 4) {
+        // ::ffff:a.b.c.d
+        addr->s6_addr[10] = 0xff;
+        addr->s6_addr[11] = 0xff;
+        memcpy(&addr->s6_addr[12],
+               dst ? &pkt->ip_dst.v4 : &pkt->ip_src.v4, 4);
+    } else {
+        *addr = dst ? pkt->ip_dst.v6 : pkt->ip_src.v6;
+    }
+}
+
+/**
+ * @brief Hash the key word by word
+ */
+uint64_t resolver_hash(const query_key_t *key) {
+
+    uint64_t words[sizeof(query_key_t) / sizeof(uint64_t)];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    memcpy(words, key, sizeof(words));
+    for (i = 0; i < sizeof(words) / sizeof(*words); i++) {
+        hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Hash the labels of the first name of the question, without
+ * decoding it and whatever its case. A pointer ends the name, the
+ * same one is found in the query and in its response.
+ */
+uint32_t resolver_name(const u_char *packet, int length) {
+
+    uint32_t hash = 0x811c9dc5;
+    int i;
+
+    for (i = 0; i < length && i < DNS_NAME_MAX + 1; i++) {
+        hash = (hash ^ tolower(packet[i])) * 0x01000193;
+        if (packet[i] == 0)
+            break;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Key of the first name of the question: its type, then the
+ * name in lower case. A pointer or a byte not printable is not
+ * expected there, the name is then not counted or its byte replaced.
+ * @return length of the key, -1 if the question is malformed
+ */
+int resolver_question(const u_char *packet, int length, u_char *key) {
+
+    int offset = 0, len = 2, size, k;
+
+    while (offset < length) {
+
+        size = packet[offset];
+        if (size == 0)
+            break;
+
+        if ((size & DNS_POINTER) != 0 || offset + 1 + size > length ||
+            len - 2 + (len > 2) + size > DNS_NAME_MAX)
+            return -1;
+
+        if (len > 2)
+            key[len++] = '.';
+        for (k = 0; k < size; k++) {
+            key[len] = tolower(packet[offset + 1 + k]);
+            if (!isprint(key[len]))
+                key[len] = '?';
+            len++;
+        }
+
+        offset += size + 1;
+    }
+
+    if (offset + 3 > length)
+        return -1;
+
+    key[0] = packet[offset + 1];
+    key[1] = packet[offset + 2];
+
+    return len;
+}
+
+/**
+ * @brief Mnemonic of a type, or its number
+ */
+const char *resolver_type(uint16_t type, char *buf, size_t size) {
+
+    size_t i;
+
+    for (i = 0; i < sizeof(type_names) / sizeof(*type_names); i++)
+        if (type_names[i].type == type)
+            return type_names[i].name;
+
+    snprintf(buf, size, "TYPE%u", type);
+
+    return buf;
+}
+
+/**
+ * @brief Counters of a server, added to the table the first time it
+ * is seen. The slot is found from the address, the next ones are
+ * tried while they hold another server.
+ * @return the counters, the ones of all the other servers once the
+ * table is full
+ */
+server_t *resolver_server(resolvers_t *resolvers,
+                          const struct in6_addr *addr) {
+
+    uint32_t words[4], hash;
+    server_t *server;
+    int i;
+
+    memcpy(words, addr, sizeof(words));
+    hash = (words[0] ^ words[1] ^ words[2] ^ words[3]) * 0x9e3779b1;
+
+    for (i = 0; i < RESOLVER_SERVERS; i++) {
+        server = &resolvers->servers[((hash >> 16) + i) &
+                                     (RESOLVER_SERVERS - 1)];
+        if (!server->used)
+            break;
+        if (memcmp(&server->addr, addr, sizeof(*addr)) == 0)
+            return server;
+    }
+
+    if (resolvers->nb_servers >= RESOLVER_SERVERS * 3 / 4)
+        return &resolvers->servers[RESOLVER_SERVERS];
+
+    server->addr = *addr;
+    server->used = 1;
+    resolvers->nb_servers++;
+
+    return server;
+}
+
+/**
+ * @brief Remove a query from its bucket and from the wheel, and give
+ * it back to the pool
+ */
+void resolver_free(resolvers_t *resolvers, query_t *query) {
+
+    if ((*query->prev = query->next) != NULL)
+        query->next->prev = query->prev;
+    if ((*query->tick_prev = query->tick_next) != NULL)
+        query->tick_next->tick_prev = query->tick_prev;
+
+    pool_put(&resolvers->queries, query);
+}
+
+/**
+ * @brief Turn the wheel up to now, the queries of the slots passed
+ * are lost if they expired. A slot also holds queries expiring one
+ * turn later, they stay. The wheel never turns back.
+ */
+void resolver_expire(resolvers_t *resolvers, uint32_t now) {
+
+    query_t *query, *next;
+    server_t *server;
+
+    if (resolvers->clock == 0)
+        resolvers->clock = now;
+    else if ((int32_t)(now - resolvers->clock) > RESOLVER_WHEEL)
+        resolvers->clock = now - RESOLVER_WHEEL;
+
+    while ((int32_t)(now - resolvers->clock) > 0) {
+
+        resolvers->clock++;
+        query = resolvers->wheel[resolvers->clock % RESOLVER_WHEEL];
+
+        while (query != NULL) {
+            next = query->tick_next;
+            if ((int32_t)(query->expire - now) <= 0) {
+                server =
+                    resolver_server(resolvers, &query->key.addr[1]);
+                server->lost++;
+                resolver_free(resolvers, query);
+            }
+            query = next;
+        }
+    }
+}
+
+/**
+ * @brief Give up the query expiring first to make room, it is lost
+ */
+void resolver_evict(resolvers_t *resolvers) {
+
+    query_t *query;
+    uint32_t i;
+
+    for (i = 1; i <= RESOLVER_WHEEL; i++) {
+        query = resolvers->wheel[(resolvers->clock + i) %
+                                 RESOLVER_WHEEL];
+        if (query != NULL) {
+            resolver_server(resolvers, &query->key.addr[1])->lost++;
+            resolver_free(resolvers, query);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Query waiting with this key
+ * @return the query, NULL if none
+ */
+query_t *resolver_find(resolvers_t *resolvers, const query_key_t *key,
+                       uint64_t hash) {
+
+    query_t *query;
+
+    for (query = resolvers->buckets[hash % RESOLVER_BUCKETS];
+         query != NULL; query = query->next)
+        if (memcmp(&query->key, key, sizeof(query_key_t)) == 0)
+            return query;
+
+    return NULL;
+}
+
+/**
+ * @brief Wait for the response of a query. A query sent again keeps
+ * the time of the first one.
+ */
+void resolver_query(resolvers_t *resolvers, const query_key_t *key,
+                    uint64_t sent, uint32_t now) {
+
+    uint64_t hash = resolver_hash(key);
+    query_t **bucket, **tick, *query;
+
+    if (resolver_find(resolvers, key, hash) != NULL)
+        return;
+
+    resolver_server(resolvers, &key->addr[1])->queries++;
+
+    if ((query = pool_get(&resolvers->queries)) == NULL) {
+        resolver_evict(resolvers);
+        if ((query = pool_get(&resolvers->queries)) == NULL) {
+            resolvers->dropped++;
+            return;
+        }
+    }
+
+    query->key = *key;
+    query->sent = sent;
+    query->expire = now + RESOLVER_TIMEOUT;
+
+    bucket = &resolvers->buckets[hash % RESOLVER_BUCKETS];
+    if ((query->next = *bucket) != NULL)
+        query->next->prev = &query->next;
+    query->prev = bucket;
+    *bucket = query;
+
+    tick = &resolvers->wheel[query->expire % RESOLVER_WHEEL];
+    if ((query->tick_next = *tick) != NULL)
+        query->tick_next->tick_prev = &query->tick_next;
+    query->tick_prev = tick;
+    *tick = query;
+}
+
+/**
+ * @brief Count the time and the code of the response of a query
+ * waiting, which is then done
+ */
+void resolver_response(resolvers_t *resolvers, const query_key_t *key,
+                       uint64_t received, int rcode) {
+
+    query_t *query = resolver_find(resolvers, key, resolver_hash(key));
+    server_t *server = resolver_server(resolvers, &key->addr[1]);
+
+    if (query == NULL) {
+        server->unmatched++;
+        return;
+    }
+
+    server->answers++;
+    server->rcodes[rcode < RESOLVER_RCODES ? rcode : RESOLVER_RCODES]++;
+    // frames of a file can go back in time a little
+    server->times[resolver_time(
+        received > query->sent ? received - query->sent : 0)]++;
+
+    resolver_free(resolvers, query);
+}
+
+/**
+ * @brief Match the DNS message of a datagram, the bytes not captured
+ * are not read
+ */
+void resolver_packet(packet_t *pkt, const u_char *packet, int length) {
+
+    if (pkt->ctx->resolvers == NULL)
+        return;
+
+    if (length > (int)(pkt->data + pkt->caplen - packet))
+        length = pkt->data + pkt->caplen - packet;
+
+    resolver_message(pkt, packet, length);
+}
+
+/**
+ * @brief Follow the capture time of every frame: the queries waiting
+ * too long are lost, and the counters are printed once the interval
+ * is over, whether DNS is seen or not
+ */
+void resolver_clock(resolvers_t *resolvers, uint32_t now) {
+
+    resolver_expire(resolvers, now);
+
+    if (resolvers->interval != 0) {
+        if (resolvers->next == 0)
+            resolvers->next = now + resolvers->interval;
+        // an interval without any frame is not printed
+        if ((int32_t)(now - resolvers->next) >= 0) {
+            resolver_summary(resolvers,
+                             resolvers->next - resolvers->interval);
+            resolvers->next = now + resolvers->interval;
+        }
+    } else if (resolvers->next == 0) {
+        resolvers->next = now;
+    }
+}
+
+/**
+ * @brief Match a DNS message with the transactions of the thread. Only
+ * the standard queries asking one name, and their responses, are
+ * matched. The clock is kept by resolver_clock, called by frame.
+ */
+void resolver_message(packet_t *pkt, const u_char *packet,
+                      int length) {
+
+    resolvers_t *resolvers = pkt->ctx->resolvers;
+    const struct dns_hdr *dns_header;
+    uint64_t usec;
+    uint16_t flags;
+    query_key_t key;
+    u_char name[TOPK_KEY];
+    int response, len;
+
+    if (resolvers == NULL || length < (int)sizeof(struct dns_hdr))
+        return;
+
+    dns_header = (const struct dns_hdr *)packet;
+    flags = ntohs(dns_header->flags);
+    if ((flags & DNS_OPCODE) != 0 || ntohs(dns_header->qdcount) != 1)
+        return;
+
+    // the client sends the query and receives the response
+    response = (flags & DNS_RESPONSE) != 0;
+    resolver_addr(&key.addr[0], pkt, response);
+    resolver_addr(&key.addr[1], pkt, !response);
+    key.port = response ? pkt->dport : pkt->sport;
+    key.id = ntohs(dns_header->id);
+    key.name = resolver_name(packet + sizeof(struct dns_hdr),
+                             length - sizeof(struct dns_hdr));
+
+    usec = (uint64_t)pkt->ts * 1000000 + pkt->ts_usec;
+    if (response)
+        resolver_response(resolvers, &key, usec, flags & DNS_RCODE);
+    else
+        resolver_query(resolvers, &key, usec, pkt->ts);
+
+    if (resolvers->top == 0 ||
+        (response && (flags & DNS_RCODE) != RESOLVER_NXDOMAIN))
+        return;
+
+    if (!response)
+        topk_add(&resolvers->clients, (const u_char *)&key.addr[0],
+                 sizeof(key.addr[0]));
+
+    len = resolver_question(packet + sizeof(struct dns_hdr),
+                            length - sizeof(struct dns_hdr), name);
+    if (len != -1)
+        topk_add(response ? &resolvers->nxdomains : &resolvers->names,
+                 name, len);
+}
+
+/**
+ * @brief Bucket of a response time: 0 for less than a microsecond,
+ * then n for less than 2^n microseconds
+ */
+int resolver_time(uint64_t usec) {
+
+    int bucket;
+
+    if (usec == 0)
+        return 0;
+
+    bucket = 64 - __builtin_clzll(usec);
+
+    return bucket < RESOLVER_TIMES ? bucket : RESOLVER_TIMES - 1;
+}
+
+/**
+ * @brief Print the counters of a server on stderr, the response times
+ * by bucket with the bucket of the median and of the 99th percentile
+ */
+void resolver_print(const server_t *server) {
+
+    char addr[INET6_ADDRSTRLEN] = "Other servers";
+    unsigned long seen = 0;
+    int i, median = -1, last = -1;
+
+    if (server->used && IN6_IS_ADDR_V4MAPPED(&server->addr))
+        inet_ntop(AF_INET, &server->addr.s6_addr[12], addr,
+                  sizeof(addr));
+    else if (server->used)
+        inet_ntop(AF_INET6, &server->addr, addr, sizeof(addr));
+
+    fprintf(stderr,
+            "DNS %s : %lu queries, %lu answers, %lu lost, "
+            "%lu unmatched\n  Codes :",
+            addr, server->queries, server->answers, server->lost,
+            server->unmatched);
+    for (i = 0; i < RESOLVER_RCODES; i++)
+        fprintf(stderr, " %lu %s,", server->rcodes[i], rcode_names[i]);
+    fprintf(stderr, " %lu other\n", server->rcodes[RESOLVER_RCODES]);
+
+    if (server->answers == 0)
+        return;
+
+    for (i = 0; i < RESOLVER_TIMES; i++) {
+        seen += server->times[i];
+        if (median == -1 && seen * 2 >= server->answers)
+            median = i;
+        if (last == -1 && seen * 100 >= server->answers * 99)
+            last = i;
+    }
+
+    fprintf(stderr, "  Times : median < %lu us, 99%% < %lu us,",
+            1UL << median, 1UL << last);
+    for (i = 0; i < RESOLVER_TIMES; i++)
+        if (server->times[i] != 0)
+            fprintf(stderr, " %lu < %lu us,", server->times[i],
+                    1UL << i);
+    fprintf(stderr, "\n");
+}
+
+/**
+ * @brief Print the keys the most counted by a sketch on stderr, a
+ * name with its type or the address of a client, then forget them.
+ * A key which took the counter of another one was seen at least its
+ * count less the count inherited.
+ */
+void resolver_top(topk_t *topk, uint32_t top, const char *what,
+                  int client) {
+
+    char addr[INET6_ADDRSTRLEN], type[16];
+    const topk_entry_t *entry;
+    struct in6_addr client_addr;
+    uint32_t i, nb;
+
+    if (topk->total == 0)
+        return;
+
+    nb = topk_sort(topk, top);
+    fprintf(stderr, "  Top %u %s of %lu :\n", nb, what, topk->total);
+
+    for (i = 0; i < nb; i++) {
+
+        entry = topk->sorted[i];
+        fprintf(stderr, "    %lu", entry->count);
+        if (entry->error != 0)
+            fprintf(stderr, " (at least %lu)",
+                    entry->count - entry->error);
+
+        if (client) {
+            memcpy(&client_addr, entry->key, sizeof(client_addr));
+            if (IN6_IS_ADDR_V4MAPPED(&client_addr))
+                inet_ntop(AF_INET, &client_addr.s6_addr[12], addr,
+                          sizeof(addr));
+            else
+                inet_ntop(AF_INET6, &client_addr, addr, sizeof(addr));
+            fprintf(stderr, " %s\n", addr);
+        } else {
+            // the root is the empty name
+            fprintf(stderr, " %.*s %s\n",
+                    entry->len > 2 ? entry->len - 2 : 1,
+                    entry->len > 2 ? (const char *)entry->key + 2 : ".",
+                    resolver_type(entry->key[0] << 8 | entry->key[1],
+                                  type, sizeof(type)));
+        }
+    }
+
+    topk_clear(topk);
+}
+
+/**
+ * @brief Print the counters of the servers seen since start on stderr
+ * and clear them. The queries still waiting are counted with the next
+ * interval.
+ */
+void resolver_summary(resolvers_t *resolvers, uint32_t start) {
+
+    time_t seconds = start;
+    struct tm tm;
+    char date[32];
+    int i;
+
+    gmtime_r(&seconds, &tm);
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+
+    // the lines of the threads do not mix
+    flockfile(stderr);
+
+    fprintf(stderr, "DNS from %s UTC : %zu queries waiting, %lu not "
+                    "tracked\n",
+            date, resolvers->queries.used, resolvers->dropped);
+    for (i = 0; i <= RESOLVER_SERVERS; i++)
+        if (resolvers->servers[i].queries != 0 ||
+            resolvers->servers[i].unmatched != 0 ||
+            resolvers->servers[i].lost != 0)
+            resolver_print(&resolvers->servers[i]);
+
+    if (resolvers->top != 0) {
+        resolver_top(&resolvers->names, resolvers->top, "names asked",
+                     0);
+        resolver_top(&resolvers->nxdomains, resolvers->top,
+                     "names not found", 0);
+        resolver_top(&resolvers->clients, resolvers->top, "clients",
+                     1);
+    }
+
+    funlockfile(stderr);
+
+    memset(resolvers->servers, 0, sizeof(resolvers->servers));
+    resolvers->nb_servers = 0;
+    resolvers->dropped = 0;
+}
+
+/**
+ * @brief Add the top names and clients of another thread to the ones
+ * of this one, printed by it from then on
+ */
+void resolver_merge(resolvers_t *dst, resolvers_t *src) {
+
+    if (dst->top == 0 || src->top == 0)
+        return;
+
+    topk_merge(&dst->names, &src->names);
+    topk_merge(&dst->nxdomains, &src->nxdomains);
+    topk_merge(&dst->clients, &src->clients);
+    src->top = 0;
+
+    // printed once closed, from the last interval of the thread
+    if (dst->next == 0)
+        dst->next = src->next;
+}
+
+/**
+ * @brief Write the top names and clients to a file, for the parent
+ * process to merge them, printed by it from then on
+ * @return 0 on success, -1 on error
+ */
+int resolver_save(resolvers_t *resolvers, FILE *file) {
+
+    if (resolvers->top == 0)
+        return 0;
+
+    if (fwrite(&resolvers->next, sizeof(resolvers->next), 1,
+               file) != 1 ||
+        topk_save(&resolvers->names, file) == -1 ||
+        topk_save(&resolvers->nxdomains, file) == -1 ||
+        topk_save(&resolvers->clients, file) == -1 ||
+        fflush(file) == EOF)
+        return -1;
+    resolvers->top = 0;
+
+    return 0;
+}
+
+/**
+ * @brief Merge the top names and clients written by resolver_save
+ * @return 0 on success, -1 on error
+ */
+int resolver_load(resolvers_t *resolvers, FILE *file) {
+
+    uint32_t next;
+
+    if (resolvers->top == 0)
+        return 0;
+
+    rewind(file);
+    if (fread(&next, sizeof(next), 1, file) != 1 ||
+        topk_load(&resolvers->names, file) == -1 ||
+        topk_load(&resolvers->nxdomains, file) == -1 ||
+        topk_load(&resolvers->clients, file) == -1)
+        return -1;
+
+    if (resolvers->next == 0)
+        resolvers->next = next;
+
+    return 0;
+}
+
+/**
+ * @brief Print the counters of the last interval, if a frame was
+ * seen, and free the queries still waiting and the sketches
+ */
+void resolver_close(resolvers_t *resolvers) {
+
+    if (resolvers->next != 0)
+        resolver_summary(resolvers,
+                         resolvers->next - resolvers->interval);
+
+    pool_close(&resolvers->queries);
+    topk_close(&resolvers->names);
+    topk_close(&resolvers->nxdomains);
+    topk_close(&resolvers->clients);
+    resolvers->top = 0;
+    memset(resolvers->buckets, 0, sizeof(resolvers->buckets));
+    memset(resolvers->wheel, 0, sizeof(resolvers->wheel));
+}
@@ -0,0 +1,241 @@
+#include "../include/ring.h"
+
+// set by ring_breakloop, checked by every ring_loop
+volatile sig_atomic_t ring_stop = 0;
+
+/**
+ * @brief Open an AF_PACKET socket bound to the interface and map a
+ * TPACKET_V3 block ring into our address space. The kernel fills the
+ * blocks and we read the frames straight out of them.
+ * @return 0 on success, -1 on error with errno set
+ */
+int ring_open(ring_t *ring, const char *interface,
+              unsigned int block_size, unsigned int block_nr,
+              unsigned int timeout) {
+
+    ring->fd = -1;
+    ring->map = MAP_FAILED;
+    ring->block_size = block_size;
+    ring->block_nr = block_nr;
+    ring->block = 0;
+
+    unsigned int ifindex = if_nametoindex(interface);
+    if (ifindex == 0)
+        return -1;
+
+    if ((ring->fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) ==
+        -1)
+        return -1;
+
+    int version = TPACKET_V3;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION, &version,
+                   sizeof(version)) == -1)
+        goto error;
+
+    // Blocks are retired by the kernel when full or after the timeout
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = block_size;
+    req.tp_block_nr = block_nr;
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (block_size / RING_FRAME_SIZE) * block_nr;
+    req.tp_retire_blk_tov = timeout;
+    req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req,
+                   sizeof(req)) == -1)
+        goto error;
+
+    ring->map_size = (size_t)block_size * block_nr;
+    ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, ring->fd, 0);
+    if (ring->map == MAP_FAILED)
+        goto error;
+
+    struct sockaddr_ll ll;
+    memset(&ll, 0, sizeof(ll));
+    ll.sll_family = AF_PACKET;
+    ll.sll_protocol = htons(ETH_P_ALL);
+    ll.sll_ifindex = ifindex;
+    if (bind(ring->fd, (struct sockaddr *)&ll, sizeof(ll)) == -1)
+        goto error;
+
+    // Promiscuous mode as done by pcap_open_live
+    struct packet_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.mr_ifindex = ifindex;
+    mreq.mr_type = PACKET_MR_PROMISC;
+    if (PROMISC && setsockopt(ring->fd, SOL_PACKET,
+                              PACKET_ADD_MEMBERSHIP, &mreq,
+                              sizeof(mreq)) == -1)
+        goto error;
+
+    return 0;
+
+error:
+    ring_close(ring);
+    return -1;
+}
+
+/**
+ * @brief Compile the filter with libpcap and attach it to the socket,
+ * so the kernel only copies matching frames into the ring
+ * @return 0 on success, -1 on error
+ */
+int ring_set_filter(ring_t *ring, const char *filter) {
+
+    struct bpf_program fp;
+    // the program returns the snaplen it is compiled with, the bytes
+    // of the frame kept: only the ring slot may cut the frame
+    pcap_t *dead = pcap_open_dead(DLT_EN10MB, READER_MAX_SNAPLEN);
+    if (dead == NULL)
+        return -1;
+
+    if (pcap_compile(dead, &fp, filter, 1, PCAP_NETMASK_UNKNOWN) ==
+        -1) {
+        pcap_close(dead);
+        return -1;
+    }
+
+    struct sock_fprog prog;
+    prog.len = fp.bf_len;
+    prog.filter = (struct sock_filter *)fp.bf_insns;
+
+    int ret = setsockopt(ring->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+                         sizeof(prog));
+
+    pcap_freecode(&fp);
+    pcap_close(dead);
+
+    return ret;
+}
+
+/**
+ * @brief Join the PACKET_FANOUT_HASH group, the kernel then sends all
+ * the frames of a flow to the same socket of the group
+ * @return 0 on success, -1 on error
+ */
+int ring_join_fanout(ring_t *ring, int group) {
+
+    int fanout = (group & 0xffff) |
+                 ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG)
+                  << 16);
+
+    return setsockopt(ring->fd, SOL_PACKET, PACKET_FANOUT, &fanout,
+                      sizeof(fanout));
+}
+
+/**
+ * @brief Get the number of frames received and dropped by the kernel
+ * since the last call
+ * @return 0 on success, -1 on error
+ */
+int ring_stats(ring_t *ring, unsigned long *received,
+               unsigned long *dropped) {
+
+    struct tpacket_stats_v3 stats;
+    socklen_t len = sizeof(stats);
+
+    if (getsockopt(ring->fd, SOL_PACKET, PACKET_STATISTICS, &stats,
+                   &len) == -1)
+        return -1;
+
+    *received += stats.tp_packets;
+    *dropped += stats.tp_drops;
+
+    return 0;
+}
+
+/**
+ * @brief Give every frame of a retired block to the callback. The
+ * packet pointer is inside the ring, nothing is copied. The block is
+ * ours until handed back, so its frames are decoded by batches.
+ */
+void ring_walk_block(struct tpacket_block_desc *block, batch_t *batch,
+                     pcap_handler callback, u_char *args) {
+
+    struct tpacket3_hdr *frame =
+        (struct tpacket3_hdr *)((uint8_t *)block +
+                                block->hdr.bh1.offset_to_first_pkt);
+    struct pcap_pkthdr header;
+
+    unsigned int i;
+    for (i = 0; i < block->hdr.bh1.num_pkts; i++) {
+
+        header.ts.tv_sec = frame->tp_sec;
+        header.ts.tv_usec = frame->tp_nsec / 1000;
+        header.caplen = frame->tp_snaplen;
+        header.len = frame->tp_len;
+
+        if (batch_add(batch, &header, (uint8_t *)frame + frame->tp_mac))
+            batch_run(batch, callback, args);
+
+        frame = (struct tpacket3_hdr *)((uint8_t *)frame +
+                                        frame->tp_next_offset);
+    }
+    batch_run(batch, callback, args);
+}
+
+/**
+ * @brief Wait for the blocks in order, walk them and hand them back
+ * to the kernel until ring_breakloop is called. Equivalent of
+ * pcap_loop with a count of -1. The release function, if any, is
+ * called before a block is handed back, while its frames can still
+ * be read. The flows of the frames are loaded ahead from the table of
+ * the callback, NULL if none.
+ * @return -1 if poll fails
+ */
+int ring_loop(ring_t *ring, flow_table_t *flows, pcap_handler callback,
+              void (*release)(u_char *), u_char *args) {
+
+    struct pollfd pfd;
+    batch_t batch;
+    pfd.fd = ring->fd;
+    pfd.events = POLLIN | POLLERR;
+    pfd.revents = 0;
+    batch_open(&batch, flows);
+
+    while (!ring_stop) {
+
+        struct tpacket_block_desc *block =
+            (struct tpacket_block_desc *)(ring->map +
+                                          (size_t)ring->block *
+                                              ring->block_size);
+
+        if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+            if (poll(&pfd, 1, RING_POLL_MS) == -1 && errno != EINTR)
+                return -1;
+            continue;
+        }
+
+        ring_walk_block(block, &batch, callback, args);
+        if (release != NULL)
+            release(args);
+
+        // The block goes back to the kernel once we are done with it
+        __sync_synchronize();
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        ring->block = (ring->block + 1) % ring->block_nr;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Stop every ring_loop, can be called from a signal handler
+ */
+void ring_breakloop(void) { ring_stop = 1; }
+
+/**
+ * @brief Unmap the ring and close the socket
+ */
+void ring_close(ring_t *ring) {
+
+    if (ring->map != MAP_FAILED)
+        munmap(ring->map, ring->map_size);
+    if (ring->fd != -1)
+        close(ring->fd);
+
+    ring->map = MAP_FAILED;
+    ring->fd = -1;
+}
@@ -0,0 +1,297 @@
+#include "../include/stream.h"
+
+/**
+ * @brief Prepare the reassembly of the flows of a table, whose
+ * connections are released with their flow
+ * @return 0 on success, -1 on error with errno set
+ */
+int stream_open(streams_t *streams, flow_table_t *flows,
+                uint32_t flow_max, size_t max) {
+
+    // a segment of the largest IP packet completes the bytes held
+    if ((streams->buffer = malloc(flow_max + IP_MAXPACKET)) == NULL)
+        return -1;
+
+    pool_open(&streams->segments, sizeof(segment_t),
+              max / sizeof(segment_t));
+    pool_open(&streams->connections, sizeof(connection_t), 0);
+    pool_open(&streams->messages, STREAM_MESSAGE, STREAM_MESSAGES);
+    streams->flow_max = flow_max;
+
+    flows->release = stream_release;
+    flows->args = streams;
+
+    return 0;
+}
+
+/**
+ * @brief Forget the message being framed, the bytes which follow are
+ * not framed anymore
+ */
+void stream_unframe(streams_t *streams, stream_t *stream) {
+
+    if (stream->message != NULL)
+        pool_put(&streams->messages, stream->message);
+    stream->message = NULL;
+    stream->framed = 0;
+    stream->frame_len = 0;
+    stream->lost = 1;
+}
+
+/**
+ * @brief Forget the bytes held by a direction, and the message being
+ * framed
+ */
+void stream_clear(streams_t *streams, stream_t *stream) {
+
+    segment_t *segment = stream->segments, *next;
+
+    stream_unframe(streams, stream);
+
+    while (segment != NULL) {
+        next = segment->next;
+        pool_put(&streams->segments, segment);
+        segment = next;
+    }
+
+    stream->segments = NULL;
+    stream->held = 0;
+}
+
+/**
+ * @brief Give the connection of a flow removed back to the pools
+ */
+void stream_release(flow_t *flow, void *args) {
+
+    streams_t *streams = args;
+    connection_t *connection = flow->data;
+
+    stream_clear(streams, &connection->dir[0]);
+    stream_clear(streams, &connection->dir[1]);
+    pool_put(&streams->connections, connection);
+}
+
+/**
+ * @brief Keep the bytes of a segment received ahead of the next ones.
+ * Only the gaps between the buffers are filled, the bytes already held
+ * are kept when segments overlap. A flow is charged the whole buffer
+ * of each segment, whatever the bytes it holds.
+ * @return 0 on success, -1 if the flow or the pool is full
+ */
+int stream_hold(streams_t *streams, stream_t *stream, uint32_t seq,
+                const u_char *payload, uint32_t len) {
+
+    segment_t **link = &stream->segments, *segment, *gap;
+    uint32_t start = seq, end = seq + len, stop, size;
+
+    while (SEQ_LT(seq, end)) {
+
+        while ((segment = *link) != NULL &&
+               SEQ_LEQ(segment->seq + segment->len, seq))
+            link = &segment->next;
+
+        if (segment != NULL && SEQ_LEQ(segment->seq, seq)) {
+            seq = segment->seq + segment->len;
+            link = &segment->next;
+            continue;
+        }
+
+        // the gap ends at the next buffer
+        stop = end;
+        if (segment != NULL && SEQ_LT(segment->seq, stop))
+            stop = segment->seq;
+        size = stop - seq;
+        if (size > STREAM_CHUNK)
+            size = STREAM_CHUNK;
+
+        if (stream->held + sizeof(segment_t) > streams->flow_max ||
+            (gap = pool_get(&streams->segments)) == NULL)
+            return -1;
+        gap->seq = seq;
+        gap->len = size;
+        memcpy(gap->data, payload + (seq - start), size);
+        gap->next = segment;
+        *link = gap;
+        link = &gap->next;
+
+        stream->held += sizeof(segment_t);
+        seq += size;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Deliver the bytes of the segment which comes next, and the
+ * bytes held right after it. Alone, the segment is not copied.
+ * @return the bytes in order, their number in length
+ */
+const u_char *stream_deliver(streams_t *streams, stream_t *stream,
+                             const u_char *payload, int *length) {
+
+    segment_t *segment = stream->segments;
+    uint32_t end = stream->next + *length, skip;
+
+    if (segment == NULL || SEQ_LT(end, segment->seq)) {
+        stream->next = end;
+        return payload;
+    }
+
+    memcpy(streams->buffer, payload, *length);
+
+    while ((segment = stream->segments) != NULL &&
+           SEQ_LEQ(segment->seq, end)) {
+
+        if (SEQ_LT(end, segment->seq + segment->len)) {
+            skip = end - segment->seq;
+            memcpy(streams->buffer + *length, segment->data + skip,
+                   segment->len - skip);
+            *length += segment->len - skip;
+            end = segment->seq + segment->len;
+        }
+
+        stream->segments = segment->next;
+        stream->held -= sizeof(segment_t);
+        pool_put(&streams->segments, segment);
+    }
+
+    stream->next = end;
+    return streams->buffer;
+}
+
+/**
+ * @brief Reassemble the payload of a TCP segment in its flow. A
+ * retransmission delivers only the bytes not seen yet, a segment ahead
+ * is held until the gap is filled. When a flow holds too much, or the
+ * pool is empty, the bytes missing are given up.
+ * @return the bytes which come next in the stream, their number in
+ * length, 0 if none
+ */
+const u_char *stream_segment(packet_t *pkt, const u_char *payload,
+                             int *length) {
+
+    streams_t *streams = pkt->ctx->streams;
+    flow_t *flow = pkt->flow;
+    connection_t *connection;
+    stream_t *stream, *peer;
+    uint32_t seq = pkt->tcp_seq, end;
+    int len;
+
+    if (streams == NULL || flow == NULL)
+        return payload;
+
+    if (flow->data == NULL) {
+        if ((flow->data = pool_get(&streams->connections)) == NULL)
+            return payload;
+        memset(flow->data, 0, sizeof(connection_t));
+    }
+    connection = flow->data;
+    stream = &connection->dir[pkt->flow_dir];
+    peer = &connection->dir[!pkt->flow_dir];
+
+    if (pkt->tcp_flags & TH_ACK) {
+        if (!peer->ack || SEQ_LT(peer->acked, pkt->tcp_ack))
+            peer->acked = pkt->tcp_ack;
+        peer->ack = 1;
+    }
+
+    if (pkt->tcp_flags & TH_RST) {
+        stream_clear(streams, &connection->dir[0]);
+        stream_clear(streams, &connection->dir[1]);
+        return payload;
+    }
+
+    // a new SYN starts the stream again
+    if (pkt->tcp_flags & TH_SYN) {
+        seq++;
+        if (!stream->init || seq != stream->next) {
+            stream_clear(streams, stream);
+            stream->next = seq;
+            stream->init = 1;
+            stream->lost = 0;
+        }
+    } else if (!stream->init) {
+        stream->next = seq;
+        stream->init = 1;
+    }
+
+    // bytes of the segment, without the padding of the frame
+    len = frag_len(pkt) - pkt->tcp_off * 4;
+    if (len < 0 || len > *length) {
+        // bytes out of the stream, the messages cannot be found anymore
+        stream_unframe(streams, stream);
+        return payload;
+    }
+    end = seq + len;
+
+    // truncated by the capture, the bytes are lost
+    if (payload + len > pkt->data + pkt->caplen) {
+        stream_clear(streams, stream);
+        stream->next = end;
+        return payload;
+    }
+
+    if (SEQ_LT(stream->next, end)) {
+
+        if (SEQ_LT(seq, stream->next)) {
+            payload += stream->next - seq;
+            len -= stream->next - seq;
+            seq = stream->next;
+        }
+
+        // a segment ahead without bytes, an ACK or a FIN, holds nothing
+        if (seq != stream->next && len != 0) {
+            if ((int32_t)(seq - stream->next) < STREAM_WINDOW &&
+                stream_hold(streams, stream, seq, payload, len) == 0) {
+                len = 0;
+                // the other endpoint received the bytes of the gap,
+                // missed by the capture they will never come again
+                if (stream->ack &&
+                    SEQ_LT(stream->next, stream->acked) &&
+                    SEQ_LEQ(stream->segments->seq, stream->acked)) {
+                    stream->next = stream->segments->seq;
+                    stream_unframe(streams, stream);
+                }
+            } else {
+                stream_clear(streams, stream);
+                stream->next = seq;
+            }
+        }
+
+        payload = stream_deliver(streams, stream, payload, &len);
+    } else
+        len = 0;
+
+    if ((pkt->tcp_flags & TH_FIN) && stream->next == end)
+        stream->next++;
+
+    *length = len;
+    return payload;
+}
+
+/**
+ * @brief Direction of the stream of a segment, once reassembled
+ * @return the direction, NULL if the flow is not reassembled
+ */
+stream_t *stream_direction(const packet_t *pkt) {
+
+    connection_t *connection;
+
+    if (pkt->ctx->streams == NULL || pkt->flow == NULL ||
+        (connection = pkt->flow->data) == NULL)
+        return NULL;
+
+    return &connection->dir[pkt->flow_dir];
+}
+
+/**
+ * @brief Free the pools, once the flow table is closed
+ */
+void stream_close(streams_t *streams) {
+
+    pool_close(&streams->segments);
+    pool_close(&streams->connections);
+    pool_close(&streams->messages);
+    free(streams->buffer);
+    streams->buffer = NULL;
+}
@@ -0,0 +1,326 @@
+#include "../include/topk.h"
+
+/**
+ * @brief Allocate the counters of the sketch, nothing more is
+ * allocated afterwards whatever the number of keys counted
+ * @return 0 on success, -1 on error with errno set
+ */
+int topk_open(topk_t *topk, uint32_t capacity) {
+
+    uint32_t size = 1;
+
+    while (size < 2 * capacity)
+        size <<= 1;
+
+    memset(topk, 0, sizeof(topk_t));
+    topk->entries = malloc(capacity * sizeof(topk_entry_t));
+    topk->heap = malloc(capacity * sizeof(uint32_t));
+    topk->index = malloc(size * sizeof(uint32_t));
+    topk->sorted = malloc(capacity * sizeof(topk_entry_t *));
+    if (topk->entries == NULL || topk->heap == NULL ||
+        topk->index == NULL || topk->sorted == NULL) {
+        topk_close(topk);
+        return -1;
+    }
+
+    topk->mask = size - 1;
+    topk->capacity = capacity;
+    topk_clear(topk);
+
+    return 0;
+}
+
+/**
+ * @brief FNV-1a of the key
+ */
+uint32_t topk_hash(const u_char *key, uint16_t len) {
+
+    uint32_t hash = 0x811c9dc5;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ key[i]) * 0x01000193;
+
+    return hash;
+}
+
+/**
+ * @brief Slot of the index holding the key, or the free slot ending
+ * its probe
+ */
+uint32_t topk_find(const topk_t *topk, const u_char *key, uint16_t len,
+                   uint32_t hash) {
+
+    const topk_entry_t *entry;
+    uint32_t slot = hash & topk->mask;
+
+    while (topk->index[slot] != TOPK_NONE) {
+        entry = &topk->entries[topk->index[slot]];
+        if (entry->hash == hash && entry->len == len &&
+            memcmp(entry->key, key, len) == 0)
+            break;
+        slot = (slot + 1) & topk->mask;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Exchange two positions of the heap
+ */
+void topk_swap(topk_t *topk, uint32_t a, uint32_t b) {
+
+    uint32_t entry = topk->heap[a];
+
+    topk->heap[a] = topk->heap[b];
+    topk->heap[b] = entry;
+    topk->entries[topk->heap[a]].heap = a;
+    topk->entries[topk->heap[b]].heap = b;
+}
+
+/**
+ * @brief Move an entry toward the top while it is counted less than
+ * its parent
+ */
+void topk_up(topk_t *topk, uint32_t pos) {
+
+    uint32_t parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (topk->entries[topk->heap[parent]].count <=
+            topk->entries[topk->heap[pos]].count)
+            return;
+        topk_swap(topk, pos, parent);
+        pos = parent;
+    }
+}
+
+/**
+ * @brief Move an entry away from the top while one of its children is
+ * counted less
+ */
+void topk_down(topk_t *topk, uint32_t pos) {
+
+    uint32_t child, least;
+
+    for (;;) {
+        least = pos;
+        child = 2 * pos + 1;
+        if (child < topk->used &&
+            topk->entries[topk->heap[child]].count <
+                topk->entries[topk->heap[least]].count)
+            least = child;
+        child++;
+        if (child < topk->used &&
+            topk->entries[topk->heap[child]].count <
+                topk->entries[topk->heap[least]].count)
+            least = child;
+        if (least == pos)
+            return;
+        topk_swap(topk, pos, least);
+        pos = least;
+    }
+}
+
+/**
+ * @brief Remove the key of an entry from the index. The keys after it
+ * in the probe are moved back, so no slot is ever marked deleted.
+ */
+void topk_unlink(topk_t *topk, uint32_t entry) {
+
+    const topk_entry_t *old = &topk->entries[entry];
+    uint32_t hole = topk_find(topk, old->key, old->len, old->hash);
+    uint32_t slot = hole, home;
+
+    for (;;) {
+        slot = (slot + 1) & topk->mask;
+        if (topk->index[slot] == TOPK_NONE)
+            break;
+        // a key may fill the hole if it does not probe past it
+        home = topk->entries[topk->index[slot]].hash & topk->mask;
+        if (((slot - home) & topk->mask) >=
+            ((slot - hole) & topk->mask)) {
+            topk->index[hole] = topk->index[slot];
+            hole = slot;
+        }
+    }
+
+    topk->index[hole] = TOPK_NONE;
+}
+
+/**
+ * @brief Put the key of an entry in the index
+ */
+void topk_link(topk_t *topk, uint32_t entry) {
+
+    const topk_entry_t *new = &topk->entries[entry];
+
+    topk->index[topk_find(topk, new->key, new->len, new->hash)] = entry;
+}
+
+/**
+ * @brief Count a key seen once
+ */
+void topk_add(topk_t *topk, const u_char *key, uint16_t len) {
+
+    topk->total++;
+    topk_insert(topk, key, len, 1, 0);
+}
+
+/**
+ * @brief Add a count to a key, with the part of it which may belong
+ * to other keys. A key not counted yet takes a free counter, or the
+ * one of the least counted key whose count it inherits.
+ */
+void topk_insert(topk_t *topk, const u_char *key, uint16_t len,
+                 unsigned long count, unsigned long error) {
+
+    uint32_t hash, slot, entry;
+    topk_entry_t *top;
+
+    if (len > TOPK_KEY)
+        len = TOPK_KEY;
+
+    hash = topk_hash(key, len);
+    slot = topk_find(topk, key, len, hash);
+
+    if (topk->index[slot] != TOPK_NONE) {
+        entry = topk->index[slot];
+        topk->entries[entry].count += count;
+        topk->entries[entry].error += error;
+        topk_down(topk, topk->entries[entry].heap);
+        return;
+    }
+
+    if (topk->used < topk->capacity) {
+        entry = topk->used++;
+        top = &topk->entries[entry];
+        top->count = count;
+        top->error = error;
+        top->heap = entry;
+        topk->heap[entry] = entry;
+        topk_up(topk, entry);
+    } else {
+        entry = topk->heap[0];
+        top = &topk->entries[entry];
+        topk_unlink(topk, entry);
+        top->error = top->count + error;
+        top->count += count;
+    }
+
+    top->hash = hash;
+    top->len = len;
+    memcpy(top->key, key, len);
+    topk_link(topk, entry);
+    topk_down(topk, top->heap);
+}
+
+/**
+ * @brief Add the keys counted by another sketch, as if they had been
+ * counted by this one
+ */
+void topk_merge(topk_t *dst, const topk_t *src) {
+
+    uint32_t i;
+
+    for (i = 0; i < src->used; i++)
+        topk_insert(dst, src->entries[i].key, src->entries[i].len,
+                    src->entries[i].count, src->entries[i].error);
+    dst->total += src->total;
+}
+
+/**
+ * @brief Write the keys counted to a file, for another process to
+ * merge them
+ * @return 0 on success, -1 on error
+ */
+int topk_save(const topk_t *topk, FILE *file) {
+
+    if (fwrite(&topk->total, sizeof(topk->total), 1, file) != 1 ||
+        fwrite(&topk->used, sizeof(topk->used), 1, file) != 1 ||
+        fwrite(topk->entries, sizeof(topk_entry_t), topk->used,
+               file) != topk->used)
+        return -1;
+
+    return 0;
+}
+
+/**
+ * @brief Merge the keys written by topk_save
+ * @return 0 on success, -1 on error
+ */
+int topk_load(topk_t *topk, FILE *file) {
+
+    topk_entry_t entry;
+    unsigned long total;
+    uint32_t used, i;
+
+    if (fread(&total, sizeof(total), 1, file) != 1 ||
+        fread(&used, sizeof(used), 1, file) != 1)
+        return -1;
+
+    for (i = 0; i < used; i++) {
+        if (fread(&entry, sizeof(entry), 1, file) != 1 ||
+            entry.len > TOPK_KEY)
+            return -1;
+        topk_insert(topk, entry.key, entry.len, entry.count,
+                    entry.error);
+    }
+    topk->total += total;
+
+    return 0;
+}
+
+/**
+ * @brief Order of the entries printed, the most counted first
+ */
+int topk_compare(const void *a, const void *b) {
+
+    const topk_entry_t *x = *(const topk_entry_t *const *)a;
+    const topk_entry_t *y = *(const topk_entry_t *const *)b;
+
+    return (x->count < y->count) - (x->count > y->count);
+}
+
+/**
+ * @brief Sort the entries, the k first ones are the most counted
+ * @return number of entries to print, less than k if fewer keys were
+ * counted
+ */
+uint32_t topk_sort(topk_t *topk, uint32_t k) {
+
+    uint32_t i;
+
+    for (i = 0; i < topk->used; i++)
+        topk->sorted[i] = &topk->entries[i];
+    qsort(topk->sorted, topk->used, sizeof(*topk->sorted),
+          topk_compare);
+
+    return topk->used < k ? topk->used : k;
+}
+
+/**
+ * @brief Forget every key counted
+ */
+void topk_clear(topk_t *topk) {
+
+    memset(topk->index, 0xff, (topk->mask + 1) * sizeof(uint32_t));
+    topk->used = 0;
+    topk->total = 0;
+}
+
+/**
+ * @brief Free the counters
+ */
+void topk_close(topk_t *topk) {
+
+    free(topk->entries);
+    free(topk->heap);
+    free(topk->index);
+    free(topk->sorted);
+    topk->entries = NULL;
+    topk->heap = NULL;
+    topk->index = NULL;
+    topk->sorted = NULL;
+}
@@ -0,0 +1,468 @@
+#include "../include/tunnel.h"
+
+/**
+ * @brief Bytes of the header both received and captured
+ */
+int tunnel_room(const packet_t *pkt, const u_char *packet, int length) {
+
+    int captured = pkt->data + pkt->caplen - packet;
+
+    return length < captured ? length : captured;
+}
+
+/**
+ * @brief Record a header peeled on the tunnel stack, the decapsulation
+ * keeps the depth below tunnel_max
+ */
+void tunnel_push(packet_t *pkt, uint8_t type, uint32_t id,
+                 uint16_t proto) {
+
+    tunnel_t *tunnel = &pkt->tunnels[pkt->tunnel_depth++];
+
+    tunnel->id = id;
+    tunnel->proto = proto;
+    tunnel->type = type;
+}
+
+/**
+ * @brief Print the addresses of the last IP header of a tunnel, on the
+ * line of a frame whose inner header is not analyzed
+ */
+void tunnel_print_ip(const packet_t *pkt, int verbose) {
+
+    if (pkt->ip_version == 4)
+        ip_print(pkt, verbose);
+    else
+        ipv6_print(pkt, verbose);
+}
+
+/**
+ * @brief Peel a 802.1Q or 802.1ad tag
+ * @return bytes of the tag, -1 if it is truncated
+ */
+int tunnel_vlan(packet_t *pkt, const u_char *packet, int length,
+                int verbose) {
+
+    const struct vlan_hdr *vlan = (const struct vlan_hdr *)packet;
+    uint16_t tci, type;
+
+    if (tunnel_room(pkt, packet, length) < (int)sizeof(struct vlan_hdr))
+        return -1;
+
+    tci = ntohs(vlan->tci);
+    type = ntohs(vlan->type);
+    tunnel_push(pkt, TUNNEL_VLAN, tci & 0x0fff, type);
+
+    // One line from the tag
+    PRV2(output_printf(YEL "VLAN" NC "\t\tId : %d, Priority : %d, "
+                                     "Type : 0x%04x\n",
+                       tci & 0x0fff, tci >> 13, type),
+         verbose);
+
+    // Multiple lines from the tag
+    PRV3(output_printf("\n" GRN "VLAN Tag" NC "\n"
+                       "TPID : 0x%04x\n"
+                       "Priority : %d\n"
+                       "Drop eligible : %d\n"
+                       "Id : %d\n"
+                       "Type : 0x%04x\n",
+                       pkt->ether_type, tci >> 13, (tci >> 12) & 1,
+                       tci & 0x0fff, type),
+         verbose);
+
+    pkt->ether_type = type;
+    return sizeof(struct vlan_hdr);
+}
+
+/**
+ * @brief Peel a MPLS label. The protocol under the bottom of the stack
+ * is not given, it is guessed from the version of an IP header.
+ * @return bytes of the label, -1 if it is truncated or if the protocol
+ * under the stack is not IP
+ */
+int tunnel_mpls(packet_t *pkt, const u_char *packet, int length,
+                int verbose) {
+
+    uint32_t entry;
+    uint16_t type = pkt->ether_type;
+    int room = tunnel_room(pkt, packet, length);
+
+    if (room < 4)
+        return -1;
+    memcpy(&entry, packet, sizeof(entry));
+    entry = ntohl(entry);
+
+    // bottom of the stack
+    if (entry & 0x100) {
+        if (room < 5)
+            return -1;
+        switch (packet[4] >> 4) {
+        case 4:
+            type = ETHERTYPE_IP;
+            break;
+        case 6:
+            type = ETHERTYPE_IPV6;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    tunnel_push(pkt, TUNNEL_MPLS, entry >> 12, type);
+
+    // One line by label
+    PRV2(output_printf(YEL "MPLS" NC "\t\tLabel : %u, TTL : %u\n",
+                       entry >> 12, entry & 0xff),
+         verbose);
+
+    // Multiple lines by label
+    PRV3(output_printf("\n" GRN "MPLS Label" NC "\n"
+                       "Label : %u\n"
+                       "Traffic class : %u\n"
+                       "Bottom of stack : %u\n"
+                       "Time to live : %u\n",
+                       entry >> 12, (entry >> 9) & 7, (entry >> 8) & 1,
+                       entry & 0xff),
+         verbose);
+
+    pkt->ether_type = type;
+    return 4;
+}
+
+/**
+ * @brief Peel the Ethernet header of a frame bridged by GRE, the inner
+ * addresses replace the outer ones
+ * @return bytes of the header, -1 if it is truncated
+ */
+int tunnel_ethernet(packet_t *pkt, const u_char *packet, int length,
+                    int verbose) {
+
+    if (tunnel_room(pkt, packet, length) <
+        (int)sizeof(struct ether_header))
+        return -1;
+
+    ethernet_analyzer(pkt, packet, verbose == 1 ? 0 : verbose);
+    return sizeof(struct ether_header);
+}
+
+/**
+ * @brief Peel the PPP header of a PPTP session, with or without the
+ * address and control fields and with a protocol compressed or not
+ * @return bytes of the header, -1 if it is truncated or if it does
+ * not carry IP
+ */
+int tunnel_ppp(packet_t *pkt, const u_char *packet, int length,
+               int verbose) {
+
+    int room = tunnel_room(pkt, packet, length), size = 0;
+    uint16_t proto, type;
+
+    if (room >= 2 && packet[0] == PPP_ADDRESS &&
+        packet[1] == PPP_CONTROL)
+        size = 2;
+
+    // a protocol whose first byte is odd is compressed to that byte
+    if (room < size + 1)
+        return -1;
+    if (packet[size] & 1) {
+        proto = packet[size];
+        size += 1;
+    } else {
+        if (room < size + 2)
+            return -1;
+        proto = packet[size] << 8 | packet[size + 1];
+        size += 2;
+    }
+
+    switch (proto) {
+    case PPP_IP:
+        type = ETHERTYPE_IP;
+        break;
+    case PPP_IPV6:
+        type = ETHERTYPE_IPV6;
+        break;
+    default:
+        return -1;
+    }
+
+    tunnel_push(pkt, TUNNEL_PPP, proto, type);
+
+    PRV2(output_printf(YEL "PPP" NC "\t\tProtocol : 0x%04x\n", proto),
+         verbose);
+    PRV3(output_printf("\n" GRN "PPP Header" NC "\n"
+                       "Protocol : 0x%04x\n",
+                       proto),
+         verbose);
+
+    pkt->ether_type = type;
+    return size;
+}
+
+/**
+ * @brief Peel a GRE header, of version 0 or of the enhanced version 1
+ * of PPTP, whose key holds the call id
+ * @return bytes of the header, -1 if it is truncated or routed
+ */
+int tunnel_gre(packet_t *pkt, const u_char *packet, int length,
+               int verbose) {
+
+    const struct gre_hdr *gre = (const struct gre_hdr *)packet;
+    int size = sizeof(struct gre_hdr), room;
+    uint16_t flags, type;
+    uint32_t key = 0;
+
+    room = tunnel_room(pkt, packet, length);
+    if (room < size)
+        return -1;
+    flags = ntohs(gre->flags);
+    type = ntohs(gre->type);
+
+    switch (flags & GRE_VERSION) {
+    case 0:
+        if (flags & GRE_ROUTING)
+            return -1;
+        if (flags & GRE_CHECKSUM)
+            size += 4;
+        break;
+    case 1:
+        if (!(flags & GRE_KEY) || type != ETHERTYPE_PPP)
+            return -1;
+        break;
+    default:
+        return -1;
+    }
+
+    if (flags & GRE_KEY) {
+        if (room < size + 4)
+            return -1;
+        memcpy(&key, packet + size, sizeof(key));
+        key = ntohl(key);
+        // payload length and call id
+        if ((flags & GRE_VERSION) == 1)
+            key &= 0xffff;
+        size += 4;
+    }
+    if (flags & GRE_SEQ)
+        size += 4;
+    if ((flags & GRE_VERSION) == 1 && (flags & GRE_ACK))
+        size += 4;
+    if (room < size)
+        return -1;
+
+    tunnel_push(pkt, TUNNEL_GRE, key, type);
+
+    // One line from the GRE header
+    PRV2(output_printf(YEL "GRE" NC "\t\tVersion : %d, Type : 0x%04x, "
+                                    "Key : %u\n",
+                       flags & GRE_VERSION, type, key),
+         verbose);
+
+    // Multiple lines from the GRE header
+    PRV3(output_printf("\n" GRN "GRE Header" NC "\n"
+                       "Flags : 0x%04x\n"
+                       "Version : %d\n"
+                       "Type : 0x%04x\n"
+                       "Key : %u\n"
+                       "Length : %d\n",
+                       flags & ~GRE_VERSION, flags & GRE_VERSION, type,
+                       key, size),
+         verbose);
+
+    pkt->ether_type = type;
+    return size;
+}
+
+/**
+ * @brief Entries of the tunnel stack needed to peel an IP header
+ * carrying this protocol
+ * @return 0 if the protocol is not a tunnel
+ */
+int tunnel_size(uint8_t proto) {
+
+    switch (proto) {
+    case IPPROTO_IPIP:
+    case IPPROTO_IPV6:
+        return 1;
+    case IPPROTO_GRE:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Peel the payload of an IP header already analyzed, and the
+ * GRE header it may start with
+ * @return 1 once peeled, -1 if it is a fragment waiting for the
+ * others or if its GRE header cannot be peeled, the frame is then
+ * printed up to there
+ */
+int tunnel_carry(packet_t *pkt, const u_char **packet, int *length,
+                 const u_char *payload, int len, int verbose) {
+
+    int size;
+
+    if (payload == NULL) {
+        PRV1(tunnel_print_ip(pkt, verbose), verbose);
+        frag_print(pkt, verbose);
+        return -1;
+    }
+
+    tunnel_push(pkt, pkt->ip_version == 4 ? TUNNEL_IPV4 : TUNNEL_IPV6,
+                0, pkt->ip_proto);
+
+    switch (pkt->ip_proto) {
+    case IPPROTO_IPIP:
+        pkt->ether_type = ETHERTYPE_IP;
+        break;
+    case IPPROTO_IPV6:
+        pkt->ether_type = ETHERTYPE_IPV6;
+        break;
+    case IPPROTO_GRE:
+        if ((size = tunnel_gre(pkt, payload, len, verbose)) < 0) {
+            PRV1(tunnel_print_ip(pkt, verbose), verbose);
+            PRV1(output_str("-\t\t\tGRE"), verbose);
+            return -1;
+        }
+        payload += size;
+        len -= size;
+        break;
+    }
+
+    *packet = payload;
+    *length = len;
+    return 1;
+}
+
+/**
+ * @brief Peel an IPv4 header carrying a tunnel, once all the fragments
+ * of its datagram are received. At verbosity 1 the line of the frame
+ * shows the inner header.
+ * @return 1 once peeled, 0 if it does not carry a tunnel, -1 if the
+ * rest of the frame is not known
+ */
+int tunnel_ip(packet_t *pkt, const u_char **packet, int *length,
+              int verbose) {
+
+    const struct iphdr *ip = (const struct iphdr *)*packet;
+    const u_char *payload;
+    int room = tunnel_room(pkt, *packet, *length), size, len;
+
+    if (room < (int)sizeof(struct iphdr) || room < ip->ihl * 4 ||
+        (size = tunnel_size(ip->protocol)) == 0 ||
+        pkt->tunnel_depth + size > pkt->ctx->tunnel_max)
+        return 0;
+
+    ip_analyzer(pkt, *packet, verbose == 1 ? 0 : verbose);
+    len = *length - pkt->ip_hdr_len;
+    payload = ip_payload(pkt, *packet + pkt->ip_hdr_len, &len);
+
+    return tunnel_carry(pkt, packet, length, payload, len, verbose);
+}
+
+/**
+ * @brief Peel an IPv6 header carrying a tunnel behind its extension
+ * headers, once all the fragments of its datagram are received
+ * @return 1 once peeled, 0 if it does not carry a tunnel, -1 if the
+ * rest of the frame is not known
+ */
+int tunnel_ipv6(packet_t *pkt, const u_char **packet, int *length,
+                int verbose) {
+
+    const struct ip6_hdr *ip6 = (const struct ip6_hdr *)*packet;
+    const u_char *payload;
+    int size, len;
+
+    if (tunnel_room(pkt, *packet, *length) < (int)sizeof(*ip6))
+        return 0;
+
+    // the protocol is looked for behind the extension headers only
+    // when there are some
+    switch (ip6->ip6_nxt) {
+    case IPPROTO_HOPOPTS:
+    case IPPROTO_ROUTING:
+    case IPPROTO_DSTOPTS:
+    case IPPROTO_AH:
+    case IPPROTO_FRAGMENT:
+        ipv6_decode(pkt, *packet);
+        if (ipv6_walk(pkt, *packet + sizeof(*ip6),
+                      *length - sizeof(*ip6)) < 0)
+            return 0;
+        size = tunnel_size(pkt->ip_proto);
+        break;
+    default:
+        size = tunnel_size(ip6->ip6_nxt);
+        break;
+    }
+    if (size == 0 || pkt->tunnel_depth + size > pkt->ctx->tunnel_max)
+        return 0;
+
+    ipv6_analyzer(pkt, *packet, verbose == 1 ? 0 : verbose);
+    len = *length - sizeof(*ip6);
+    payload = ipv6_payload(pkt, *packet + sizeof(*ip6), &len, verbose);
+
+    return tunnel_carry(pkt, packet, length, payload, len, verbose);
+}
+
+/**
+ * @brief Peel the tags, the labels and the tunnels in front of the
+ * network protocol of the frame, in one pass from the outermost one,
+ * and record them on the tunnel stack. Past tunnel_max headers the
+ * next one is left to the dissection, which only shows its label.
+ * @return the network header, whose ethertype is in ether_type, NULL
+ * if the rest of the frame is not known and was printed
+ */
+const u_char *tunnel_decap(packet_t *pkt, const u_char *packet,
+                           int *length, int verbose) {
+
+    int size;
+
+    while (pkt->tunnel_depth < pkt->ctx->tunnel_max) {
+
+        switch (pkt->ether_type) {
+
+        case ETHERTYPE_VLAN:
+        case ETHERTYPE_QINQ:
+        case ETHERTYPE_QINQ_OLD:
+            size = tunnel_vlan(pkt, packet, *length, verbose);
+            break;
+
+        case ETHERTYPE_MPLS:
+        case ETHERTYPE_MPLS_MULTI:
+            size = tunnel_mpls(pkt, packet, *length, verbose);
+            break;
+
+        case ETHERTYPE_TEB:
+            size = tunnel_ethernet(pkt, packet, *length, verbose);
+            break;
+
+        case ETHERTYPE_PPP:
+            size = tunnel_ppp(pkt, packet, *length, verbose);
+            break;
+
+        // the header is analyzed by the dissection if it is not a
+        // tunnel, the packet is left as it is
+        case ETHERTYPE_IP:
+            size = tunnel_ip(pkt, &packet, length, verbose);
+            if (size <= 0)
+                return size == 0 ? packet : NULL;
+            continue;
+
+        case ETHERTYPE_IPV6:
+            size = tunnel_ipv6(pkt, &packet, length, verbose);
+            if (size <= 0)
+                return size == 0 ? packet : NULL;
+            continue;
+
+        default:
+            return packet;
+        }
+
+        if (size < 0)
+            return packet;
+        packet += size;
+        *length -= size;
+    }
+
+    return packet;
+}
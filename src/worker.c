@@ -0,0 +1,367 @@
+#include "../include/worker.h"
+
+/**
+ * @brief Open one ring by worker, all in the same fanout group so the
+ * kernel keeps each flow on one worker
+ * @return 0 on success, -1 on error with errno set
+ */
+int open_workers(worker_t *workers, int nb_workers, usage_t *usage,
+                 int verbose, pcap_handler callback) {
+
+    int i, group = getpid() & 0xffff;
+
+    for (i = 0; i < nb_workers; i++) {
+
+        init_context(&workers[i].ctx, verbose);
+        workers[i].ctx.registry = &usage->registry;
+        workers[i].ctx.tunnel_max = usage->tunnel_max;
+        workers[i].callback = callback;
+        output_open(&workers[i].sink, usage->output_batch);
+        workers[i].ctx.output = &workers[i].sink;
+        workers[i].output = NULL;
+
+        if (ring_open(&workers[i].ring, usage->interface,
+                      usage->block_size, usage->block_nr,
+                      usage->block_timeout) == -1)
+            goto error;
+
+        if ((usage->filter != NULL &&
+             ring_set_filter(&workers[i].ring, usage->filter) == -1) ||
+            ring_join_fanout(&workers[i].ring, group) == -1) {
+            ring_close(&workers[i].ring);
+            goto error;
+        }
+
+        // the fanout keeps both directions of a flow on one worker
+        if (usage->flows != 0) {
+            if (flow_open(&workers[i].flows, usage->flows,
+                          FLOW_TIMEOUT) == -1) {
+                ring_close(&workers[i].ring);
+                goto error;
+            }
+            workers[i].ctx.flows = &workers[i].flows;
+            if (usage->stream_max != 0) {
+                if (stream_open(&workers[i].streams,
+                                &workers[i].flows,
+                                usage->stream_flow_max,
+                                usage->stream_max) == -1) {
+                    ring_close(&workers[i].ring);
+                    close_flows(&workers[i].ctx);
+                    goto error;
+                }
+                workers[i].ctx.streams = &workers[i].streams;
+            }
+        }
+
+        if (usage->dns_interval >= 0) {
+            if (resolver_open(&workers[i].resolvers,
+                              usage->dns_interval, RESOLVER_QUERIES,
+                              usage->dns_top) == -1) {
+                ring_close(&workers[i].ring);
+                close_flows(&workers[i].ctx);
+                goto error;
+            }
+            workers[i].ctx.resolvers = &workers[i].resolvers;
+        }
+    }
+
+    return 0;
+
+error:
+    while (--i >= 0) {
+        ring_close(&workers[i].ring);
+        close_flows(&workers[i].ctx);
+        close_resolvers(&workers[i].ctx);
+    }
+    return -1;
+}
+
+/**
+ * @brief Give the frame to the analyzers with the context of the
+ * worker. Output of a frame is written in one piece by the analyzers.
+ */
+void worker_packet(u_char *args, const struct pcap_pkthdr *header,
+                   const u_char *packet) {
+
+    worker_t *worker = (worker_t *)args;
+
+    worker->callback((u_char *)&worker->ctx, header, packet);
+}
+
+/**
+ * @brief Save the frames of a block before the kernel reuses it
+ */
+void worker_release(u_char *args) {
+
+    worker_t *worker = (worker_t *)args;
+
+    if (worker->ctx.dump != NULL)
+        CHK(dump_flush(worker->ctx.dump));
+}
+
+/**
+ * @brief Capture loop of a worker, ends with ring_breakloop
+ */
+void *worker_routine(void *args) {
+
+    worker_t *worker = (worker_t *)args;
+
+    output_select(worker->ctx.output);
+    output_attach(worker->output);
+
+    if (ring_loop(&worker->ring, worker->ctx.flows, worker_packet,
+                  worker_release, (u_char *)worker) == -1)
+        perror("ring_loop");
+
+    // frames still buffered by the thread
+    output_free();
+
+    return NULL;
+}
+
+/**
+ * @brief Launch one thread by worker
+ * @return 0 on success, an error number otherwise
+ */
+int start_workers(worker_t *workers, int nb_workers) {
+
+    int i, ret;
+    for (i = 0; i < nb_workers; i++)
+        if ((ret = pthread_create(&workers[i].thread, NULL,
+                                  worker_routine, &workers[i])) != 0)
+            return ret;
+
+    return 0;
+}
+
+/**
+ * @brief Wait for the workers, close their ring and merge their
+ * counters into the total
+ */
+void join_workers(worker_t *workers, int nb_workers,
+                  context_t *total) {
+
+    int i;
+    char name[32];
+
+    for (i = 0; i < nb_workers; i++) {
+
+        pthread_join(workers[i].thread, NULL);
+
+        ring_stats(&workers[i].ring, &workers[i].ctx.received,
+                   &workers[i].ctx.dropped);
+        ring_close(&workers[i].ring);
+        close_flows(&workers[i].ctx);
+        if (total->resolvers != NULL &&
+            workers[i].ctx.resolvers != NULL)
+            resolver_merge(total->resolvers, workers[i].ctx.resolvers);
+        close_resolvers(&workers[i].ctx);
+
+        snprintf(name, sizeof(name), "Worker %d", i);
+        print_context(&workers[i].ctx, name);
+        merge_context(total, &workers[i].ctx);
+    }
+}
+
+/**
+ * @brief Analyze one chunk of the file in a child process. The records
+ * are counted first, and once every chunk is counted the frames are
+ * numbered from the total of the chunks before. The frames saved go
+ * in their own file too, and so do the top names and clients.
+ */
+void analyze_chunk(reader_t *reader, chunks_t *chunks, size_t *bounds,
+                   int chunk, FILE *output, FILE *frames, FILE *tops,
+                   const context_t *total, pcap_handler callback) {
+
+    reader_t part;
+    struct pcap_pkthdr header;
+    const u_char *packet;
+    unsigned long count = 0;
+
+    reader_chunk(reader, &part, bounds[chunk], bounds[chunk + 1]);
+    while (reader_next(&part, &header, &packet) == 1)
+        count++;
+    chunks->counts[chunk] = count;
+
+    pthread_barrier_wait(&chunks->barrier);
+
+    context_t ctx;
+    dump_t dump;
+    init_context(&ctx, total->verbose);
+
+    // the empty table of the parent is a copy of its own
+    ctx.flows = total->flows;
+    ctx.streams = total->streams;
+    ctx.frags = total->frags;
+    ctx.resolvers = total->resolvers;
+    ctx.registry = total->registry;
+    ctx.tunnel_max = total->tunnel_max;
+
+    // the sink of the parent holds the text written before the fork
+    output_t sink;
+    output_open(&sink, total->output->batch);
+    ctx.output = &sink;
+    output_select(&sink);
+
+    if (frames != NULL) {
+        dump_share(&dump, fileno(frames));
+        ctx.dump = &dump;
+    }
+
+    int i;
+    for (i = 0; i < chunk; i++)
+        ctx.count += chunks->counts[i];
+
+    // the frames of the chunk are written in its own file
+    if (output != NULL)
+        CHK(dup2(fileno(output), STDOUT_FILENO));
+
+    reader_chunk(reader, &part, bounds[chunk], bounds[chunk + 1]);
+    batch_loop(&part, ctx.flows, callback, (u_char *)&ctx);
+
+    if (ctx.dump != NULL)
+        CHK(dump_flush(ctx.dump));
+    output_free();
+    fflush(stdout);
+    close_flows(&ctx);
+    close_frags(&ctx);
+    if (tops != NULL)
+        CHK(resolver_save(ctx.resolvers, tops));
+    close_resolvers(&ctx);
+
+    // only the frames of the chunk are added to the total
+    ctx.count = count;
+    ctx.dump = NULL;
+    chunks->ctxs[chunk] = ctx;
+}
+
+/**
+ * @brief Append the output of a chunk to stdout
+ * @return 0 on success, -1 on error
+ */
+int copy_output(FILE *output) {
+
+    char buf[1 << 16];
+    size_t n;
+
+    rewind(output);
+    while ((n = fread(buf, 1, sizeof(buf), output)) > 0)
+        if (fwrite(buf, 1, n, stdout) != n)
+            return -1;
+
+    return ferror(output) ? -1 : 0;
+}
+
+/**
+ * @brief Split a classic pcap file in one chunk by worker and analyze
+ * the chunks in parallel. Every worker is a process sharing the
+ * mapping of the file, with its own state and its own output, and the
+ * outputs and the frames saved are put back in the order of the
+ * frames.
+ * @return 0 on success, -1 on error with errno set
+ */
+int analyze_chunks(reader_t *reader, int nb_workers, context_t *total,
+                   pcap_handler callback) {
+
+    int i, ret = -1, status, verbose = total->verbose, barrier = 0;
+    int error;
+    size_t *bounds;
+    FILE **outputs, **frames, **tops;
+    pid_t *pids;
+
+    if ((bounds = malloc((nb_workers + 1) * sizeof(size_t))) == NULL)
+        return -1;
+    outputs = calloc(nb_workers, sizeof(FILE *));
+    frames = calloc(nb_workers, sizeof(FILE *));
+    tops = calloc(nb_workers, sizeof(FILE *));
+    pids = calloc(nb_workers, sizeof(pid_t));
+
+    size_t size = sizeof(chunks_t) + nb_workers * sizeof(context_t) +
+                  nb_workers * sizeof(unsigned long);
+    chunks_t *chunks = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (chunks != MAP_FAILED)
+        chunks->counts = (unsigned long *)(chunks->ctxs + nb_workers);
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+
+    if (outputs == NULL || frames == NULL || tops == NULL ||
+        pids == NULL ||
+        chunks == MAP_FAILED ||
+        reader_split(reader, bounds, nb_workers) == -1 ||
+        pthread_barrier_init(&chunks->barrier, &attr, nb_workers) != 0)
+        goto end;
+    barrier = 1;
+
+    for (i = 0; i < nb_workers; i++)
+        if ((verbose != 0 && (outputs[i] = tmpfile()) == NULL) ||
+            (total->dump != NULL && (frames[i] = tmpfile()) == NULL) ||
+            (total->resolvers != NULL && total->resolvers->top != 0 &&
+             (tops[i] = tmpfile()) == NULL))
+            goto end;
+
+    // nothing buffered must be written twice by the children
+    fflush(stdout);
+
+    for (i = 0; i < nb_workers; i++) {
+
+        if ((pids[i] = fork()) == -1) {
+            // the children forked wait at the barrier for the others
+            error = errno;
+            while (--i >= 0) {
+                kill(pids[i], SIGKILL);
+                waitpid(pids[i], &status, 0);
+            }
+            errno = error;
+            goto end;
+        }
+
+        if (pids[i] == 0) {
+            analyze_chunk(reader, chunks, bounds, i, outputs[i],
+                          frames[i], tops[i], total, callback);
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    ret = 0;
+    for (i = 0; i < nb_workers; i++)
+        if (waitpid(pids[i], &status, 0) == -1 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != EXIT_SUCCESS)
+            ret = -1;
+
+    for (i = 0; i < nb_workers && ret == 0; i++)
+        if ((outputs[i] != NULL && copy_output(outputs[i]) == -1) ||
+            (frames[i] != NULL &&
+             dump_append(total->dump, frames[i]) == -1) ||
+            (tops[i] != NULL &&
+             resolver_load(total->resolvers, tops[i]) == -1))
+            ret = -1;
+
+    for (i = 0; i < nb_workers && ret == 0; i++)
+        merge_context(total, &chunks->ctxs[i]);
+
+end:
+    for (i = 0; i < nb_workers; i++)
+        if (outputs != NULL && outputs[i] != NULL)
+            fclose(outputs[i]);
+    for (i = 0; i < nb_workers; i++)
+        if (frames != NULL && frames[i] != NULL)
+            fclose(frames[i]);
+    for (i = 0; i < nb_workers; i++)
+        if (tops != NULL && tops[i] != NULL)
+            fclose(tops[i]);
+    if (barrier)
+        pthread_barrier_destroy(&chunks->barrier);
+    if (chunks != MAP_FAILED)
+        munmap(chunks, size);
+    pthread_barrierattr_destroy(&attr);
+    free(pids);
+    free(tops);
+    free(frames);
+    free(outputs);
+    free(bounds);
+
+    return ret;
+}
@@ -0,0 +1,157 @@
+#include "../include/writer.h"
+
+/**
+ * @brief Allocate one ring by thread producing text
+ * @return 0 on success, -1 on error with errno set
+ */
+int writer_open(writer_t *writer, int nb_rings, int policy) {
+
+    int i;
+
+    writer->nb_rings = nb_rings;
+    writer->stop = 0;
+    if ((writer->rings = calloc(nb_rings, sizeof(writer_ring_t))) ==
+        NULL)
+        return -1;
+
+    for (i = 0; i < nb_rings; i++) {
+        writer->rings[i].size = WRITER_RING_SIZE;
+        writer->rings[i].policy = policy;
+        if ((writer->rings[i].buf = malloc(WRITER_RING_SIZE)) == NULL) {
+            while (--i >= 0)
+                free(writer->rings[i].buf);
+            free(writer->rings);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Copy the text of a frame in the ring of the thread. When the
+ * ring is full, wait for the writer or drop the frame as asked.
+ * @return 0 if the text is queued, -1 if it is dropped
+ */
+int writer_push(writer_ring_t *ring, const char *data, size_t len) {
+
+    struct timespec wait = {0, WRITER_WAIT_NS};
+    size_t head = ring->head;
+
+    // larger than the ring, queued in pieces
+    while (len > ring->size) {
+        if (ring->policy == WRITER_DROP) {
+            ring->dropped++;
+            return -1;
+        }
+        writer_push(ring, data, ring->size);
+        data += ring->size;
+        len -= ring->size;
+        head = ring->head;
+    }
+
+    while (head + len -
+               __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >
+           ring->size) {
+        if (ring->policy == WRITER_DROP) {
+            ring->dropped++;
+            return -1;
+        }
+        nanosleep(&wait, NULL);
+    }
+
+    // the text may go around the end of the buffer
+    size_t start = head & (ring->size - 1);
+    size_t first = len < ring->size - start ? len : ring->size - start;
+    memcpy(ring->buf + start, data, first);
+    memcpy(ring->buf, data + first, len - first);
+
+    __atomic_store_n(&ring->head, head + len, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Write on stdout all the text queued in a ring
+ * @return number of bytes written
+ */
+size_t writer_drain(writer_ring_t *ring) {
+
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t tail = ring->tail;
+
+    if (head == tail)
+        return 0;
+
+    size_t start = tail & (ring->size - 1);
+    size_t len = head - tail;
+    size_t first = len < ring->size - start ? len : ring->size - start;
+
+    if (fwrite(ring->buf + start, 1, first, stdout) != first ||
+        fwrite(ring->buf, 1, len - first, stdout) != len - first)
+        perror("fwrite");
+
+    __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+    return len;
+}
+
+/**
+ * @brief Write the rings in turn until writer_close is called and
+ * they are all empty
+ */
+void *writer_routine(void *args) {
+
+    writer_t *writer = (writer_t *)args;
+    struct timespec idle = {0, WRITER_IDLE_NS};
+    size_t written;
+    int i, stop;
+
+    while (1) {
+
+        stop = __atomic_load_n(&writer->stop, __ATOMIC_ACQUIRE);
+
+        written = 0;
+        for (i = 0; i < writer->nb_rings; i++)
+            written += writer_drain(&writer->rings[i]);
+
+        if (written == 0) {
+            if (stop)
+                break;
+            fflush(stdout);
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    fflush(stdout);
+    return NULL;
+}
+
+/**
+ * @return 0 on success, an error number otherwise
+ */
+int writer_start(writer_t *writer) {
+
+    return pthread_create(&writer->thread, NULL, writer_routine,
+                          writer);
+}
+
+/**
+ * @brief Wait for the writer to empty the rings and release them. The
+ * threads filling the rings must be done.
+ * @return number of frames dropped
+ */
+unsigned long writer_close(writer_t *writer) {
+
+    unsigned long dropped = 0;
+    int i;
+
+    __atomic_store_n(&writer->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(writer->thread, NULL);
+
+    for (i = 0; i < writer->nb_rings; i++) {
+        dropped += writer->rings[i].dropped;
+        free(writer->rings[i].buf);
+    }
+    free(writer->rings);
+
+    return dropped;
+}
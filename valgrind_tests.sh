@@ -5,5 +5,7 @@ for file in assets/*
 do
     printf "\e[33mTesting $file\e[0m\n"
     valgrind ./bin/exe -o $file -v 0
+    # the TCP streams are only reassembled from verbose level 1
+    valgrind ./bin/exe -o $file -v 1 > /dev/null
 done 
 